@@ -0,0 +1,538 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A decoder for the Mode S messages that aircraft transponders
+ * send at 1090 MHz, including the ADS-B messages with their identification,
+ * position and velocity.
+ */
+
+/**
+ * A class to find and decode Mode S messages in the tuner's samples.
+ *
+ * The samples must come at 2 Msps, so each half-microsecond chip of the
+ * pulse position modulation is one sample. The magnitude of each sample is
+ * looked up in a table indexed by its I and Q bytes; every sample is then
+ * checked for the shape of the preamble, rejecting most of them after one
+ * or two comparisons. The bits after a preamble are sliced by comparing the
+ * two chips of each bit, and the message is kept if its parity is right,
+ * after fixing a wrong bit if there is one.
+ * @param {number} sampleRate The sample rate, which should be 2000000.
+ * @constructor
+ */
+function AdsbDecoder(sampleRate) {
+  var PREAMBLE_SAMPLES = 16;
+  var LONG_BITS = 112;
+  var SHORT_BITS = 56;
+  var MESSAGE_SAMPLES = PREAMBLE_SAMPLES + 2 * LONG_BITS;
+  var CRC_POLY = 0xfff409;
+  // The scale of the magnitudes: full scale is about 65000.
+  var MAG_SCALE = 360;
+  var CALLSIGN_CHARS =
+      '#ABCDEFGHIJKLMNOPQRSTUVWXYZ##### ###############0123456789######';
+  // How long an aircraft is remembered after its last message, in seconds.
+  var AIRCRAFT_TIMEOUT = 60;
+  // How far apart the even and odd positions can be to be combined.
+  var CPR_MAX_SECONDS = 10;
+
+  // Indexed by the I and Q bytes of a sample read as a little-endian
+  // 16-bit number, the way a Uint16Array sees them on every platform that
+  // runs the app.
+  var magnitudes = new Uint16Array(65536);
+  for (var q = 0; q < 256; ++q) {
+    for (var i = 0; i < 256; ++i) {
+      var dI = i - 127.5;
+      var dQ = q - 127.5;
+      magnitudes[(q << 8) | i] =
+          Math.round(Math.sqrt(dI * dI + dQ * dQ) * MAG_SCALE);
+    }
+  }
+
+  var crcTable = new Int32Array(256);
+  for (var b = 0; b < 256; ++b) {
+    var c = b << 16;
+    for (var k = 0; k < 8; ++k) {
+      c = (c & 0x800000) ? (c << 1) ^ CRC_POLY : c << 1;
+    }
+    crcTable[b] = c & 0xffffff;
+  }
+
+  // The syndrome of a message with one wrong bit, for every position of
+  // the bit counted from the end of the message.
+  var errorPositions = {};
+  var bytes = new Uint8Array(LONG_BITS / 8);
+  for (var pos = 0; pos < LONG_BITS; ++pos) {
+    bytes.fill(0);
+    var bit = LONG_BITS - 1 - pos;
+    bytes[bit >> 3] = 0x80 >> (bit & 7);
+    errorPositions[getSyndrome(bytes, LONG_BITS)] = pos;
+  }
+
+  var mag = new Uint16Array(0);
+  var carried = 0;
+  var sampleCount = 0;
+  var aircraft = {};
+  var aircraftCount = 0;
+
+  /**
+   * Finds the messages in a block of the tuner's samples.
+   * @param {ArrayBuffer} buffer The samples, as pairs of I and Q bytes.
+   * @return {Array.<Object>} The decoded messages.
+   */
+  function processRaw(buffer) {
+    var raw = new Uint16Array(buffer);
+    var m = prepare(raw.length);
+    for (var i = 0; i < raw.length; ++i) {
+      m[carried + i] = magnitudes[raw[i]];
+    }
+    return detect(carried + raw.length);
+  }
+
+  /**
+   * Finds the messages in a block of I/Q samples.
+   * @param {Float32Array} samplesI The I components of the samples.
+   * @param {Float32Array} samplesQ The Q components of the samples.
+   * @return {Array.<Object>} The decoded messages.
+   */
+  function process(samplesI, samplesQ) {
+    var m = prepare(samplesI.length);
+    var scale = 127.5 * MAG_SCALE;
+    for (var i = 0; i < samplesI.length; ++i) {
+      var vI = samplesI[i];
+      var vQ = samplesQ[i];
+      m[carried + i] = Math.min(65535, Math.sqrt(vI * vI + vQ * vQ) * scale);
+    }
+    return detect(carried + samplesI.length);
+  }
+
+  /**
+   * Makes room for a block's magnitudes after the ones carried over from
+   * the previous block. The buffer is only reallocated when the blocks get
+   * longer, so memory use stays constant.
+   * @param {number} length The number of samples in the block.
+   * @return {Uint16Array} The buffer for the magnitudes.
+   */
+  function prepare(length) {
+    if (mag.length < carried + length) {
+      var newMag = new Uint16Array(carried + length);
+      newMag.set(mag.subarray(0, carried));
+      mag = newMag;
+    }
+    return mag;
+  }
+
+  /**
+   * Looks for messages in the magnitudes. A message that doesn't fit in
+   * the block is looked for again with the next block, so the samples from
+   * its start are carried over.
+   * @param {number} length The number of magnitudes in the buffer.
+   * @return {Array.<Object>} The decoded messages.
+   */
+  function detect(length) {
+    var m = mag;
+    var messages = [];
+    var end = length - MESSAGE_SAMPLES;
+    var j = 0;
+    for (; j < end; ++j) {
+      // The preamble has pulses at chips 0, 2, 7 and 9. Most samples fail
+      // the first two comparisons.
+      var m0 = m[j];
+      var m1 = m[j + 1];
+      if (m0 <= m1) {
+        continue;
+      }
+      var m2 = m[j + 2];
+      if (m1 >= m2) {
+        continue;
+      }
+      var m3 = m[j + 3];
+      var m6 = m[j + 6];
+      var m7 = m[j + 7];
+      var m8 = m[j + 8];
+      var m9 = m[j + 9];
+      if (m2 <= m3 || m3 >= m0 || m[j + 4] >= m0 || m[j + 5] >= m0 ||
+          m6 >= m0 || m7 <= m8 || m8 >= m9 || m9 <= m6) {
+        continue;
+      }
+      var high = (m0 + m2 + m7 + m9) / 6;
+      if (m[j + 4] >= high || m[j + 5] >= high || m[j + 11] >= high ||
+          m[j + 12] >= high || m[j + 13] >= high || m[j + 14] >= high) {
+        continue;
+      }
+      var msg = decodeMessage(m, j + PREAMBLE_SAMPLES);
+      if (msg) {
+        messages.push(msg);
+        j += PREAMBLE_SAMPLES + 2 * msg.bits - 1;
+      }
+    }
+    j = Math.min(j, length);
+    sampleCount += j;
+    m.copyWithin(0, j, length);
+    carried = length - j;
+    return messages;
+  }
+
+  /**
+   * Slices the bits of a message, checks its parity and decodes it.
+   * @param {Uint16Array} m The magnitudes.
+   * @param {number} start The position of the message's first chip.
+   * @return {Object} The decoded message, or null if there isn't a valid
+   *     message there.
+   */
+  function decodeMessage(m, start) {
+    for (var i = 0; i < bytes.length; ++i) {
+      var value = 0;
+      for (var k = 0; k < 8; ++k) {
+        var p = start + 16 * i + 2 * k;
+        value = (value << 1) | (m[p] > m[p + 1] ? 1 : 0);
+      }
+      bytes[i] = value;
+    }
+    var df = bytes[0] >> 3;
+    var bits;
+    switch (df) {
+      case 0: case 4: case 5: case 11:
+        bits = SHORT_BITS;
+        break;
+      case 16: case 17: case 18: case 20: case 21: case 24:
+        bits = LONG_BITS;
+        break;
+      default:
+        return null;
+    }
+    var syndrome = getSyndrome(bytes, bits);
+    var corrected = false;
+    var icao;
+    if (df == 17 || df == 18) {
+      if (syndrome != 0) {
+        // Bits in the DF field aren't fixed: a different DF would have
+        // been sliced to a different length.
+        var pos = errorPositions[syndrome];
+        if (pos == null || pos >= bits - 5) {
+          return null;
+        }
+        var bit = bits - 1 - pos;
+        bytes[bit >> 3] ^= 0x80 >> (bit & 7);
+        corrected = true;
+      }
+      icao = (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+      rememberAircraft(icao);
+    } else if (df == 11) {
+      // The parity may be overlaid with an interrogator's code.
+      if (syndrome & ~0x7f) {
+        return null;
+      }
+      icao = (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+      rememberAircraft(icao);
+    } else {
+      // The parity is overlaid with the aircraft's address, so only
+      // addresses that have been seen in other messages are believed.
+      icao = syndrome;
+      if (!isKnownAircraft(icao)) {
+        return null;
+      }
+    }
+    return parseMessage(df, bits, icao, corrected);
+  }
+
+  /**
+   * Computes the parity of a message and returns how it differs from the
+   * parity in the message.
+   * @param {Uint8Array} data The message's bytes.
+   * @param {number} bits The length of the message in bits.
+   * @return {number} The syndrome, which is 0 if the parity is right.
+   */
+  function getSyndrome(data, bits) {
+    var n = bits / 8 - 3;
+    var c = 0;
+    for (var i = 0; i < n; ++i) {
+      c = ((c << 8) & 0xffffff) ^ crcTable[((c >> 16) ^ data[i]) & 0xff];
+    }
+    return c ^ ((data[n] << 16) | (data[n + 1] << 8) | data[n + 2]);
+  }
+
+  /**
+   * Remembers that an aircraft has been heard, forgetting the ones that
+   * haven't been heard from in a while.
+   * @param {number} icao The aircraft's address.
+   */
+  function rememberAircraft(icao) {
+    var now = sampleCount / sampleRate;
+    if (!aircraft[icao]) {
+      if (++aircraftCount % 100 == 0) {
+        for (var key in aircraft) {
+          if (now - aircraft[key].seen > AIRCRAFT_TIMEOUT) {
+            delete aircraft[key];
+          }
+        }
+      }
+      aircraft[icao] = {seen: now, cpr: [null, null]};
+    }
+    aircraft[icao].seen = now;
+  }
+
+  /**
+   * Returns whether an aircraft has been heard recently.
+   * @param {number} icao The aircraft's address.
+   * @return {boolean} Whether it was heard.
+   */
+  function isKnownAircraft(icao) {
+    var entry = aircraft[icao];
+    return !!entry && sampleCount / sampleRate - entry.seen <= AIRCRAFT_TIMEOUT;
+  }
+
+  /**
+   * Decodes the contents of a message with a valid parity.
+   * @param {number} df The downlink format.
+   * @param {number} bits The length of the message.
+   * @param {number} icao The aircraft's address.
+   * @param {boolean} corrected Whether a bit was fixed.
+   * @return {Object} The message.
+   */
+  function parseMessage(df, bits, icao, corrected) {
+    var hex = '';
+    for (var i = 0; i < bits / 8; ++i) {
+      hex += (bytes[i] < 16 ? '0' : '') + bytes[i].toString(16);
+    }
+    var msg = {
+      type: 'ADS-B',
+      df: df,
+      bits: bits,
+      icao: ('00000' + icao.toString(16)).slice(-6).toUpperCase(),
+      hex: hex.toUpperCase(),
+      corrected: corrected
+    };
+    var details = [];
+    if (df == 4 || df == 20) {
+      msg.altitude = getAltitude13(getBits(20, 13));
+      details.push(formatAltitude(msg.altitude));
+    } else if (df == 5 || df == 21) {
+      msg.squawk = getSquawk(getBits(20, 13));
+      details.push('squawk ' + msg.squawk);
+    } else if (df == 17 || df == 18) {
+      var tc = getBits(33, 5);
+      msg.typeCode = tc;
+      if (tc >= 1 && tc <= 4) {
+        var callsign = '';
+        for (var i = 0; i < 8; ++i) {
+          callsign += CALLSIGN_CHARS[getBits(41 + 6 * i, 6)];
+        }
+        msg.callsign = callsign.replace(/[# ]+$/, '');
+        details.push(msg.callsign);
+      } else if (tc >= 9 && tc <= 18) {
+        msg.altitude = getAltitude12(getBits(41, 12));
+        details.push(formatAltitude(msg.altitude));
+        var position = decodePosition(icao, getBits(54, 1), getBits(55, 17),
+                                      getBits(72, 17));
+        if (position) {
+          msg.lat = position.lat;
+          msg.lon = position.lon;
+          details.push(msg.lat.toFixed(4) + ' ' + msg.lon.toFixed(4));
+        }
+      } else if (tc == 19) {
+        decodeVelocity(msg);
+        if (msg.speed != null) {
+          details.push(Math.round(msg.speed) + ' kt');
+        }
+        if (msg.heading != null) {
+          details.push(Math.round(msg.heading) + '°');
+        }
+        if (msg.verticalRate != null) {
+          details.push(msg.verticalRate + ' ft/min');
+        }
+      }
+    }
+    msg.text = [msg.icao].concat(details).join(' ');
+    return msg;
+  }
+
+  /**
+   * Returns some bits of the current message.
+   * @param {number} first The first bit, counting from 1 like the Mode S
+   *     specification does.
+   * @param {number} count The number of bits.
+   * @return {number} The bits' value.
+   */
+  function getBits(first, count) {
+    var value = 0;
+    for (var i = first - 1; i < first - 1 + count; ++i) {
+      value = (value << 1) | ((bytes[i >> 3] >> (7 - (i & 7))) & 1);
+    }
+    return value;
+  }
+
+  /**
+   * Decodes the 12-bit altitude field of an airborne position message.
+   * @param {number} field The field's value.
+   * @return {?number} The altitude in feet, or null if it's in Gillham code
+   *     or unavailable.
+   */
+  function getAltitude12(field) {
+    if (!(field & 0x10)) {
+      return null;
+    }
+    return (((field & 0xfe0) >> 1) | (field & 0x0f)) * 25 - 1000;
+  }
+
+  /**
+   * Decodes the 13-bit altitude field of a surveillance reply.
+   * @param {number} field The field's value.
+   * @return {?number} The altitude in feet, or null if it's in Gillham code,
+   *     metric, or unavailable.
+   */
+  function getAltitude13(field) {
+    if ((field & 0x40) || !(field & 0x10)) {
+      return null;
+    }
+    return (((field & 0x1f80) >> 2) | ((field & 0x20) >> 1) |
+            (field & 0x0f)) * 25 - 1000;
+  }
+
+  /**
+   * Formats an altitude for a message's summary.
+   * @param {?number} altitude The altitude in feet, or null.
+   * @return {string} The formatted altitude.
+   */
+  function formatAltitude(altitude) {
+    return altitude == null ? 'alt ?' : 'alt ' + altitude + ' ft';
+  }
+
+  /**
+   * Decodes the identity field of a surveillance reply, whose bits are
+   * C1 A1 C2 A2 C4 A4 X B1 D1 B2 D2 B4 D4.
+   * @param {number} field The field's value.
+   * @return {string} The four digits of the squawk code.
+   */
+  function getSquawk(field) {
+    function digit(b1, b2, b4) {
+      return ((field >> b1) & 1) | (((field >> b2) & 1) << 1) |
+             (((field >> b4) & 1) << 2);
+    }
+    return '' + digit(11, 9, 7) + digit(5, 3, 1) + digit(12, 10, 8) +
+           digit(4, 2, 0);
+  }
+
+  /**
+   * Decodes an airborne velocity message into the message object.
+   * @param {Object} msg The message, which gets speed (knots), heading
+   *     (degrees) and verticalRate (feet per minute) fields when available.
+   */
+  function decodeVelocity(msg) {
+    var subtype = getBits(38, 3);
+    var factor = subtype == 2 || subtype == 4 ? 4 : 1;
+    if (subtype == 1 || subtype == 2) {
+      var ew = getBits(47, 10);
+      var ns = getBits(58, 10);
+      if (ew && ns) {
+        var vx = (ew - 1) * factor * (getBits(46, 1) ? -1 : 1);
+        var vy = (ns - 1) * factor * (getBits(57, 1) ? -1 : 1);
+        msg.speed = Math.sqrt(vx * vx + vy * vy);
+        msg.heading = (Math.atan2(vx, vy) * 180 / Math.PI + 360) % 360;
+      }
+    } else if (subtype == 3 || subtype == 4) {
+      if (getBits(46, 1)) {
+        msg.heading = getBits(47, 10) * 360 / 1024;
+      }
+      var airspeed = getBits(58, 10);
+      if (airspeed) {
+        msg.speed = (airspeed - 1) * factor;
+      }
+    }
+    var rate = getBits(70, 9);
+    if (rate) {
+      msg.verticalRate = (rate - 1) * 64 * (getBits(69, 1) ? -1 : 1);
+    }
+  }
+
+  /**
+   * Decodes an aircraft's position from the last even and odd positions it
+   * sent, using the globally unambiguous CPR decoding.
+   * @param {number} icao The aircraft's address.
+   * @param {number} odd 1 for an odd position, 0 for an even one.
+   * @param {number} lat The encoded latitude.
+   * @param {number} lon The encoded longitude.
+   * @return {?{lat:number,lon:number}} The position in degrees, or null if
+   *     there isn't a recent position of the other kind.
+   */
+  function decodePosition(icao, odd, lat, lon) {
+    var now = sampleCount / sampleRate;
+    var cpr = aircraft[icao].cpr;
+    cpr[odd] = {time: now, lat: lat, lon: lon};
+    var other = cpr[1 - odd];
+    if (!other || now - other.time > CPR_MAX_SECONDS) {
+      return null;
+    }
+    var latE = cpr[0].lat / 131072;
+    var lonE = cpr[0].lon / 131072;
+    var latO = cpr[1].lat / 131072;
+    var lonO = cpr[1].lon / 131072;
+    var j = Math.floor(59 * latE - 60 * latO + 0.5);
+    var rlatE = 360 / 60 * (mod(j, 60) + latE);
+    var rlatO = 360 / 59 * (mod(j, 59) + latO);
+    if (rlatE >= 270) {
+      rlatE -= 360;
+    }
+    if (rlatO >= 270) {
+      rlatO -= 360;
+    }
+    var nl = getNL(rlatE);
+    if (nl != getNL(rlatO)) {
+      return null;
+    }
+    var m = Math.floor(lonE * (nl - 1) - lonO * nl + 0.5);
+    var rlat = odd ? rlatO : rlatE;
+    var ni = Math.max(odd ? nl - 1 : nl, 1);
+    var rlon = 360 / ni * (mod(m, ni) + (odd ? lonO : lonE));
+    if (rlon >= 180) {
+      rlon -= 360;
+    }
+    return {lat: rlat, lon: rlon};
+  }
+
+  /**
+   * Returns the number of longitude zones at a latitude.
+   * @param {number} lat The latitude in degrees.
+   * @return {number} The number of zones.
+   */
+  function getNL(lat) {
+    lat = Math.abs(lat);
+    if (lat < 1e-9) {
+      return 59;
+    }
+    if (lat > 87) {
+      return 1;
+    }
+    if (lat == 87) {
+      return 2;
+    }
+    var c = Math.cos(Math.PI / 180 * lat);
+    return Math.floor(2 * Math.PI / Math.acos(
+        1 - (1 - Math.cos(Math.PI / 30)) / (c * c)));
+  }
+
+  /**
+   * Returns the positive remainder of a division.
+   * @param {number} a The dividend.
+   * @param {number} b The divisor.
+   * @return {number} The remainder, between 0 and b.
+   */
+  function mod(a, b) {
+    return ((a % b) + b) % b;
+  }
+
+  return {
+    process: process,
+    processRaw: processRaw
+  };
+}
@@ -0,0 +1,204 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A decoder for the AIS messages that ships send as 9600 bps
+ * GMSK on two marine VHF channels.
+ */
+
+/**
+ * A class to decode AIS messages in the demodulated signal of the AIS
+ * channels.
+ *
+ * Each channel has its own receiver, which recovers the bit clock from the
+ * signal's crossings of the midpoint between its highest and lowest recent
+ * bits, interpolating where each crossing and each bit's middle fall
+ * between samples, since there are only a few samples per bit. The midpoint
+ * follows the transmitter's frequency error within the training sequence
+ * that comes before every message. The bits are NRZI decoded and deframed
+ * by an HdlcDeframer, and the frames with a good checksum are output as the
+ * NMEA sentences that chart plotters and other AIS software read.
+ * @param {number} sampleRate The sample rate of the demodulated signal,
+ *     where the frequency deviation of the GMSK signal is 1.
+ * @constructor
+ */
+function AisDecoder(sampleRate) {
+  var BAUD = 9600;
+  var CLOCK_STEP = BAUD / sampleRate;
+  var CLOCK_GAIN = 0.15;
+  // With NRZI, the level changes at least after the six ones of a flag,
+  // so both levels are always among the last few bits.
+  var LEVEL_BITS = 12;
+  var MID_WEIGHT = 0.2;
+  // The shortest messages have 72 bits, and the longest ones take 5 slots.
+  var MIN_FRAME = 11;
+  var MAX_FRAME = 128;
+  var MAX_MESSAGE_TYPE = 27;
+  // NMEA sentences can't be longer than 82 characters.
+  var MAX_SENTENCE_CHARS = 60;
+
+  var receivers = {};
+  var sequenceId = 0;
+  var messages = [];
+
+  /**
+   * Decodes the messages in a block of a channel's demodulated signal.
+   * @param {Float32Array} samples The demodulated signal.
+   * @param {string} channel The channel's name, A or B.
+   * @return {Array.<Object>} The messages that ended in this block.
+   */
+  function process(samples, channel) {
+    messages = [];
+    var rx = receivers[channel];
+    if (!rx) {
+      rx = receivers[channel] = {
+        channel: channel,
+        clock: 0,
+        last: 0,
+        values: new Float32Array(LEVEL_BITS),
+        valuePos: 0,
+        mid: 0,
+        level: 0,
+        deframer: new HdlcDeframer(MIN_FRAME, MAX_FRAME,
+            function(frame, length) {
+              receiveFrame(channel, frame, length);
+            })
+      };
+    }
+    receiveSamples(rx, samples);
+    return messages;
+  }
+
+  /**
+   * Recovers the bits from a channel's signal. The clock is nudged so the
+   * signal crosses the midpoint when the clock wraps around, and the
+   * signal is sampled when the clock is halfway.
+   * @param {Object} rx The receiver's state.
+   * @param {Float32Array} samples The demodulated signal.
+   */
+  function receiveSamples(rx, samples) {
+    var clock = rx.clock;
+    var last = rx.last;
+    var mid = rx.mid;
+    for (var i = 0; i < samples.length; ++i) {
+      var sample = samples[i];
+      var next = clock + CLOCK_STEP;
+      if (clock < 0.5 && next >= 0.5) {
+        var value = last + (sample - last) * (0.5 - clock) / CLOCK_STEP;
+        var level = value > mid ? 1 : 0;
+        rx.values[rx.valuePos] = value;
+        rx.valuePos = (rx.valuePos + 1) % LEVEL_BITS;
+        var high = -Infinity;
+        var low = Infinity;
+        for (var j = 0; j < LEVEL_BITS; ++j) {
+          high = Math.max(high, rx.values[j]);
+          low = Math.min(low, rx.values[j]);
+        }
+        mid += ((high + low) / 2 - mid) * MID_WEIGHT;
+        rx.deframer.receiveBit(level == rx.level ? 1 : 0);
+        rx.level = level;
+      }
+      clock = next >= 1 ? next - 1 : next;
+      if ((sample > mid) != (last > mid)) {
+        var crossing = clock - CLOCK_STEP * (sample - mid) / (sample - last);
+        if (crossing >= 0.5) {
+          crossing -= 1;
+        }
+        clock -= crossing * CLOCK_GAIN;
+        clock = clock < 0 ? clock + 1 : clock >= 1 ? clock - 1 : clock;
+      }
+      last = sample;
+    }
+    rx.mid = mid;
+    rx.clock = clock;
+    rx.last = last;
+  }
+
+  /**
+   * Adds the message in a frame with a good checksum to the messages.
+   * @param {string} channel The channel's name.
+   * @param {Uint8Array} frame The buffer containing the frame.
+   * @param {number} length The frame's length, including its checksum.
+   */
+  function receiveFrame(channel, frame, length) {
+    var bits = (length - 2) * 8;
+    var msgType = readBits(frame, 0, 6);
+    if (msgType == 0 || msgType > MAX_MESSAGE_TYPE) {
+      return;
+    }
+    var payload = '';
+    for (var pos = 0; pos < bits; pos += 6) {
+      var value = readBits(frame, pos, Math.min(6, bits - pos)) <<
+                  Math.max(0, pos + 6 - bits);
+      payload += String.fromCharCode(value + (value < 40 ? 48 : 56));
+    }
+    var fillBits = payload.length * 6 - bits;
+    var count = Math.ceil(payload.length / MAX_SENTENCE_CHARS);
+    var id = '';
+    if (count > 1) {
+      id = String(sequenceId);
+      sequenceId = (sequenceId + 1) % 10;
+    }
+    var sentences = [];
+    for (var i = 0; i < count; ++i) {
+      sentences.push(makeSentence([
+          'AIVDM', count, i + 1, id, channel,
+          payload.substr(i * MAX_SENTENCE_CHARS, MAX_SENTENCE_CHARS),
+          i == count - 1 ? fillBits : 0]));
+    }
+    messages.push({
+      type: 'AIS',
+      channel: channel,
+      msgType: msgType,
+      mmsi: readBits(frame, 8, 30),
+      sentences: sentences,
+      text: sentences.join('\n')
+    });
+  }
+
+  /**
+   * Reads a field of a message. The bytes are sent least significant bit
+   * first, but the fields start at each byte's most significant bit.
+   * @param {Uint8Array} frame The buffer containing the message.
+   * @param {number} pos The position of the field's first bit.
+   * @param {number} length The number of bits in the field, up to 30.
+   * @return {number} The field's value.
+   */
+  function readBits(frame, pos, length) {
+    var value = 0;
+    for (var i = pos; i < pos + length; ++i) {
+      value = (value << 1) | ((frame[i >> 3] >> (7 - (i & 7))) & 1);
+    }
+    return value;
+  }
+
+  /**
+   * Makes an NMEA sentence out of its fields, adding its checksum.
+   * @param {Array.<*>} fields The fields.
+   * @return {string} The sentence.
+   */
+  function makeSentence(fields) {
+    var body = fields.join(',');
+    var checksum = 0;
+    for (var i = 0; i < body.length; ++i) {
+      checksum ^= body.charCodeAt(i);
+    }
+    return '!' + body + '*' + (checksum < 16 ? '0' : '') +
+           checksum.toString(16).toUpperCase();
+  }
+
+  return {
+    process: process
+  };
+}
@@ -14,9 +14,17 @@
 
 /**
  * Application configuration.
+ *
+ * Every tuner has its own configuration, so that each one can have its own
+ * frequency correction, gain, etc. A tuner that doesn't have a
+ * configuration yet starts with a copy of the first tuner's configuration.
+ * @param {number=} opt_deviceIndex The tuner's index, 0 by default.
  * @constructor
  */
-function AppConfig() {
+function AppConfig(opt_deviceIndex) {
+
+  var storageKey = opt_deviceIndex ? 'AppConfig-' + opt_deviceIndex
+                                   : 'AppConfig';
 
   var config = {
     version: 1,
@@ -37,7 +45,33 @@ function AppConfig() {
         frequency: 125000000
       },
       /** Whether free tuning is enabled. */
-      freeTuning: false
+      freeTuning: false,
+      /** Whether to tune the tuner away from the station, to avoid its DC spike. */
+      offsetTuning: false,
+      /** Whether to track and correct the tuner's frequency drift. */
+      driftTracking: false,
+      /** Whether to decode and show the RDS information of FM stations. */
+      rds: true,
+      /** Whether to decode the APRS packets sent in narrowband FM. */
+      aprs: false,
+      /** Whether to decode the POCSAG pages sent in narrowband FM. */
+      pocsag: false,
+      /** Where the samples come from: 'usb', 'rtltcp' or 'simulator'. */
+      tunerSource: {
+        type: 'usb',
+        address: 'localhost:1234',
+        stations: DEFAULT_SIMULATED_STATIONS
+      },
+      /** Sharing the tuner on the network with the rtl_tcp protocol. */
+      sharing: {
+        enable: false,
+        port: 1234
+      },
+      /** How much of the radio's output to keep for replaying. */
+      timeShift: {
+        minutes: 5,
+        iqMegabytes: 0
+      }
     },
     /** Current state. */
     state: {
@@ -110,6 +144,105 @@ function AppConfig() {
     config.settings.freeTuning = !!enabled;
   }
 
+  function isOffsetTuningEnabled() {
+    return config.settings.offsetTuning;
+  }
+
+  function enableOffsetTuning(enabled) {
+    config.settings.offsetTuning = !!enabled;
+  }
+
+  function isDriftTrackingEnabled() {
+    return config.settings.driftTracking;
+  }
+
+  function enableDriftTracking(enabled) {
+    config.settings.driftTracking = !!enabled;
+  }
+
+  function isRdsEnabled() {
+    return config.settings.rds;
+  }
+
+  function enableRds(enabled) {
+    config.settings.rds = !!enabled;
+  }
+
+  function isAprsEnabled() {
+    return config.settings.aprs;
+  }
+
+  function enableAprs(enabled) {
+    config.settings.aprs = !!enabled;
+  }
+
+  function isPocsagEnabled() {
+    return config.settings.pocsag;
+  }
+
+  function enablePocsag(enabled) {
+    config.settings.pocsag = !!enabled;
+  }
+
+  function getTunerSourceType() {
+    return config.settings.tunerSource.type;
+  }
+
+  function setTunerSourceType(type) {
+    config.settings.tunerSource.type =
+        type == 'rtltcp' || type == 'simulator' ? type : 'usb';
+  }
+
+  function getTunerSourceAddress() {
+    return config.settings.tunerSource.address;
+  }
+
+  function setTunerSourceAddress(address) {
+    config.settings.tunerSource.address = String(address || '');
+  }
+
+  function getSimulatedStations() {
+    return config.settings.tunerSource.stations;
+  }
+
+  function setSimulatedStations(stations) {
+    config.settings.tunerSource.stations =
+        String(stations || DEFAULT_SIMULATED_STATIONS);
+  }
+
+  function isSharingEnabled() {
+    return config.settings.sharing.enable;
+  }
+
+  function enableSharing(enabled) {
+    config.settings.sharing.enable = !!enabled;
+  }
+
+  function getSharingPort() {
+    return config.settings.sharing.port;
+  }
+
+  function setSharingPort(port) {
+    config.settings.sharing.port = Math.floor(Number(port)) || 1234;
+  }
+
+  function getTimeShiftMinutes() {
+    return config.settings.timeShift.minutes;
+  }
+
+  function setTimeShiftMinutes(minutes) {
+    config.settings.timeShift.minutes = Math.max(0, Number(minutes)) || 0;
+  }
+
+  function getIqTimeShiftMegabytes() {
+    return config.settings.timeShift.iqMegabytes;
+  }
+
+  function setIqTimeShiftMegabytes(megabytes) {
+    config.settings.timeShift.iqMegabytes =
+        Math.max(0, Number(megabytes)) || 0;
+  }
+
   function setGain(gain) {
     config.settings.gain.value = Math.max(0, gain) || 0;
   }
@@ -179,9 +312,9 @@ function AppConfig() {
   }
 
   function load(callback) {
-    chrome.storage.local.get('AppConfig', function(cfg) {
-      if (cfg['AppConfig']) {
-        var newCfg = cfg['AppConfig'];
+    chrome.storage.local.get([storageKey, 'AppConfig'], function(cfg) {
+      if (cfg[storageKey] || cfg['AppConfig']) {
+        var newCfg = cfg[storageKey] || cfg['AppConfig'];
         if (newCfg.version >= 1) {
           config.settings.region = newCfg.settings.region;
           config.settings.ppm = newCfg.settings.ppm;
@@ -192,6 +325,30 @@ function AppConfig() {
           config.settings.upconverter.frequency =
               newCfg.settings.upconverter.frequency;
           config.settings.freeTuning = newCfg.settings.freeTuning;
+          config.settings.offsetTuning = !!newCfg.settings.offsetTuning;
+          config.settings.driftTracking = !!newCfg.settings.driftTracking;
+          config.settings.rds = newCfg.settings.rds !== false;
+          config.settings.aprs = !!newCfg.settings.aprs;
+          config.settings.pocsag = !!newCfg.settings.pocsag;
+          if (newCfg.settings.tunerSource) {
+            config.settings.tunerSource.type =
+                newCfg.settings.tunerSource.type;
+            config.settings.tunerSource.address =
+                newCfg.settings.tunerSource.address;
+            config.settings.tunerSource.stations =
+                newCfg.settings.tunerSource.stations ||
+                DEFAULT_SIMULATED_STATIONS;
+          }
+          if (newCfg.settings.sharing) {
+            config.settings.sharing.enable = newCfg.settings.sharing.enable;
+            config.settings.sharing.port = newCfg.settings.sharing.port;
+          }
+          if (newCfg.settings.timeShift) {
+            config.settings.timeShift.minutes =
+                newCfg.settings.timeShift.minutes;
+            config.settings.timeShift.iqMegabytes =
+                newCfg.settings.timeShift.iqMegabytes;
+          }
           config.state.volume = newCfg.state.volume;
           config.state.bandName = newCfg.state.bandName;
           config.state.bandFrequencies = newCfg.state.bandFrequencies;
@@ -206,7 +363,9 @@ function AppConfig() {
   }
 
   function save() {
-    chrome.storage.local.set({'AppConfig': config});
+    var cfg = {};
+    cfg[storageKey] = config;
+    chrome.storage.local.set(cfg);
   }
 
   function loadLegacy(callback) {
@@ -275,6 +434,46 @@ function AppConfig() {
       freeTuning: {
         enable: enableFreeTuning,
         isEnabled: isFreeTuningEnabled
+      },
+      offsetTuning: {
+        enable: enableOffsetTuning,
+        isEnabled: isOffsetTuningEnabled
+      },
+      driftTracking: {
+        enable: enableDriftTracking,
+        isEnabled: isDriftTrackingEnabled
+      },
+      rds: {
+        enable: enableRds,
+        isEnabled: isRdsEnabled
+      },
+      aprs: {
+        enable: enableAprs,
+        isEnabled: isAprsEnabled
+      },
+      pocsag: {
+        enable: enablePocsag,
+        isEnabled: isPocsagEnabled
+      },
+      tunerSource: {
+        setType: setTunerSourceType,
+        getType: getTunerSourceType,
+        setAddress: setTunerSourceAddress,
+        getAddress: getTunerSourceAddress,
+        setStations: setSimulatedStations,
+        getStations: getSimulatedStations
+      },
+      sharing: {
+        enable: enableSharing,
+        isEnabled: isSharingEnabled,
+        setPort: setSharingPort,
+        getPort: getSharingPort
+      },
+      timeShift: {
+        setMinutes: setTimeShiftMinutes,
+        getMinutes: getTimeShiftMinutes,
+        setIqMegabytes: setIqTimeShiftMegabytes,
+        getIqMegabytes: getIqTimeShiftMegabytes
       }
     },
     state: {
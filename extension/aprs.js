@@ -0,0 +1,236 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A decoder for the AX.25 packets that APRS stations send
+ * as 1200 baud AFSK tones over narrowband FM.
+ */
+
+/**
+ * A class to decode APRS packets in demodulated narrowband FM audio.
+ *
+ * The audio is decimated to 12 kHz and correlated with the Bell 202 mark
+ * (1200 Hz) and space (2200 Hz) tones over one bit. The radio's emphasis
+ * often makes one tone much louder than the other, so several slicers
+ * compare the tones' energies with different weights. Each slicer has its
+ * own clock recovery, NRZI decoder and HdlcDeframer, and every frame with
+ * a good checksum counts as a vote; a frame is reported once, however many
+ * slicers decoded it.
+ * @param {number} sampleRate The sample rate of the audio.
+ * @param {Array.<number>=} opt_spaceGains The weight each slicer gives to
+ *     the space tone's energy. By default, three slicers are used.
+ * @constructor
+ */
+function AprsDecoder(sampleRate, opt_spaceGains) {
+  var BAUD = 1200;
+  var MARK_FREQ = 1200;
+  var SPACE_FREQ = 2200;
+  var DECIMATION = Math.max(1, Math.floor(sampleRate / 12000));
+  var LOW_RATE = sampleRate / DECIMATION;
+  var WINDOW = Math.round(LOW_RATE / BAUD);
+  var CLOCK_STEP = BAUD / LOW_RATE;
+  var CLOCK_GAIN = 0.4;
+  var SPACE_GAINS = opt_spaceGains || [0.5, 1, 2];
+  // Destination and source addresses, control field and checksum.
+  var MIN_FRAME = 17;
+  var MAX_FRAME = 332;
+  var DUPLICATE_TIME = 1;
+
+  var coefs = getLowPassFIRCoeffs(sampleRate, 2800, 4 * DECIMATION + 1);
+  var downsampler = new Downsampler(sampleRate, LOW_RATE, coefs);
+  var markStepCos = Math.cos(2 * Math.PI * MARK_FREQ / LOW_RATE);
+  var markStepSin = Math.sin(2 * Math.PI * MARK_FREQ / LOW_RATE);
+  var spaceStepCos = Math.cos(2 * Math.PI * SPACE_FREQ / LOW_RATE);
+  var spaceStepSin = Math.sin(2 * Math.PI * SPACE_FREQ / LOW_RATE);
+  var markCos = 1;
+  var markSin = 0;
+  var spaceCos = 1;
+  var spaceSin = 0;
+  // Each row holds the last WINDOW products for one of the correlations.
+  var products = [new Float64Array(WINDOW), new Float64Array(WINDOW),
+                  new Float64Array(WINDOW), new Float64Array(WINDOW)];
+  var markI = 0;
+  var markQ = 0;
+  var spaceI = 0;
+  var spaceQ = 0;
+  var windowPos = 0;
+
+  var slicers = [];
+  for (var i = 0; i < SPACE_GAINS.length; ++i) {
+    slicers.push({
+      spaceGain: SPACE_GAINS[i],
+      level: 0,
+      clock: 0,
+      lastLevel: 0,
+      deframer: new HdlcDeframer(MIN_FRAME, MAX_FRAME, receiveFrame)
+    });
+  }
+
+  var sampleCount = 0;
+  var recentFrames = [];
+  var messages = [];
+
+  /**
+   * Decodes the packets in a block of audio.
+   * @param {Float32Array} samples The demodulated audio.
+   * @return {Array.<Object>} The packets that ended in this block.
+   */
+  function process(samples) {
+    messages = [];
+    var low = downsampler.downsample(samples);
+    for (var i = 0; i < low.length; ++i) {
+      var sample = low[i];
+      var mI = sample * markCos;
+      var mQ = sample * markSin;
+      var sI = sample * spaceCos;
+      var sQ = sample * spaceSin;
+      markI += mI - products[0][windowPos];
+      markQ += mQ - products[1][windowPos];
+      spaceI += sI - products[2][windowPos];
+      spaceQ += sQ - products[3][windowPos];
+      products[0][windowPos] = mI;
+      products[1][windowPos] = mQ;
+      products[2][windowPos] = sI;
+      products[3][windowPos] = sQ;
+      if (++windowPos == WINDOW) {
+        windowPos = 0;
+      }
+      var nextCos = markCos * markStepCos - markSin * markStepSin;
+      markSin = markCos * markStepSin + markSin * markStepCos;
+      markCos = nextCos;
+      nextCos = spaceCos * spaceStepCos - spaceSin * spaceStepSin;
+      spaceSin = spaceCos * spaceStepSin + spaceSin * spaceStepCos;
+      spaceCos = nextCos;
+
+      var markEnergy = markI * markI + markQ * markQ;
+      var spaceEnergy = spaceI * spaceI + spaceQ * spaceQ;
+      for (var s = 0; s < slicers.length; ++s) {
+        var slicer = slicers[s];
+        receiveLevel(slicer,
+                     markEnergy > slicer.spaceGain * spaceEnergy ? 1 : 0);
+      }
+      ++sampleCount;
+    }
+    var mark = normalizeOscillator(markCos, markSin);
+    markCos = mark[0];
+    markSin = mark[1];
+    var space = normalizeOscillator(spaceCos, spaceSin);
+    spaceCos = space[0];
+    spaceSin = space[1];
+    return messages;
+  }
+
+  /**
+   * Recovers the bit clock from the level changes of a slicer's output,
+   * and decodes the NRZI bits in the middle of each bit period.
+   * @param {Object} slicer The slicer's state.
+   * @param {number} level The slicer's output: 1 for mark, 0 for space.
+   */
+  function receiveLevel(slicer, level) {
+    if (level != slicer.level) {
+      slicer.level = level;
+      slicer.clock += (0.5 - slicer.clock) * CLOCK_GAIN;
+    }
+    slicer.clock += CLOCK_STEP;
+    if (slicer.clock >= 1) {
+      slicer.clock -= 1;
+      slicer.deframer.receiveBit(level == slicer.lastLevel ? 1 : 0);
+      slicer.lastLevel = level;
+    }
+  }
+
+  /**
+   * Unless another slicer already decoded the same frame, parses a frame
+   * with a good checksum and adds it to the messages.
+   * @param {Uint8Array} frame The buffer containing the frame.
+   * @param {number} length The frame's length, including its checksum.
+   */
+  function receiveFrame(frame, length) {
+    var key = String.fromCharCode.apply(null, frame.subarray(0, length));
+    var oldest = sampleCount - DUPLICATE_TIME * LOW_RATE;
+    while (recentFrames.length > 0 && recentFrames[0].time < oldest) {
+      recentFrames.shift();
+    }
+    for (var i = 0; i < recentFrames.length; ++i) {
+      if (recentFrames[i].key == key) {
+        return;
+      }
+    }
+    recentFrames.push({key: key, time: sampleCount});
+    var packet = parseFrame(frame, length - 2);
+    if (packet) {
+      messages.push(packet);
+    }
+  }
+
+  /**
+   * Parses an AX.25 frame.
+   * @param {Uint8Array} frame The buffer containing the frame.
+   * @param {number} length The frame's length, without its checksum.
+   * @return {Object} The packet, or null if the frame is malformed.
+   */
+  function parseFrame(frame, length) {
+    var addresses = [];
+    var pos = 0;
+    do {
+      if (pos + 7 > length || addresses.length == 10) {
+        return null;
+      }
+      var call = '';
+      for (var i = 0; i < 6; ++i) {
+        var ch = frame[pos + i] >>> 1;
+        if (ch != 32) {
+          call += String.fromCharCode(ch);
+        }
+      }
+      var ssid = (frame[pos + 6] >>> 1) & 0xf;
+      if (ssid) {
+        call += '-' + ssid;
+      }
+      if (addresses.length >= 2 && frame[pos + 6] & 0x80) {
+        call += '*';
+      }
+      addresses.push(call);
+      pos += 7;
+    } while (!(frame[pos - 1] & 1));
+    if (addresses.length < 2 || pos >= length) {
+      return null;
+    }
+    var info = '';
+    // Only UI frames carry APRS information.
+    if ((frame[pos] & 0xef) == 0x03) {
+      for (var i = pos + 2; i < length; ++i) {
+        var ch = frame[i];
+        info += ch >= 32 && ch < 127 ? String.fromCharCode(ch) :
+                '<0x' + (ch < 16 ? '0' : '') + ch.toString(16) + '>';
+      }
+    }
+    var header = addresses[1] + '>' + addresses[0];
+    if (addresses.length > 2) {
+      header += ',' + addresses.slice(2).join(',');
+    }
+    return {
+      type: 'APRS',
+      source: addresses[1],
+      destination: addresses[0],
+      path: addresses.slice(2),
+      info: info,
+      text: header + ':' + info
+    };
+  }
+
+  return {
+    process: process
+  };
+}
@@ -0,0 +1,237 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A decoder for the images that NOAA weather satellites send
+ * with the Automatic Picture Transmission (APT) format.
+ */
+
+/**
+ * A class to decode APT images from the demodulated FM signal.
+ *
+ * The image is sent as the amplitude of a 2400 Hz subcarrier, at 4160
+ * words per second and 2080 words per line. The Doppler shift leaves an
+ * offset in the demodulated signal, which is removed before the subcarrier
+ * is mixed down to baseband; its envelope is then resampled at the word
+ * rate, filtering only where a word falls. Every line starts with a 1040 Hz
+ * synchronization burst, which is searched for over a whole line until it
+ * is found, and then only a few words around where the next one should be,
+ * to follow the satellite's clock. The shape of the correlation peak tells
+ * how far the words are from where they are sampled, and the sampling is
+ * moved so it falls in the middle of the words. The spaces after the
+ * bursts, black for the first image and white for the second one, give the
+ * black and white levels of the line.
+ * @param {number} sampleRate The sample rate of the demodulated signal.
+ * @constructor
+ */
+function AptDecoder(sampleRate) {
+  var SUBCARRIER_FREQ = 2400;
+  var WORD_RATE = 4160;
+  var LINE_WORDS = 2080;
+  var CHANNEL_WORDS = 1040;
+  var SYNC_A = '000011001100110011001100110011000000000';
+  var SPACE_WORDS = 47;
+  // The words at the edges of the spaces are blurred by the filters.
+  var SPACE_MARGIN = 8;
+  var MAX_SLIP = 8;
+  var MIN_SYNC_QUALITY = 0.5;
+  var LEVEL_WEIGHT = 0.1;
+  var TIMING_GAIN = 0.5;
+  var OFFSET_WEIGHT = 50 / sampleRate;
+  var WORD_STEP = sampleRate / WORD_RATE;
+
+  var filterI = new FIRFilter(
+      getLowPassFIRCoeffs(sampleRate, WORD_RATE / 2, 127));
+  var filterQ = new FIRFilter(
+      getLowPassFIRCoeffs(sampleRate, WORD_RATE / 2, 127));
+  var offset = 0;
+  var mixCos = 1;
+  var mixSin = 0;
+  var mixStepCos = Math.cos(2 * Math.PI * SUBCARRIER_FREQ / sampleRate);
+  var mixStepSin = Math.sin(2 * Math.PI * SUBCARRIER_FREQ / sampleRate);
+  var wordPos = 0;
+  var timingShift = 0;
+
+  // The synchronization burst, with its average taken out, so that it can
+  // be correlated with the words without removing their average first.
+  var syncWeights = new Float32Array(SYNC_A.length);
+  var syncOnes = SYNC_A.split('1').length - 1;
+  var syncNorm = 0;
+  for (var i = 0; i < SYNC_A.length; ++i) {
+    syncWeights[i] = (SYNC_A[i] == '1' ? 1 : 0) - syncOnes / SYNC_A.length;
+    syncNorm += syncWeights[i] * syncWeights[i];
+  }
+  syncNorm = Math.sqrt(syncNorm);
+
+  var words = new Float32Array(2 * LINE_WORDS);
+  var wordCount = 0;
+  var locked = false;
+  var black = 0;
+  var white = 0;
+  var lines = [];
+
+  /**
+   * Decodes a block of the demodulated signal.
+   * @param {Float32Array} samples The demodulated signal.
+   * @return {Array.<Uint8Array>} The image lines completed in this block,
+   *     2080 pixels each, from black (0) to white (255).
+   */
+  function process(samples) {
+    lines = [];
+    var mixedI = new Float32Array(samples.length);
+    var mixedQ = new Float32Array(samples.length);
+    var cos = mixCos;
+    var sin = mixSin;
+    for (var i = 0; i < samples.length; ++i) {
+      offset += (samples[i] - offset) * OFFSET_WEIGHT;
+      var sample = samples[i] - offset;
+      mixedI[i] = sample * cos;
+      mixedQ[i] = sample * sin;
+      var nextCos = cos * mixStepCos - sin * mixStepSin;
+      sin = cos * mixStepSin + sin * mixStepCos;
+      cos = nextCos;
+    }
+    var osc = normalizeOscillator(cos, sin);
+    mixCos = osc[0];
+    mixSin = osc[1];
+    filterI.loadSamples(mixedI);
+    filterQ.loadSamples(mixedQ);
+    var pos = Math.max(0, wordPos + timingShift);
+    timingShift = 0;
+    while (pos + 1 < samples.length) {
+      var index = Math.floor(pos);
+      var frac = pos - index;
+      var before = envelope(index);
+      receiveWord(before + (envelope(index + 1) - before) * frac);
+      pos += WORD_STEP;
+    }
+    wordPos = pos - samples.length;
+    return lines;
+  }
+
+  /**
+   * Returns the subcarrier's amplitude at a sample.
+   * @param {number} index The sample's index in the latest block.
+   * @return {number} The amplitude.
+   */
+  function envelope(index) {
+    var I = filterI.get(index);
+    var Q = filterQ.get(index);
+    return Math.sqrt(I * I + Q * Q);
+  }
+
+  /**
+   * Collects the words, and outputs a line when the words after its
+   * synchronization burst have arrived.
+   * @param {number} word The word's amplitude.
+   */
+  function receiveWord(word) {
+    words[wordCount++] = word;
+    var needed = locked ? LINE_WORDS + 2 * MAX_SLIP : 2 * LINE_WORDS;
+    if (wordCount < needed) {
+      return;
+    }
+    var last = locked ? 2 * MAX_SLIP : LINE_WORDS - 1;
+    var bestPos = 0;
+    var bestCorr = -Infinity;
+    for (var pos = 0; pos <= last; ++pos) {
+      var corr = correlateSync(pos);
+      if (corr > bestCorr) {
+        bestCorr = corr;
+        bestPos = pos;
+      }
+    }
+    locked = bestCorr / syncNorm / syncDeviation(bestPos) >= MIN_SYNC_QUALITY;
+    if (locked && bestPos > 0) {
+      var before = correlateSync(bestPos - 1);
+      var after = correlateSync(bestPos + 1);
+      var curvature = before - 2 * bestCorr + after;
+      if (curvature < 0) {
+        timingShift = TIMING_GAIN * WORD_STEP *
+            (before - after) / (2 * curvature);
+      }
+    }
+    if (locked) {
+      var spaceA = measureSpace(bestPos + SYNC_A.length);
+      var spaceB = measureSpace(bestPos + CHANNEL_WORDS + SYNC_A.length);
+      if (white <= black) {
+        black = spaceA;
+        white = spaceB;
+      } else {
+        black += (spaceA - black) * LEVEL_WEIGHT;
+        white += (spaceB - white) * LEVEL_WEIGHT;
+      }
+    }
+    var line = new Uint8Array(LINE_WORDS);
+    var scale = white > black ? 255 / (white - black) : 0;
+    for (var i = 0; i < LINE_WORDS; ++i) {
+      var value = (words[bestPos + i] - black) * scale;
+      line[i] = value < 0 ? 0 : value > 255 ? 255 : value;
+    }
+    lines.push(line);
+    // Keep the words so the next line is expected MAX_SLIP words in.
+    var used = bestPos + LINE_WORDS - MAX_SLIP;
+    words.copyWithin(0, used, wordCount);
+    wordCount -= used;
+  }
+
+  /**
+   * Correlates the words with the synchronization burst.
+   * @param {number} pos The position in the words where the burst would
+   *     start.
+   * @return {number} The correlation.
+   */
+  function correlateSync(pos) {
+    var corr = 0;
+    for (var i = 0; i < syncWeights.length; ++i) {
+      corr += syncWeights[i] * words[pos + i];
+    }
+    return corr;
+  }
+
+  /**
+   * Measures how much the words of a synchronization burst vary.
+   * @param {number} pos The position of the burst in the words.
+   * @return {number} The square root of the sum of the words' squared
+   *     deviations from their average.
+   */
+  function syncDeviation(pos) {
+    var sum = 0;
+    var sumSq = 0;
+    for (var i = 0; i < SYNC_A.length; ++i) {
+      var word = words[pos + i];
+      sum += word;
+      sumSq += word * word;
+    }
+    var mean = sum / SYNC_A.length;
+    return Math.sqrt(Math.max(0, sumSq - mean * sum)) || Infinity;
+  }
+
+  /**
+   * Measures the level of the middle of a space.
+   * @param {number} pos The position of the space in the words.
+   * @return {number} The average of the words.
+   */
+  function measureSpace(pos) {
+    var sum = 0;
+    for (var i = SPACE_MARGIN; i < SPACE_WORDS - SPACE_MARGIN; ++i) {
+      sum += words[pos + i];
+    }
+    return sum / (SPACE_WORDS - 2 * SPACE_MARGIN);
+  }
+
+  return {
+    process: process
+  };
+}
@@ -22,35 +22,60 @@ function Player() {
   var SQUELCH_TAIL = 0.3;
 
   var lastPlayedAt = -1;
+  var volume = 1;
+  var muted = false;
   var squelchTime = -2;
   var frameno = 0;
 
   var wavSaver = null;
 
+  var timeShift = null;
+  var replayPosition = 0;
+  var replayRemaining = 0;
+  var replayLeft = new Float32Array(OUT_RATE);
+  var replayRight = new Float32Array(OUT_RATE);
+
   var ac = new (window.AudioContext || window.webkitAudioContext)();
   var gainNode = ac.createGain ? ac.createGain() : ac.createGainNode();
   gainNode.connect(ac.destination);
 
   /**
    * Queues the given samples for playing at the appropriate time.
+   * If a replay is in progress, the samples are only added to the time
+   * shift buffer, and older samples from that buffer are played instead.
    * @param {Float32Array} leftSamples The samples for the left speaker.
    * @param {Float32Array} rightSamples The samples for the right speaker.
    * @param {number} level The radio signal's level.
    * @param {number} squelch The current squelch level.
    */
   function play(leftSamples, rightSamples, level, squelch) {
-    var buffer = ac.createBuffer(2, leftSamples.length, OUT_RATE);
+    var length = leftSamples.length;
+    var buffer = ac.createBuffer(2, length, OUT_RATE);
     if (level >= squelch) {
       squelchTime = null;
     } else if (squelchTime === null) {
       squelchTime = lastPlayedAt;
     }
-    if (squelchTime === null || lastPlayedAt - squelchTime < SQUELCH_TAIL) {
+    var audible =
+        squelchTime === null || lastPlayedAt - squelchTime < SQUELCH_TAIL;
+    if (audible && wavSaver != null) {
+      wavSaver.writeSamples(leftSamples, rightSamples);
+    }
+    if (timeShift) {
+      timeShift.write(audible ? leftSamples : null,
+                      audible ? rightSamples : null, length);
+    }
+    if (replayRemaining > 0 && length <= replayLeft.length) {
+      timeShift.read(replayPosition, replayLeft, replayRight, length);
+      leftSamples = replayLeft.subarray(0, length);
+      rightSamples = replayRight.subarray(0, length);
+      replayPosition += length;
+      replayRemaining -= length;
+      audible = true;
+    }
+    if (audible) {
       buffer.getChannelData(0).set(leftSamples);
       buffer.getChannelData(1).set(rightSamples);
-      if (wavSaver != null) {
-        wavSaver.writeSamples(leftSamples, rightSamples);
-      }
     }
     var source = ac.createBufferSource();
     source.buffer = buffer;
@@ -93,20 +118,71 @@ function Player() {
     return wavSaver != null;
   }
 
+  /**
+   * Sets the buffer that keeps the last played samples.
+   * @param {TimeShiftBuffer} buffer The buffer, or null for none.
+   */
+  function setTimeShift(buffer) {
+    stopReplay();
+    timeShift = buffer;
+  }
+
+  /**
+   * Plays again the last samples in the time shift buffer. After they have
+   * been played, it goes back to playing the current samples.
+   * @param {number} seconds The number of seconds to play again.
+   */
+  function replay(seconds) {
+    if (timeShift) {
+      replayPosition = timeShift.getPositionBefore(seconds);
+      replayRemaining = timeShift.getEnd() - replayPosition;
+    }
+  }
+
+  /**
+   * Stops playing again old samples and goes back to the current samples.
+   */
+  function stopReplay() {
+    replayRemaining = 0;
+  }
+
+  /**
+   * Tells whether old samples are being played again.
+   * @return {boolean} Whether a replay is in progress.
+   */
+  function isReplaying() {
+    return replayRemaining > 0;
+  }
+
   /**
    * Sets the volume for playing samples.
    * @param {number} volume The volume to set, between 0 and 1.
    */
-  function setVolume(volume) {
-    gainNode.gain.value = volume;
+  function setVolume(newVolume) {
+    volume = newVolume;
+    gainNode.gain.value = muted ? 0 : volume;
+  }
+
+  /**
+   * Silences or unsilences the output without changing the volume.
+   * @param {boolean} mute Whether to silence the output.
+   */
+  function setMuted(mute) {
+    muted = mute;
+    gainNode.gain.value = muted ? 0 : volume;
   }
 
   return {
     play: play,
     setVolume: setVolume,
+    setMuted: setMuted,
     startWriting: startWriting,
     stopWriting: stopWriting,
-    isWriting: isWriting
+    isWriting: isWriting,
+    setTimeShift: setTimeShift,
+    replay: replay,
+    stopReplay: stopReplay,
+    isReplaying: isReplaying
   };
 }
 
@@ -111,6 +111,78 @@ var AuxWindows = (function() {
     });  
   }
 
+  /**
+   * Opens a radio window for the first USB tuner that doesn't have one.
+   */
+  function newRadio() {
+    var index = 0;
+    while (chrome.app.window.get(radioWindowId(index))) {
+      ++index;
+    }
+    chrome.app.window.create('interface.html#device=' + index, {
+        'id': radioWindowId(index),
+        'bounds': {
+          'width': 500,
+          'height': 225
+        },
+        'resizable': false,
+        'frame': 'none'
+      });
+  }
+
+  /**
+   * Returns the window ID for a USB tuner's radio window.
+   * @param {number} index The USB tuner's index.
+   * @return {string} The window ID.
+   */
+  function radioWindowId(index) {
+    return index ? 'radioTuner-' + index : 'radioTuner';
+  }
+
+  /**
+   * Shows a window with the statistics of all the radio windows.
+   */
+  function monitor() {
+    chrome.app.window.create('monitor.html', {
+        'id': 'monitor',
+        'bounds': {
+          'width': 600,
+          'height': 1
+        },
+        'resizable': true
+      });
+  }
+
+  /**
+   * Shows a window with the latest messages decoded by all the radio
+   * windows.
+   */
+  function messages() {
+    chrome.app.window.create('messages.html', {
+        'id': 'messages',
+        'bounds': {
+          'width': 700,
+          'height': 400
+        },
+        'resizable': true
+      });
+  }
+
+  /**
+   * Shows a window with the weather satellite image decoded by a radio
+   * window in the APT mode.
+   */
+  function image() {
+    chrome.app.window.create('image.html', {
+        'id': 'image',
+        'bounds': {
+          'width': 1060,
+          'height': 600
+        },
+        'resizable': true
+      });
+  }
+
   /**
    * Shows an error window.
    * @param {string} msg The error message to show.
@@ -186,6 +258,10 @@ var AuxWindows = (function() {
     settings: settings,
     estimatePpm: estimatePpm,
     managePresets: managePresets,
+    newRadio: newRadio,
+    monitor: monitor,
+    messages: messages,
+    image: image,
     error: error,
     help: help,
     resizeCurrentTo: resizeCurrentTo,
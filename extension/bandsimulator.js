@@ -0,0 +1,363 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * The stations in the simulated band, if none are configured.
+ */
+var DEFAULT_SIMULATED_STATIONS =
+    '88.3M WBFM -20, 89.1M WBFM -35, 90.5M WBFM -25, 93.7M WBFM -45, ' +
+    '95.1M WBFM -30, 97.3M WBFM -20, 99.9M WBFM -40, 101.1M WBFM -28, ' +
+    '103.5M WBFM -33, 105.9M WBFM -22, 107.7M WBFM -50, ' +
+    '162.4M NBFM -40, 162.55M NBFM -45';
+
+/**
+ * Parses a list of simulated stations. Stations are separated by commas,
+ * and each one has a frequency, a modulation (WBFM, NBFM, AM, LSB, USB)
+ * and a power in dB relative to full scale, like "88.5M WBFM -20".
+ * @param {string} text The list of stations.
+ * @return {Array.<Object>} The stations, with their frequency, modulation
+ *     and power.
+ */
+function parseSimulatedStations(text) {
+  var stations = [];
+  var entries = text.split(',');
+  for (var i = 0; i < entries.length; ++i) {
+    var parts = entries[i].trim().split(/\s+/);
+    var frequency = Frequencies.parseReadableInput(parts[0] || '');
+    if (!(frequency > 0)) {
+      continue;
+    }
+    var modulation = (parts[1] || 'WBFM').toUpperCase();
+    stations.push({
+      frequency: frequency,
+      modulation: DefaultModes[modulation] ? modulation : 'WBFM',
+      power: Number(parts[2]) || -20
+    });
+  }
+  return stations;
+}
+
+/**
+ * A tuner that generates a band full of stations, so that the radio can be
+ * tried, and scanning can be measured, without any hardware. It has the
+ * same methods as RTL2832U.
+ *
+ * Each station's signal is computed once, at baseband, as a loop of
+ * LOOP_SECONDS that repeats seamlessly. When the tuner is tuned, the
+ * stations that fall within the tuned bandwidth are mixed up to their
+ * frequency offset with a numerically controlled oscillator and added into
+ * a single loop; the offsets are rounded to a whole number of cycles per
+ * loop, so it still repeats seamlessly. To read samples, that loop is
+ * added to a precomputed loop of noise, plus a DC spike like the real
+ * tuner has. That is cheap enough to generate samples many times faster
+ * than real time.
+ *
+ * Options:
+ *     noise: the noise level, in dB relative to full scale (default -45).
+ *     dcSpike: the DC offset, relative to full scale (default 0.02).
+ *     ppmError: a simulated crystal error in parts per million, which the
+ *         frequency correction has to compensate (default 0).
+ *     realTime: whether to deliver the samples at the sample rate, like a
+ *         real tuner, instead of as fast as possible (default false).
+ * @param {Array.<Object>} stations The stations, with their frequency,
+ *     modulation and power in dB relative to full scale.
+ * @param {number} ppm The frequency correction factor, in parts per million.
+ * @param {Object=} opt_options The simulator's options.
+ * @constructor
+ */
+function BandSimulator(stations, ppm, opt_options) {
+
+  /**
+   * The length of each station's signal loop. The audio tones have a whole
+   * number of cycles in this time.
+   */
+  var LOOP_SECONDS = 0.2;
+
+  /**
+   * The number of complex samples in the noise loop. It's not a multiple of
+   * the station loop, so the noise doesn't repeat with the stations.
+   */
+  var NOISE_LENGTH = 131071;
+
+  var options = opt_options || {};
+  var noise = options.noise == null ? -45 : options.noise;
+  var noiseLevel = Math.pow(10, noise / 20);
+  var dcSpike = options.dcSpike == null ? 0.02 : options.dcSpike;
+  var freqError = ((options.ppmError || 0) - ppm) / 1e6;
+  var realTime = !!options.realTime;
+
+  var sampleRate = 0;
+  var centerFrequency = 0;
+  var loops = [];
+  var noiseI = new Float32Array(0);
+  var noiseQ = new Float32Array(0);
+  var noisePos = 0;
+  var bandI = new Float32Array(0);
+  var bandQ = new Float32Array(0);
+  var bandPos = 0;
+  var tunedStations = 0;
+  var seed = 1;
+  var generateTime = 0;
+  var generatedSamples = 0;
+  var startTime = 0;
+  var errorHandler;
+
+  /**
+   * Opens the simulated tuner.
+   * @param {Function} kont The continuation for this function.
+   */
+  function open(kont) {
+    kont();
+  }
+
+  /**
+   * Sets the sample rate, and computes the stations' signal loops for it.
+   * @param {number} rate The sample rate, in samples per second.
+   * @param {Function} kont The continuation for this function. Receives the
+   *     sample rate that was set as its first parameter.
+   */
+  function setSampleRate(rate, kont) {
+    if (rate != sampleRate) {
+      sampleRate = rate;
+      loops = [];
+      for (var i = 0; i < stations.length; ++i) {
+        loops.push(makeLoop(stations[i], i));
+      }
+      makeNoise();
+      mixBand();
+    }
+    kont(rate);
+  }
+
+  /**
+   * Tunes the device to the given frequency.
+   * @param {number} freq The frequency to tune to, in Hertz.
+   * @param {Function} kont The continuation for this function, which
+   *     receives the tuned frequency.
+   */
+  function setCenterFrequency(freq, kont) {
+    centerFrequency = freq;
+    mixBand();
+    kont(freq);
+  }
+
+  /**
+   * Sets the tuner's gain. The simulator ignores it.
+   * @param {?number} gain The gain in dB, or null for automatic gain.
+   * @param {Function} kont The continuation for this function.
+   */
+  function setGain(gain, kont) {
+    kont();
+  }
+
+  /**
+   * Restarts the stream of samples.
+   * @param {Function} kont The continuation for this function.
+   */
+  function resetBuffer(kont) {
+    startTime = Date.now();
+    generatedSamples = 0;
+    generateTime = 0;
+    kont();
+  }
+
+  /**
+   * Generates a block of samples.
+   * @param {number} length The number of samples to read.
+   * @param {Function} kont The continuation for this function. It will
+   *     receive as its argument an ArrayBuffer containing the read samples,
+   *     which you can interpret as pairs of unsigned 8-bit integers; the
+   *     first one is the sample's I value, and the second one is its Q value.
+   */
+  function readSamples(length, kont) {
+    var before = Date.now();
+    var buffer = generate(length);
+    generateTime += Date.now() - before;
+    generatedSamples += length;
+    var delay = 0;
+    if (realTime) {
+      delay = Math.max(0, startTime + 1000 * generatedSamples / sampleRate -
+                          Date.now());
+    }
+    setTimeout(function() { kont(buffer); }, delay);
+  }
+
+  /**
+   * Closes the simulated tuner.
+   * @param {Function} kont The continuation for this function.
+   */
+  function close(kont) {
+    kont();
+  }
+
+  /**
+   * Computes the loop of baseband samples for a station.
+   * @param {Object} station The station.
+   * @param {number} index The station's position in the list, to give each
+   *     station a different audio tone.
+   * @return {{I:Float32Array,Q:Float32Array}} The loop of samples.
+   */
+  function makeLoop(station, index) {
+    var length = Math.round(sampleRate * LOOP_SECONDS);
+    var I = new Float32Array(length);
+    var Q = new Float32Array(length);
+    var ampl = Math.pow(10, station.power / 20);
+    var toneFreq = 400 + 100 * (index % 20);
+    var w = 2 * Math.PI / sampleRate;
+    var phase = 0;
+    for (var i = 0; i < length; ++i) {
+      var tone = Math.sin(w * toneFreq * i);
+      switch (station.modulation) {
+        case 'AM':
+          var env = ampl * (1 + 0.5 * tone) / 1.5;
+          I[i] = env;
+          Q[i] = 0;
+          continue;
+        case 'USB':
+        case 'LSB':
+          var sign = station.modulation == 'USB' ? 1 : -1;
+          I[i] = ampl * Math.cos(w * toneFreq * i);
+          Q[i] = ampl * sign * Math.sin(w * toneFreq * i);
+          continue;
+        case 'NBFM':
+          phase += w * 5000 * tone;
+          break;
+        default:
+          var left = tone;
+          var right = Math.sin(w * toneFreq * 1.5 * i);
+          var mpx = 0.45 * (left + right) + 0.1 * Math.sin(w * 19000 * i) +
+              0.45 * (left - right) * Math.sin(w * 38000 * i);
+          phase += w * 75000 * 0.5 * mpx;
+          break;
+      }
+      I[i] = ampl * Math.cos(phase);
+      Q[i] = ampl * Math.sin(phase);
+    }
+    return {I: I, Q: Q};
+  }
+
+  /**
+   * Computes the loop of noise samples.
+   */
+  function makeNoise() {
+    noiseI = new Float32Array(NOISE_LENGTH);
+    noiseQ = new Float32Array(NOISE_LENGTH);
+    var sigma = noiseLevel / Math.SQRT2;
+    for (var i = 0; i < NOISE_LENGTH; ++i) {
+      var r = sigma * Math.sqrt(-2 * Math.log(1 - random()));
+      var a = 2 * Math.PI * random();
+      noiseI[i] = r * Math.cos(a);
+      noiseQ[i] = r * Math.sin(a);
+    }
+  }
+
+  /**
+   * Returns a pseudorandom number from a fixed seed.
+   * @return {number} A number between 0 and 1.
+   */
+  function random() {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    return seed / 2147483648;
+  }
+
+  /**
+   * Mixes the stations within the tuned bandwidth into a single loop.
+   */
+  function mixBand() {
+    var loopLength = Math.round(sampleRate * LOOP_SECONDS);
+    bandI = new Float32Array(loopLength);
+    bandQ = new Float32Array(loopLength);
+    bandPos %= Math.max(1, loopLength);
+    tunedStations = 0;
+    var tunedFrequency = centerFrequency * (1 + freqError);
+    for (var st = 0; st < stations.length && sampleRate > 0; ++st) {
+      var offset = stations[st].frequency - tunedFrequency;
+      if (Math.abs(offset) >= sampleRate / 2) {
+        continue;
+      }
+      ++tunedStations;
+      offset = Math.round(offset * LOOP_SECONDS) / LOOP_SECONDS;
+      var deltaCos = Math.cos(2 * Math.PI * offset / sampleRate);
+      var deltaSin = Math.sin(2 * Math.PI * offset / sampleRate);
+      var I = loops[st].I;
+      var Q = loops[st].Q;
+      var c = 1;
+      var s = 0;
+      for (var i = 0; i < loopLength; ++i) {
+        bandI[i] += I[i] * c - Q[i] * s;
+        bandQ[i] += I[i] * s + Q[i] * c;
+        var ns = c * deltaSin + s * deltaCos;
+        c = c * deltaCos - s * deltaSin;
+        s = ns;
+      }
+    }
+  }
+
+  /**
+   * Generates a block of samples.
+   * @param {number} length The number of samples.
+   * @return {ArrayBuffer} The samples, as unsigned 8-bit I/Q pairs.
+   */
+  function generate(length) {
+    var out = new Uint8ClampedArray(length * 2);
+    var loopLength = bandI.length;
+    noisePos = Math.floor(random() * NOISE_LENGTH);
+    var dc = 127.5 + 127.5 * dcSpike;
+    for (var i = 0; i < length; ++i) {
+      out[2 * i] = dc + 127.5 * (bandI[bandPos] + noiseI[noisePos]);
+      out[2 * i + 1] = dc + 127.5 * (bandQ[bandPos] + noiseQ[noisePos]);
+      if (++bandPos == loopLength) {
+        bandPos = 0;
+      }
+      if (++noisePos == NOISE_LENGTH) {
+        noisePos = 0;
+      }
+    }
+    return out.buffer;
+  }
+
+  /**
+   * Returns the simulator's statistics.
+   * @return {Object} The number of stations in the tuned bandwidth, and
+   *     the fraction of real time that is spent generating samples.
+   */
+  function getStats() {
+    return {
+      stations: tunedStations,
+      load: generatedSamples ? generateTime / 1000 * sampleRate /
+                               generatedSamples : 0
+    };
+  }
+
+  /**
+   * Sets a function to call if there's an error. The simulator has no
+   * errors, but tuners must have this method.
+   * @param {Function} func The function to call on error.
+   */
+  function setOnError(func) {
+    errorHandler = func;
+  }
+
+  return {
+    open: open,
+    setSampleRate: setSampleRate,
+    setCenterFrequency: setCenterFrequency,
+    setGain: setGain,
+    resetBuffer: resetBuffer,
+    readSamples: readSamples,
+    close: close,
+    getStats: getStats,
+    setOnError: setOnError
+  };
+}
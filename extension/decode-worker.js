@@ -18,12 +18,22 @@
  */
 
 importScripts('dsp.js');
+importScripts('rds.js');
+importScripts('adsb.js');
+importScripts('hdlc.js');
+importScripts('aprs.js');
+importScripts('pocsag.js');
+importScripts('apt.js');
+importScripts('ais.js');
 importScripts('demodulator-am.js');
 importScripts('demodulator-ssb.js');
 importScripts('demodulator-nbfm.js');
 importScripts('demodulator-wbfm.js');
+importScripts('demodulator-adsb.js');
+importScripts('demodulator-apt.js');
+importScripts('demodulator-ais.js');
+importScripts('demodulators.js');
 
-var IN_RATE = 1024000;
 var OUT_RATE = 48000;
 
 /**
@@ -31,57 +41,166 @@ var OUT_RATE = 48000;
  * @constructor
  */
 function Decoder() {
-  var demodulator = new Demodulator_WBFM(IN_RATE, OUT_RATE);
+  var inRate = 1024000;
+  var demodulator = new Demodulator_WBFM(inRate, OUT_RATE);
+  var corrector = new IQCorrector();
+  var fmMaxF = 75000;
   var cosine = 1;
   var sine = 0;
+  var quarterPhase = 0;
+  var sendBaseband = false;
+  var decodeRds = false;
+  var dataDecoders = {};
 
   /**
    * Demodulates the tuner's output, producing mono or stereo sound, and
    * sends the demodulated audio back to the caller.
+   * The tuner's DC offset and I/Q imbalance are corrected first.
    * @param {ArrayBuffer} buffer A buffer containing the tuner's output.
    * @param {boolean} inStereo Whether to try decoding the stereo signal.
    * @param {number} freqOffset The frequency to shift the samples by.
+   *     Whole quarters of the sample rate are shifted while converting the
+   *     samples, which is almost free; only the rest needs a mixer.
    * @param {Object=} opt_data Additional data to echo back to the caller.
+   *     If it has a findCarrier field, the station's carrier is searched
+   *     for within that many Hz of where it should be, and its offset and
+   *     signal-to-noise ratio are added to the data. If it has a
+   *     measureChannels field, with the channels' offsets from the tuner's
+   *     center frequency and their width, the power in each channel is
+   *     added in the channelPowers field, and the noise level in the
+   *     noiseLevel field. For FM, the data also gets the station's
+   *     offset from the average of the demodulated audio, in the fmOffset
+   *     field. If RDS is being decoded, the station's information is added
+   *     in the rds field. Modes that decode digital messages add them in
+   *     the messages field, and modes that decode images add the completed
+   *     lines in the imageLines field.
    */
   function process(buffer, inStereo, freqOffset, opt_data) {
+    var startTime = performance.now();
     var data = opt_data || {};
-    var IQ = iqSamplesFromUint8(buffer, IN_RATE);
-    IQ = shiftFrequency(IQ, freqOffset, IN_RATE, cosine, sine);
-    cosine = IQ[2];
-    sine = IQ[3];
-    var out = demodulator.demodulate(IQ[0], IQ[1], inStereo);
+    if (data['findCarrier'] || data['measureChannels']) {
+      var raw = iqSamplesFromUint8(buffer, inRate);
+    }
+    if (data['findCarrier']) {
+      var carrier = findCarrier(raw[0], raw[1], inRate, -freqOffset,
+                                data['findCarrier']);
+      data['carrierOffset'] = carrier.offset;
+      data['carrierSnr'] = carrier.snr;
+    }
+    if (data['measureChannels']) {
+      var channels = data['measureChannels'];
+      var measured = measureChannelPowers(
+          raw[0], raw[1], inRate, channels[0], channels[1]);
+      data['channelPowers'] = measured.powers;
+      data['noiseLevel'] = measured.noise;
+    }
+    if (demodulator.demodulateRaw) {
+      var out = demodulator.demodulateRaw(buffer);
+    } else {
+      var quarters = Math.round(freqOffset * 4 / inRate);
+      var residual = freqOffset - quarters * inRate / 4;
+      var IQ = corrector.convert(buffer, quarters, quarterPhase, freqOffset);
+      quarterPhase = IQ[2];
+      if (residual != 0) {
+        IQ = shiftFrequency(IQ, residual, inRate, cosine, sine);
+        cosine = IQ[2];
+        sine = IQ[3];
+      }
+      var out = demodulator.demodulate(IQ[0], IQ[1], inStereo);
+    }
+    if (fmMaxF) {
+      data['fmOffset'] = fmMaxF * average(new Float32Array(out.left));
+    }
     data['stereo'] = out['stereo'];
     data['signalLevel'] = out['signalLevel'];
-    postMessage([out.left, out.right, data], [out.left, out.right]);
+    if (out['rds']) {
+      data['rds'] = out['rds'];
+    }
+    if (out['messages']) {
+      data['messages'] = out['messages'];
+    }
+    var transfer = [out.left, out.right];
+    if (out['imageLines']) {
+      data['imageLines'] = out['imageLines'];
+      for (var i = 0; i < out['imageLines'].length; ++i) {
+        transfer.push(out['imageLines'][i].buffer);
+      }
+    }
+    if (sendBaseband && demodulator.getBaseband) {
+      var baseband = demodulator.getBaseband();
+      var samples = iqSamplesToInt16(baseband.I, baseband.Q);
+      data['baseband'] = samples.buffer;
+      data['basebandRate'] = baseband.rate;
+      transfer.push(samples.buffer);
+    }
+    data['processingTime'] = performance.now() - startTime;
+    postMessage([out.left, out.right, data], transfer);
   }
 
   /**
    * Changes the modulation scheme.
    * @param {Object} mode The new mode.
+   * @param {number=} opt_rate The tuner's sample rate, if it has changed.
+   */
+  function setMode(mode, opt_rate) {
+    if (opt_rate) {
+      inRate = opt_rate;
+    }
+    demodulator = createDemodulator(mode, inRate, OUT_RATE);
+    if (demodulator.enableRds) {
+      demodulator.enableRds(decodeRds);
+    }
+    if (demodulator.enableDecoder) {
+      for (var name in dataDecoders) {
+        demodulator.enableDecoder(name, dataDecoders[name]);
+      }
+    }
+    fmMaxF = mode.modulation == 'WBFM' ? 75000 :
+             mode.modulation == 'NBFM' ? mode.maxF : 0;
+  }
+
+  /**
+   * Enables or disables sending the downsampled I/Q samples back to the
+   * caller along with the demodulated audio.
+   * @param {boolean} enable Whether to send the samples.
+   */
+  function enableBaseband(enable) {
+    sendBaseband = enable;
+  }
+
+  /**
+   * Enables or disables decoding the RDS signal of broadcast FM stations.
+   * Enabling it again forgets the information decoded so far, which must
+   * be done when tuning to another station.
+   * @param {boolean} enable Whether to decode the RDS signal.
+   */
+  function enableRds(enable) {
+    decodeRds = enable;
+    if (demodulator.enableRds) {
+      demodulator.enableRds(enable);
+    }
+  }
+
+  /**
+   * Enables or disables a decoder for the digital data sent in the
+   * demodulated audio, such as APRS packets in narrowband FM. The decoded
+   * data is sent back in the messages field.
+   * @param {string} name The decoder's name.
+   * @param {boolean} enable Whether to run the decoder.
    */
-  function setMode(mode) {
-    switch (mode.modulation) {
-      case 'AM':
-        demodulator = new Demodulator_AM(IN_RATE, OUT_RATE, mode.bandwidth);
-        break;
-      case 'USB':
-        demodulator = new Demodulator_SSB(IN_RATE, OUT_RATE, mode.bandwidth, true);
-        break;
-      case 'LSB':
-        demodulator = new Demodulator_SSB(IN_RATE, OUT_RATE, mode.bandwidth, false);
-        break;
-      case 'NBFM':
-        demodulator = new Demodulator_NBFM(IN_RATE, OUT_RATE, mode.maxF);
-        break;
-      default:
-        demodulator = new Demodulator_WBFM(IN_RATE, OUT_RATE);
-        break;
+  function enableDecoder(name, enable) {
+    dataDecoders[name] = enable;
+    if (demodulator.enableDecoder) {
+      demodulator.enableDecoder(name, enable);
     }
   }
 
   return {
     process: process,
-    setMode: setMode
+    setMode: setMode,
+    enableBaseband: enableBaseband,
+    enableRds: enableRds,
+    enableDecoder: enableDecoder
   };
 }
 
@@ -90,7 +209,16 @@ var decoder = new Decoder();
 onmessage = function(event) {
   switch (event.data[0]) {
     case 1:
-      decoder.setMode(event.data[1]);
+      decoder.setMode(event.data[1], event.data[2]);
+      break;
+    case 2:
+      decoder.enableBaseband(event.data[1]);
+      break;
+    case 3:
+      decoder.enableRds(event.data[1]);
+      break;
+    case 4:
+      decoder.enableDecoder(event.data[1], event.data[2]);
       break;
     default:
       decoder.process(event.data[1], event.data[2], event.data[3], event.data[4]);
@@ -0,0 +1,77 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A demodulator for the ADS-B messages aircraft send at
+ * 1090 MHz. It outputs silence and the decoded messages.
+ */
+
+/**
+ * A class to implement an ADS-B demodulator.
+ * @param {number} inRate The sample rate of the input samples, which
+ *     should be 2000000.
+ * @param {number} outRate The sample rate of the output audio.
+ * @constructor
+ */
+function Demodulator_ADSB(inRate, outRate) {
+  var decoder = new AdsbDecoder(inRate);
+  var inSamples = 0;
+
+  /**
+   * Decodes the messages in the signal.
+   * @param {Float32Array} samplesI The I components of the samples.
+   * @param {Float32Array} samplesQ The Q components of the samples.
+   * @return {{left:ArrayBuffer,right:ArrayBuffer,stereo:boolean,signalLevel:number,messages:Array.<Object>}}
+   *     Silence as long as the signal, and the decoded messages.
+   */
+  function demodulate(samplesI, samplesQ) {
+    return output(samplesI.length, decoder.process(samplesI, samplesQ));
+  }
+
+  /**
+   * Decodes the messages in the tuner's samples as they come from the
+   * tuner, which is faster than converting them to I/Q samples first.
+   * The messages are found from the magnitude of the samples, so they
+   * don't need to be corrected or shifted.
+   * @param {ArrayBuffer} buffer The samples, as pairs of I and Q bytes.
+   * @return {{left:ArrayBuffer,right:ArrayBuffer,stereo:boolean,signalLevel:number,messages:Array.<Object>}}
+   *     Silence as long as the signal, and the decoded messages.
+   */
+  function demodulateRaw(buffer) {
+    return output(buffer.byteLength / 2, decoder.processRaw(buffer));
+  }
+
+  /**
+   * Returns the silent audio for a block, and its messages.
+   * @param {number} length The number of samples in the block.
+   * @param {Array.<Object>} messages The messages.
+   * @return {{left:ArrayBuffer,right:ArrayBuffer,stereo:boolean,signalLevel:number,messages:Array.<Object>}}
+   *     The demodulator's output.
+   */
+  function output(length, messages) {
+    var outLength = Math.floor((inSamples + length) * outRate / inRate) -
+                    Math.floor(inSamples * outRate / inRate);
+    inSamples += length;
+    return {left: new Float32Array(outLength).buffer,
+            right: new Float32Array(outLength).buffer,
+            stereo: false,
+            signalLevel: 0,
+            messages: messages};
+  }
+
+  return {
+    demodulate: demodulate,
+    demodulateRaw: demodulateRaw
+  };
+}
@@ -0,0 +1,100 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A demodulator for the AIS messages that ships send on
+ * 161.975 and 162.025 MHz.
+ */
+
+/**
+ * A class to implement an AIS demodulator, tuned to 162 MHz, halfway
+ * between the two AIS channels, so it can decode both at once.
+ *
+ * The signal is first downsampled to a quarter of the tuner's rate, which
+ * a short filter can do since both channels are near the center. Then each
+ * channel is shifted to the center, and an FM demodulator filters and
+ * downsamples it to a little over 5 samples per bit. It outputs the sound
+ * of both channels, with its characteristic bursts, and the decoded
+ * messages.
+ * @param {number} inRate The sample rate of the input samples, which
+ *     should be 1024000.
+ * @param {number} outRate The sample rate of the output audio.
+ * @constructor
+ */
+function Demodulator_AIS(inRate, outRate) {
+  var INTER_RATE = inRate / 4;
+  var CHANNEL_RATE = INTER_RATE / 5;
+  var CHANNEL_OFFSET = 25000;
+  var MAX_F = 2400;
+
+  var coefs = getLowPassFIRCoeffs(inRate, 2 * CHANNEL_OFFSET,
+                                  scaleKernelLength(21, inRate));
+  var downsamplerI = new Downsampler(inRate, INTER_RATE, coefs);
+  var downsamplerQ = new Downsampler(inRate, INTER_RATE, coefs);
+  var channels = [
+    {name: 'A', offset: -CHANNEL_OFFSET, cosine: 1, sine: 0},
+    {name: 'B', offset: CHANNEL_OFFSET, cosine: 1, sine: 0}
+  ];
+  for (var i = 0; i < channels.length; ++i) {
+    channels[i].demodulator =
+        new FMDemodulator(INTER_RATE, CHANNEL_RATE, MAX_F, 8000, 164);
+  }
+  var audioCoefs = getLowPassFIRCoeffs(CHANNEL_RATE, 10000, 21);
+  var audioDownsampler = new Downsampler(CHANNEL_RATE, outRate, audioCoefs);
+  var decoder = new AisDecoder(CHANNEL_RATE);
+
+  /**
+   * Demodulates the signal.
+   * @param {Float32Array} samplesI The I components of the samples.
+   * @param {Float32Array} samplesQ The Q components of the samples.
+   * @return {{left:ArrayBuffer,right:ArrayBuffer,stereo:boolean,signalLevel:number,messages:Array.<Object>}}
+   *     The demodulated audio signal, and the decoded messages.
+   */
+  function demodulate(samplesI, samplesQ) {
+    var IQ = [downsamplerI.downsample(samplesI),
+              downsamplerQ.downsample(samplesQ)];
+    var sound = null;
+    var signalLevel = 0;
+    var messages = [];
+    for (var i = 0; i < channels.length; ++i) {
+      var channel = channels[i];
+      var shifted = shiftFrequency(
+          IQ, -channel.offset, INTER_RATE, channel.cosine, channel.sine);
+      channel.cosine = shifted[2];
+      channel.sine = shifted[3];
+      var demodulated = channel.demodulator.demodulateTuned(
+          shifted[0], shifted[1]);
+      signalLevel = Math.max(
+          signalLevel, channel.demodulator.getRelSignalPower());
+      messages = messages.concat(decoder.process(demodulated, channel.name));
+      if (!sound) {
+        sound = demodulated;
+      } else {
+        for (var j = 0; j < sound.length; ++j) {
+          sound[j] = (sound[j] + demodulated[j]) / 2;
+        }
+      }
+    }
+    var audio = audioDownsampler.downsample(sound);
+    return {left: audio.buffer,
+            right: new Float32Array(audio).buffer,
+            stereo: false,
+            signalLevel: signalLevel,
+            messages: messages};
+  }
+
+  return {
+    demodulate: demodulate
+  };
+}
@@ -0,0 +1,72 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A demodulator for the APT images that NOAA weather
+ * satellites send at 137 MHz.
+ */
+
+/**
+ * A class to implement an APT demodulator. The signal is FM with a 17 kHz
+ * deviation, wider than NBFM, and the Doppler shift moves it by a few more
+ * kHz during a pass, so the FM demodulator keeps 24 kHz on each side.
+ * It outputs the demodulated audio, with its familiar ticking, and the
+ * decoded image lines.
+ * @param {number} inRate The sample rate of the input samples.
+ * @param {number} outRate The sample rate of the output audio.
+ * @constructor
+ */
+function Demodulator_APT(inRate, outRate) {
+  var MAX_F = 17000;
+  var INTER_RATE = 96000;
+
+  var demodulator = new FMDemodulator(inRate, INTER_RATE, MAX_F, 24000, 25);
+  var filterCoefs = getLowPassFIRCoeffs(INTER_RATE, 8000, 41);
+  var downSampler = new Downsampler(INTER_RATE, outRate, filterCoefs);
+  var decoder = new AptDecoder(outRate);
+
+  /**
+   * Demodulates the signal.
+   * @param {Float32Array} samplesI The I components of the samples.
+   * @param {Float32Array} samplesQ The Q components of the samples.
+   * @return {{left:ArrayBuffer,right:ArrayBuffer,stereo:boolean,signalLevel:number,imageLines:Array.<Uint8Array>}}
+   *     The demodulated audio signal, and the image lines completed in
+   *     this block.
+   */
+  function demodulate(samplesI, samplesQ) {
+    var demodulated = demodulator.demodulateTuned(samplesI, samplesQ);
+    var audio = downSampler.downsample(demodulated);
+    return {left: audio.buffer,
+            right: new Float32Array(audio).buffer,
+            stereo: false,
+            signalLevel: demodulator.getRelSignalPower(),
+            imageLines: decoder.process(audio)};
+  }
+
+  /**
+   * Returns the I/Q samples of the last block, as they were before
+   * demodulation, after the first downsampling stage.
+   * @return {{I:Float32Array,Q:Float32Array,rate:number}} The I and Q
+   *     components and their sample rate.
+   */
+  function getBaseband() {
+    var IQ = demodulator.getTunedIQ();
+    return {I: IQ[0], Q: IQ[1], rate: INTER_RATE};
+  }
+
+  return {
+    demodulate: demodulate,
+    getBaseband: getBaseband
+  };
+}
@@ -31,25 +31,62 @@ function Demodulator_NBFM(inRate, outRate, maxF) {
   var demodulator = new FMDemodulator(inRate, interRate, maxF, filterF, Math.floor(50 * 7 / multiple));
   var filterCoefs = getLowPassFIRCoeffs(interRate, 8000, 41);
   var downSampler = new Downsampler(interRate, outRate, filterCoefs);
+  var dataDecoders = {};
 
   /**
    * Demodulates the signal.
    * @param {Float32Array} samplesI The I components of the samples.
    * @param {Float32Array} samplesQ The Q components of the samples.
-   * @return {{left:ArrayBuffer,right:ArrayBuffer,stereo:boolean,carrier:boolean}}
-   *     The demodulated audio signal.
+   * @return {{left:ArrayBuffer,right:ArrayBuffer,stereo:boolean,carrier:boolean,messages:(Array.<Object>|undefined)}}
+   *     The demodulated audio signal, and the decoded packets if a data
+   *     decoder is enabled.
    */
   function demodulate(samplesI, samplesQ) {
     var demodulated = demodulator.demodulateTuned(samplesI, samplesQ);
     var audio = downSampler.downsample(demodulated);
-    return {left: audio.buffer,
-            right: new Float32Array(audio).buffer,
-            stereo: false,
-            signalLevel: demodulator.getRelSignalPower()};
+    var out = {left: audio.buffer,
+               right: new Float32Array(audio).buffer,
+               stereo: false,
+               signalLevel: demodulator.getRelSignalPower()};
+    for (var name in dataDecoders) {
+      out.messages = (out.messages || []).concat(
+          dataDecoders[name].process(audio));
+    }
+    return out;
+  }
+
+  /**
+   * Enables or disables a decoder for the data sent in the audio.
+   * @param {string} name The decoder's name: 'APRS' or 'POCSAG'.
+   * @param {boolean} enable Whether to run the decoder.
+   */
+  function enableDecoder(name, enable) {
+    var Decoder = {'APRS': AprsDecoder, 'POCSAG': PocsagDecoder}[name];
+    if (!Decoder) {
+      return;
+    }
+    if (!enable) {
+      delete dataDecoders[name];
+    } else if (!dataDecoders[name]) {
+      dataDecoders[name] = new Decoder(outRate);
+    }
+  }
+
+  /**
+   * Returns the I/Q samples of the last block, as they were before
+   * demodulation, after the first downsampling stage.
+   * @return {{I:Float32Array,Q:Float32Array,rate:number}} The I and Q
+   *     components and their sample rate.
+   */
+  function getBaseband() {
+    var IQ = demodulator.getTunedIQ();
+    return {I: IQ[0], Q: IQ[1], rate: interRate};
   }
 
   return {
-    demodulate: demodulate
+    demodulate: demodulate,
+    enableDecoder: enableDecoder,
+    getBaseband: getBaseband
   };
 }
 
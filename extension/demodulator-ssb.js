@@ -48,8 +48,20 @@ function Demodulator_SSB(inRate, outRate, bandwidth, upper) {
             signalLevel: Math.pow(demodulator.getRelSignalPower(), 0.17) };
   }
 
+  /**
+   * Returns the I/Q samples of the last block, as they were before
+   * demodulation, after the first downsampling stage.
+   * @return {{I:Float32Array,Q:Float32Array,rate:number}} The I and Q
+   *     components and their sample rate.
+   */
+  function getBaseband() {
+    var IQ = demodulator.getTunedIQ();
+    return {I: IQ[0], Q: IQ[1], rate: INTER_RATE};
+  }
+
   return {
-    demodulate: demodulate
+    demodulate: demodulate,
+    getBaseband: getBaseband
   };
 }
 
@@ -36,17 +36,22 @@ function Demodulator_WBFM(inRate, outRate) {
   var stereoSeparator = new StereoSeparator(INTER_RATE, PILOT_FREQ);
   var leftDeemph = new Deemphasizer(outRate, DEEMPH_TC);
   var rightDeemph = new Deemphasizer(outRate, DEEMPH_TC);
+  var rdsDecoder = null;
 
   /**
    * Demodulates the signal.
    * @param {Float32Array} samplesI The I components of the samples.
    * @param {Float32Array} samplesQ The Q components of the samples.
    * @param {boolean} inStereo Whether to try decoding the stereo signal.
-   * @return {{left:ArrayBuffer,right:ArrayBuffer,stereo:boolean,carrier:boolean}}
-   *     The demodulated audio signal.
+   * @return {{left:ArrayBuffer,right:ArrayBuffer,stereo:boolean,carrier:boolean,rds:Object}}
+   *     The demodulated audio signal, and the RDS information if it is
+   *     being decoded.
    */
   function demodulate(samplesI, samplesQ, inStereo) {
     var demodulated = demodulator.demodulateTuned(samplesI, samplesQ);
+    if (rdsDecoder) {
+      rdsDecoder.process(demodulated);
+    }
     var leftAudio = monoSampler.downsample(demodulated);
     var rightAudio = new Float32Array(leftAudio);
     var stereoOut = false;
@@ -68,11 +73,34 @@ function Demodulator_WBFM(inRate, outRate) {
     return {left: leftAudio.buffer,
             right: rightAudio.buffer,
             stereo: stereoOut,
-            signalLevel: demodulator.getRelSignalPower() };
+            signalLevel: demodulator.getRelSignalPower(),
+            rds: rdsDecoder && rdsDecoder.getInfo() };
+  }
+
+  /**
+   * Enables or disables decoding the RDS signal. Enabling it starts afresh,
+   * forgetting the information decoded before.
+   * @param {boolean} enable Whether to decode the RDS signal.
+   */
+  function enableRds(enable) {
+    rdsDecoder = enable ? new RdsDecoder(INTER_RATE) : null;
+  }
+
+  /**
+   * Returns the I/Q samples of the last block, as they were before
+   * demodulation, after the first downsampling stage.
+   * @return {{I:Float32Array,Q:Float32Array,rate:number}} The I and Q
+   *     components and their sample rate.
+   */
+  function getBaseband() {
+    var IQ = demodulator.getTunedIQ();
+    return {I: IQ[0], Q: IQ[1], rate: INTER_RATE};
   }
 
   return {
-    demodulate: demodulate
+    demodulate: demodulate,
+    getBaseband: getBaseband,
+    enableRds: enableRds
   };
 }
 
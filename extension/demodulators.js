@@ -0,0 +1,45 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A function to create the demodulator for a mode.
+ */
+
+/**
+ * Creates the demodulator for the given mode.
+ * @param {Object} mode The mode, as in DefaultModes.
+ * @param {number} inRate The sample rate of the input samples.
+ * @param {number} outRate The sample rate of the output audio.
+ * @return {Object} The demodulator.
+ */
+function createDemodulator(mode, inRate, outRate) {
+  switch (mode.modulation) {
+    case 'AM':
+      return new Demodulator_AM(inRate, outRate, mode.bandwidth);
+    case 'USB':
+      return new Demodulator_SSB(inRate, outRate, mode.bandwidth, true);
+    case 'LSB':
+      return new Demodulator_SSB(inRate, outRate, mode.bandwidth, false);
+    case 'NBFM':
+      return new Demodulator_NBFM(inRate, outRate, mode.maxF);
+    case 'ADSB':
+      return new Demodulator_ADSB(inRate, outRate);
+    case 'APT':
+      return new Demodulator_APT(inRate, outRate);
+    case 'AIS':
+      return new Demodulator_AIS(inRate, outRate);
+    default:
+      return new Demodulator_WBFM(inRate, outRate);
+  }
+}
@@ -47,6 +47,19 @@ function getLowPassFIRCoeffs(sampleRate, halfAmplFreq, length) {
   return coefs;
 }
 
+/**
+ * Scales the length of a filter kernel that was chosen for a signal at
+ * 1024000 samples per second to the given sample rate, so the filter keeps
+ * the same transition band. At lower sample rates the kernel is shorter,
+ * so filtering takes proportionally less time.
+ * @param {number} length The kernel's length at 1024000 samples per second.
+ * @param {number} sampleRate The signal's sample rate.
+ * @return {number} The kernel's length at the given sample rate.
+ */
+function scaleKernelLength(length, sampleRate) {
+  return Math.max(1, Math.round(length * sampleRate / 1024000));
+}
+
 /**
  * Multiplies an array that represents a signal by a sinusoidal.
  * @param {Float32Array} samples The array to multiply.
@@ -173,11 +186,14 @@ function Downsampler(inRate, outRate, coefficients) {
  * @param {number} outRate The sample rate for the output audio.
  * @param {number} filterFreq The bandwidth of the sideband.
  * @param {number} upper Whether we are demodulating the upper sideband.
- * @param {number} kernelLen The length of the filter kernel.
+ * @param {number} kernelLen The length of the filter kernels. The input
+ *     filter's length is for 1024000 samples per second, and it is scaled
+ *     according to the input rate.
  * @constructor
  */
 function SSBDemodulator(inRate, outRate, filterFreq, upper, kernelLen) {
-  var coefs = getLowPassFIRCoeffs(inRate, 10000, kernelLen);
+  var coefs = getLowPassFIRCoeffs(
+      inRate, 10000, scaleKernelLength(kernelLen, inRate));
   var downsamplerI = new Downsampler(inRate, outRate, coefs);
   var downsamplerQ = new Downsampler(inRate, outRate, coefs);
   var coefsHilbert = getHilbertCoeffs(kernelLen);
@@ -190,6 +206,8 @@ function SSBDemodulator(inRate, outRate, filterFreq, upper, kernelLen) {
   var powerShortAvg = new ExpAverage(outRate * 0.5);
   var sigRatio = inRate / outRate;
   var relSignalPower = 0;
+  var I = new Float32Array(0);
+  var Q = new Float32Array(0);
 
   /**
    * Demodulates the given I/Q samples.
@@ -200,8 +218,8 @@ function SSBDemodulator(inRate, outRate, filterFreq, upper, kernelLen) {
    * @returns {Float32Array} The demodulated sound.
    */
   function demodulateTuned(samplesI, samplesQ) {
-    var I = downsamplerI.downsample(samplesI);
-    var Q = downsamplerQ.downsample(samplesQ);
+    I = downsamplerI.downsample(samplesI);
+    Q = downsamplerQ.downsample(samplesQ);
 
     var specSqrSum = 0;
     var sigSqrSum = 0;
@@ -235,9 +253,18 @@ function SSBDemodulator(inRate, outRate, filterFreq, upper, kernelLen) {
     return relSignalPower;
   }
 
+  /**
+   * Returns the downsampled I/Q samples of the last demodulated block.
+   * @return {Array.<Float32Array>} An array containing the I and Q streams.
+   */
+  function getTunedIQ() {
+    return [I, Q];
+  }
+
   return {
     demodulateTuned: demodulateTuned,
-    getRelSignalPower: getRelSignalPower
+    getRelSignalPower: getRelSignalPower,
+    getTunedIQ: getTunedIQ
   }
 }
 
@@ -246,16 +273,20 @@ function SSBDemodulator(inRate, outRate, filterFreq, upper, kernelLen) {
  * @param {number} inRate The sample rate for the input signal.
  * @param {number} outRate The sample rate for the output audio.
  * @param {number} filterFreq The frequency of the low-pass filter.
- * @param {number} kernelLen The length of the filter kernel.
+ * @param {number} kernelLen The length of the filter kernel at 1024000
+ *     samples per second. It is scaled according to the input rate.
 
  * @constructor
  */
 function AMDemodulator(inRate, outRate, filterFreq, kernelLen) {
-  var coefs = getLowPassFIRCoeffs(inRate, filterFreq, kernelLen);
+  var coefs = getLowPassFIRCoeffs(
+      inRate, filterFreq, scaleKernelLength(kernelLen, inRate));
   var downsamplerI = new Downsampler(inRate, outRate, coefs);
   var downsamplerQ = new Downsampler(inRate, outRate, coefs);
   var sigRatio = inRate / outRate;
   var relSignalPower = 0;
+  var I = new Float32Array(0);
+  var Q = new Float32Array(0);
 
   /**
    * Demodulates the given I/Q samples.
@@ -267,8 +298,10 @@ function AMDemodulator(inRate, outRate, filterFreq, kernelLen) {
    * @returns {Float32Array} The demodulated sound.
    */
   function demodulateTuned(samplesI, samplesQ) {
-    var I = downsamplerI.downsample(samplesI);
-    var Q = downsamplerQ.downsample(samplesQ);
+    I = downsamplerI.downsample(samplesI);
+    Q = downsamplerQ.downsample(samplesQ);
+    // The IQCorrector leaves the tuner's DC offset alone when the station
+    // is at the center frequency, so it's removed here.
     var iAvg = average(I);
     var qAvg = average(Q);
     var out = new Float32Array(I.length);
@@ -301,9 +334,18 @@ function AMDemodulator(inRate, outRate, filterFreq, kernelLen) {
     return relSignalPower;
   }
 
+  /**
+   * Returns the downsampled I/Q samples of the last demodulated block.
+   * @return {Array.<Float32Array>} An array containing the I and Q streams.
+   */
+  function getTunedIQ() {
+    return [I, Q];
+  }
+
   return {
     demodulateTuned: demodulateTuned,
-    getRelSignalPower: getRelSignalPower
+    getRelSignalPower: getRelSignalPower,
+    getTunedIQ: getTunedIQ
   }
 }
 
@@ -313,18 +355,22 @@ function AMDemodulator(inRate, outRate, filterFreq, kernelLen) {
  * @param {number} outRate The sample rate for the output audio.
  * @param {number} maxF The maximum frequency deviation.
  * @param {number} filterFreq The frequency of the low-pass filter.
- * @param {number} kernelLen The length of the filter kernel.
+ * @param {number} kernelLen The length of the filter kernel at 1024000
+ *     samples per second. It is scaled according to the input rate.
  * @constructor
  */
 function FMDemodulator(inRate, outRate, maxF, filterFreq, kernelLen) {
   var AMPL_CONV = outRate / (2 * Math.PI * maxF);
 
-  var coefs = getLowPassFIRCoeffs(inRate, filterFreq, kernelLen);
+  var coefs = getLowPassFIRCoeffs(
+      inRate, filterFreq, scaleKernelLength(kernelLen, inRate));
   var downsamplerI = new Downsampler(inRate, outRate, coefs);
   var downsamplerQ = new Downsampler(inRate, outRate, coefs);
   var lI = 0;
   var lQ = 0;
   var relSignalPower = 0;
+  var I = new Float32Array(0);
+  var Q = new Float32Array(0);
 
   /**
    * Demodulates the given I/Q samples.
@@ -335,8 +381,8 @@ function FMDemodulator(inRate, outRate, maxF, filterFreq, kernelLen) {
    * @returns {Float32Array} The demodulated sound.
    */
   function demodulateTuned(samplesI, samplesQ) {
-    var I = downsamplerI.downsample(samplesI);
-    var Q = downsamplerQ.downsample(samplesQ);
+    I = downsamplerI.downsample(samplesI);
+    Q = downsamplerQ.downsample(samplesQ);
     var out = new Float32Array(I.length);
 
     var prev = 0;
@@ -385,9 +431,18 @@ function FMDemodulator(inRate, outRate, maxF, filterFreq, kernelLen) {
     return relSignalPower;
   }
 
+  /**
+   * Returns the downsampled I/Q samples of the last demodulated block.
+   * @return {Array.<Float32Array>} An array containing the I and Q streams.
+   */
+  function getTunedIQ() {
+    return [I, Q];
+  }
+
   return {
     demodulateTuned: demodulateTuned,
-    getRelSignalPower: getRelSignalPower
+    getRelSignalPower: getRelSignalPower,
+    getTunedIQ: getTunedIQ
   }
 }
 
@@ -428,7 +483,9 @@ function StereoSeparator(sampleRate, pilotFreq) {
     for (var i = 0; i < out.length; ++i) {
       var hdev = iavg.add(out[i] * sin);
       var vdev = qavg.add(out[i] * cos);
-      out[i] *= sin * cos * 2;
+      // sin * cos * 2 is the 38 kHz subcarrier; multiplying by it again
+      // halves the amplitude of the L-R signal, so we double it.
+      out[i] *= sin * cos * 4;
       var corr;
       if (hdev > 0) {
         corr = Math.max(-4, Math.min(4, vdev / hdev));
@@ -441,6 +498,9 @@ function StereoSeparator(sampleRate, pilotFreq) {
       sin = newSin;
       cavg.add(corr * 10);
     }
+    var osc = normalizeOscillator(cos, sin);
+    cos = osc[0];
+    sin = osc[1];
     return {
       found: cavg.getStd() < STD_THRES,
       diff: out
@@ -548,6 +608,243 @@ function iqSamplesFromUint8(buffer, rate) {
   return [outI, outQ];
 }
 
+/**
+ * A class to remove the tuner's DC offset and to correct the gain and phase
+ * imbalance between its I and Q channels, which puts a mirror image of
+ * every strong signal on the opposite side of the center frequency.
+ *
+ * The offset and imbalance are estimated from the mean, power and
+ * correlation of the first sixteenth of each block, averaged over a few
+ * blocks; each block is corrected with the estimates from the blocks
+ * before it. (Taking every 16th sample instead would see any signal at a
+ * multiple of a sixteenth of the sample rate as DC.) The correction is
+ * folded into the conversion of the tuner's 8-bit samples, where it costs
+ * one multiply-add for I and two for Q.
+ *
+ * A channel right at the center frequency can't be told apart from the DC
+ * offset, and it is its own mirror image, so it would be damaged by the
+ * correction and it would spoil the estimates. Blocks for such a channel
+ * are neither corrected nor measured.
+ * @constructor
+ */
+function IQCorrector() {
+  var STATS_FRACTION = 16;
+  var MIN_CHANNEL_OFFSET = 1000;
+  var WEIGHT = 4;
+  var MAX_PHASE_SINE = 0.3;
+
+  var blocks = 0;
+  var dcI = 0;
+  var dcQ = 0;
+  var powerI = 0;
+  var powerQ = 0;
+  var cross = 0;
+
+  // Corrected I = I - dcI; corrected Q = (Q - dcQ) * qGain + (I - dcI) * qMix.
+  var qGain = 1;
+  var qMix = 0;
+
+  /**
+   * Adds the statistics of a block to the running estimates, and updates
+   * the correction coefficients.
+   * @param {number} n The number of samples measured.
+   * @param {number} sumI The sum of the I components.
+   * @param {number} sumQ The sum of the Q components.
+   * @param {number} sumII The sum of the squares of the I components.
+   * @param {number} sumQQ The sum of the squares of the Q components.
+   * @param {number} sumIQ The sum of the products of the I and Q components.
+   */
+  function addStats(n, sumI, sumQ, sumII, sumQQ, sumIQ) {
+    if (n == 0) {
+      return;
+    }
+    var mI = sumI / n;
+    var mQ = sumQ / n;
+    var vI = sumII / n - mI * mI;
+    var vQ = sumQQ / n - mQ * mQ;
+    var cIQ = sumIQ / n - mI * mQ;
+    var w = blocks++ == 0 ? 0 : WEIGHT;
+    dcI = (w * dcI + mI) / (w + 1);
+    dcQ = (w * dcQ + mQ) / (w + 1);
+    powerI = (w * powerI + vI) / (w + 1);
+    powerQ = (w * powerQ + vQ) / (w + 1);
+    cross = (w * cross + cIQ) / (w + 1);
+    if (powerI <= 0 || powerQ <= 0) {
+      qGain = 1;
+      qMix = 0;
+      return;
+    }
+    var gain = Math.sqrt(powerQ / powerI);
+    var sine = cross / Math.sqrt(powerI * powerQ);
+    sine = Math.max(-MAX_PHASE_SINE, Math.min(MAX_PHASE_SINE, sine));
+    var cosine = Math.sqrt(1 - sine * sine);
+    qGain = 1 / (gain * cosine);
+    qMix = -sine / cosine;
+  }
+
+  /**
+   * Converts the given buffer of unsigned 8-bit samples into a pair of
+   * corrected 32-bit floating-point sample streams, optionally shifting
+   * them up in frequency by a multiple of a quarter of the sample rate.
+   *
+   * A shift by a quarter of the sample rate multiplies consecutive samples
+   * by 1, j, -1 and -j, so it only needs swapping I and Q and changing
+   * their signs, which costs next to nothing when done during the
+   * conversion. The samples are corrected before they are shifted, since
+   * the offset and imbalance are the tuner's.
+   * @param {ArrayBuffer} buffer A buffer containing the unsigned 8-bit
+   *     samples.
+   * @param {number} quarters The number of quarters of the sample rate to
+   *     shift the samples up by.
+   * @param {number} phase The phase of the first sample, in quarter turns.
+   * @param {number} channelOffset The frequency of the channel being
+   *     received, relative to the center frequency.
+   * @return {Array} An array containing the I stream, the Q stream, and the
+   *     phase of the sample after the last one, in quarter turns.
+   */
+  function convert(buffer, quarters, phase, channelOffset) {
+    var arr = new Uint8Array(buffer);
+    var len = arr.length / 2;
+    var outI = new Float32Array(len);
+    var outQ = new Float32Array(len);
+    var active = Math.abs(channelOffset) >= MIN_CHANNEL_OFFSET;
+    var gain = active ? qGain : 1;
+    var mix = active ? qMix : 0;
+    var iAdd = -0.995 - (active ? dcI : 0);
+    var qAdd = (-0.995 - (active ? dcQ : 0)) * gain + iAdd * mix;
+    var qQMul = gain / 128;
+    var qIMul = mix / 128;
+    var step = quarters & 3;
+    var turn = phase & 3;
+    if (step == 0) {
+      for (var i = 0; i < len; ++i) {
+        var a = arr[2 * i];
+        outI[i] = a / 128 + iAdd;
+        outQ[i] = arr[2 * i + 1] * qQMul + a * qIMul + qAdd;
+      }
+    } else {
+      for (var i = 0; i < len; ++i) {
+        var a = arr[2 * i];
+        var I = a / 128 + iAdd;
+        var Q = arr[2 * i + 1] * qQMul + a * qIMul + qAdd;
+        switch (turn) {
+          case 0:
+            outI[i] = I;
+            outQ[i] = Q;
+            break;
+          case 1:
+            outI[i] = -Q;
+            outQ[i] = I;
+            break;
+          case 2:
+            outI[i] = -I;
+            outQ[i] = -Q;
+            break;
+          default:
+            outI[i] = Q;
+            outQ[i] = -I;
+            break;
+        }
+        turn = (turn + step) & 3;
+      }
+    }
+    if (!active) {
+      return [outI, outQ, turn];
+    }
+
+    var sumI = 0;
+    var sumQ = 0;
+    var sumII = 0;
+    var sumQQ = 0;
+    var sumIQ = 0;
+    var n = Math.ceil(len / STATS_FRACTION);
+    for (var i = 0; i < n; ++i) {
+      var I = arr[2 * i] / 128 - 0.995;
+      var Q = arr[2 * i + 1] / 128 - 0.995;
+      sumI += I;
+      sumQ += Q;
+      sumII += I * I;
+      sumQQ += Q * Q;
+      sumIQ += I * Q;
+    }
+    addStats(n, sumI, sumQ, sumII, sumQQ, sumIQ);
+    return [outI, outQ, turn];
+  }
+
+  /**
+   * Corrects a block of floating-point samples in place, for samples that
+   * don't come straight from the tuner, such as those read from a file.
+   * @param {Float32Array} samplesI The I components of the samples.
+   * @param {Float32Array} samplesQ The Q components of the samples.
+   * @param {number} channelOffset The frequency of the channel being
+   *     received, relative to the center frequency.
+   */
+  function correct(samplesI, samplesQ, channelOffset) {
+    if (Math.abs(channelOffset) < MIN_CHANNEL_OFFSET) {
+      return;
+    }
+    var len = samplesI.length;
+    var sumI = 0;
+    var sumQ = 0;
+    var sumII = 0;
+    var sumQQ = 0;
+    var sumIQ = 0;
+    var n = Math.ceil(len / STATS_FRACTION);
+    for (var i = 0; i < n; ++i) {
+      var I = samplesI[i];
+      var Q = samplesQ[i];
+      sumI += I;
+      sumQ += Q;
+      sumII += I * I;
+      sumQQ += Q * Q;
+      sumIQ += I * Q;
+    }
+    var qAdd = -dcQ * qGain - dcI * qMix;
+    for (var i = 0; i < len; ++i) {
+      var I = samplesI[i];
+      samplesQ[i] = samplesQ[i] * qGain + I * qMix + qAdd;
+      samplesI[i] = I - dcI;
+    }
+    addStats(n, sumI, sumQ, sumII, sumQQ, sumIQ);
+  }
+
+  /**
+   * Returns the current estimates of the offset and imbalance.
+   * @return {{dcI:number,dcQ:number,gain:number,phase:number}} The DC
+   *     offsets of I and Q, the gain of Q relative to I, and the phase
+   *     error of Q in radians.
+   */
+  function getEstimates() {
+    var sine = -qMix / Math.sqrt(1 + qMix * qMix);
+    return {
+      dcI: dcI,
+      dcQ: dcQ,
+      gain: powerI > 0 ? Math.sqrt(powerQ / powerI) : 1,
+      phase: Math.asin(sine)
+    };
+  }
+
+  return {
+    convert: convert,
+    correct: correct,
+    getEstimates: getEstimates
+  };
+}
+
+/**
+ * Scales an oscillator's cosine and sine back onto the unit circle. The
+ * oscillators are advanced by complex multiplication, and rounding errors
+ * would slowly change their amplitude, so they are normalized after each
+ * block of samples.
+ * @param {number} cosine The oscillator's cosine.
+ * @param {number} sine The oscillator's sine.
+ * @return {Array.<number>} The normalized cosine and sine.
+ */
+function normalizeOscillator(cosine, sine) {
+  var norm = Math.sqrt(cosine * cosine + sine * sine);
+  return [cosine / norm, sine / norm];
+}
+
 /**
  * Shifts a series of IQ samples by a given frequency.
  * @param {Array.<Float32Array>} IQ An array containing the I and Q streams.
@@ -572,6 +869,222 @@ function shiftFrequency(IQ, freq, sampleRate, cosine, sine) {
     cosine = cosine * deltaCos - sine * deltaSin;
     sine = newSine;
   }
-  return [oI, oQ, cosine, sine];
+  var osc = normalizeOscillator(cosine, sine);
+  return [oI, oQ, osc[0], osc[1]];
+}
+
+/**
+ * Converts a pair of 32-bit floating-point sample streams into a buffer of
+ * interleaved signed 16-bit samples.
+ * @param {Float32Array} samplesI The I stream.
+ * @param {Float32Array} samplesQ The Q stream.
+ * @return {Int16Array} The interleaved samples.
+ */
+function iqSamplesToInt16(samplesI, samplesQ) {
+  var out = new Int16Array(samplesI.length * 2);
+  for (var i = 0; i < samplesI.length; ++i) {
+    out[2 * i] = Math.max(-1, Math.min(1, samplesI[i])) * 32767;
+    out[2 * i + 1] = Math.max(-1, Math.min(1, samplesQ[i])) * 32767;
+  }
+  return out;
+}
+
+/**
+ * Computes the discrete Fourier transform of a series of complex samples,
+ * in place.
+ * @param {Float32Array} re The real parts of the samples. Their number must
+ *     be a power of two.
+ * @param {Float32Array} im The imaginary parts of the samples.
+ */
+function fft(re, im) {
+  var n = re.length;
+  for (var i = 1, j = 0; i < n; ++i) {
+    var bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      var t = re[i];
+      re[i] = re[j];
+      re[j] = t;
+      t = im[i];
+      im[i] = im[j];
+      im[j] = t;
+    }
+  }
+  for (var len = 2; len <= n; len <<= 1) {
+    var half = len >> 1;
+    var stepCos = Math.cos(-2 * Math.PI / len);
+    var stepSin = Math.sin(-2 * Math.PI / len);
+    for (var start = 0; start < n; start += len) {
+      var wCos = 1;
+      var wSin = 0;
+      for (var k = 0; k < half; ++k) {
+        var a = start + k;
+        var b = a + half;
+        var bRe = re[b] * wCos - im[b] * wSin;
+        var bIm = re[b] * wSin + im[b] * wCos;
+        re[b] = re[a] - bRe;
+        im[b] = im[a] - bIm;
+        re[a] += bRe;
+        im[a] += bIm;
+        var newSin = wCos * stepSin + wSin * stepCos;
+        wCos = wCos * stepCos - wSin * stepSin;
+        wSin = newSin;
+      }
+    }
+  }
+}
+
+/**
+ * Finds the strongest steady carrier within a range of frequencies, to
+ * measure how far off the tuner is.
+ *
+ * It removes the samples' mean, so the tuner's DC offset is not taken for a
+ * carrier, and computes the spectrum of up to 131072 samples with a Hann
+ * window. The carrier's frequency is interpolated between the strongest bin
+ * and its neighbours with a parabola fitted to the logarithm of their
+ * power, which is accurate to a small fraction of a bin.
+ * @param {Float32Array} samplesI The I components of the samples.
+ * @param {Float32Array} samplesQ The Q components of the samples.
+ * @param {number} sampleRate The sample rate.
+ * @param {number} center The frequency where the carrier should be.
+ * @param {number} width How far from the center frequency to look.
+ * @return {{offset:number,snr:number}} The carrier's distance from the
+ *     center frequency, and how much stronger it is than the median of the
+ *     bins in the range, in dB.
+ */
+function findCarrier(samplesI, samplesQ, sampleRate, center, width) {
+  var n = 1;
+  while (n * 2 <= Math.min(samplesI.length, 131072)) {
+    n *= 2;
+  }
+  var meanI = 0;
+  var meanQ = 0;
+  for (var i = 0; i < n; ++i) {
+    meanI += samplesI[i];
+    meanQ += samplesQ[i];
+  }
+  meanI /= n;
+  meanQ /= n;
+  var re = new Float32Array(n);
+  var im = new Float32Array(n);
+  for (var i = 0; i < n; ++i) {
+    var w = 0.5 - 0.5 * Math.cos(2 * Math.PI * i / n);
+    re[i] = (samplesI[i] - meanI) * w;
+    im[i] = (samplesQ[i] - meanQ) * w;
+  }
+  fft(re, im);
+
+  var binWidth = sampleRate / n;
+  var first = Math.ceil((center - width) / binWidth);
+  var last = Math.floor((center + width) / binWidth);
+  function power(bin) {
+    var k = ((bin % n) + n) % n;
+    return re[k] * re[k] + im[k] * im[k] + 1e-30;
+  }
+  var powers = [];
+  var peak = first;
+  for (var bin = first; bin <= last; ++bin) {
+    var p = power(bin);
+    powers.push(p);
+    if (p > power(peak)) {
+      peak = bin;
+    }
+  }
+  powers.sort(function(a, b) { return a - b; });
+  var median = powers[powers.length >> 1];
+
+  var left = Math.log(power(peak - 1));
+  var middle = Math.log(power(peak));
+  var right = Math.log(power(peak + 1));
+  var curve = left - 2 * middle + right;
+  var delta = curve < 0 ? 0.5 * (left - right) / curve : 0;
+  return {
+    offset: (peak + delta) * binWidth - center,
+    snr: 10 * Math.log(power(peak) / median) / Math.LN10
+  };
 }
 
+/**
+ * Measures the power in some channels, for the occupancy log and the
+ * preset scanner, which check all the channels in the tuner's span at once.
+ *
+ * It removes the samples' mean, like findCarrier, and averages the spectra
+ * of up to 32 Hann-windowed stretches spread over the block, each one just
+ * long enough to have at least 8 bins per channel. The power of the bins that
+ * overlap a channel is added up, in proportion to the overlap, and scaled
+ * so that a full-scale carrier measures 0 dB and noise measures the power
+ * that falls within the channel. The noise level is what a channel would
+ * measure if all its bins had the median power of the spectrum.
+ * @param {Float32Array} samplesI The I components of the samples.
+ * @param {Float32Array} samplesQ The Q components of the samples.
+ * @param {number} sampleRate The sample rate.
+ * @param {Array.<number>} offsets The frequencies of the channels' centers,
+ *     relative to the center frequency.
+ * @param {number} width The width of the channels.
+ * @return {{powers:Float32Array,noise:number}} The power in each channel,
+ *     and the noise level, in dB.
+ */
+function measureChannelPowers(samplesI, samplesQ, sampleRate, offsets,
+                              width) {
+  var n = 64;
+  while (n < 8 * sampleRate / width && n * 2 <= samplesI.length) {
+    n *= 2;
+  }
+  var meanI = 0;
+  var meanQ = 0;
+  for (var i = 0; i < samplesI.length; ++i) {
+    meanI += samplesI[i];
+    meanQ += samplesQ[i];
+  }
+  meanI /= samplesI.length;
+  meanQ /= samplesQ.length;
+  var window = new Float32Array(n);
+  var windowPower = 0;
+  for (var i = 0; i < n; ++i) {
+    window[i] = 0.5 - 0.5 * Math.cos(2 * Math.PI * i / n);
+    windowPower += window[i] * window[i];
+  }
+  var spectrum = new Float64Array(n);
+  var re = new Float32Array(n);
+  var im = new Float32Array(n);
+  var stretches = Math.min(32, Math.floor(samplesI.length / n));
+  var distance = Math.floor(samplesI.length / Math.max(1, stretches));
+  for (var s = 0; s < stretches; ++s) {
+    var start = s * distance;
+    for (var i = 0; i < n; ++i) {
+      re[i] = (samplesI[start + i] - meanI) * window[i];
+      im[i] = (samplesQ[start + i] - meanQ) * window[i];
+    }
+    fft(re, im);
+    for (var i = 0; i < n; ++i) {
+      spectrum[i] += re[i] * re[i] + im[i] * im[i];
+    }
+  }
+  var scale = 1 / (Math.max(1, stretches) * n * windowPower);
+
+  var binWidth = sampleRate / n;
+  var powers = new Float32Array(offsets.length);
+  for (var c = 0; c < offsets.length; ++c) {
+    var low = (offsets[c] - width / 2) / binWidth;
+    var high = (offsets[c] + width / 2) / binWidth;
+    var power = 0;
+    for (var bin = Math.round(low); bin <= Math.round(high); ++bin) {
+      var overlap = Math.min(high, bin + 0.5) - Math.max(low, bin - 0.5);
+      if (overlap > 0) {
+        power += overlap * spectrum[((bin % n) + n) % n];
+      }
+    }
+    powers[c] = 10 * Math.log(power * scale + 1e-30) / Math.LN10;
+  }
+  var sorted = Array.prototype.slice.call(spectrum).sort(function(a, b) {
+    return a - b;
+  });
+  var noise = sorted[n >> 1] * scale * width / binWidth;
+  return {
+    powers: powers,
+    noise: 10 * Math.log(noise + 1e-30) / Math.LN10
+  };
+}
@@ -25,8 +25,19 @@ function startEstimating() {
 }
 
 function showPpmEstimate() {
-  ppm.value = mainWindow.window['radio'].getPpmEstimate();
-  if (mainWindow.window['radio'].isEstimatingPpm()) {
+  var estimate = mainWindow.window['radio'].getPpmEstimate();
+  var estimating = mainWindow.window['radio'].isEstimatingPpm();
+  ppm.value = estimate.ppm;
+  if (isNaN(estimate.error)) {
+    precision.textContent = estimating ? 'Measuring...' :
+        'No carrier was found. Please try a stronger station.';
+  } else {
+    precision.textContent = 'Precision: \u00b1' +
+        (isFinite(estimate.error) ? estimate.error.toFixed(1) : '?') +
+        ' PPM, measured on the station\'s ' +
+        (estimate.carrier ? 'carrier.' : 'audio.');
+  }
+  if (estimating) {
     setTimeout(showPpmEstimate, 200);
   }
 }
@@ -111,6 +111,15 @@ var DefaultModes = {
   },
   'WBFM': {
     modulation: 'WBFM'
+  },
+  'ADSB': {
+    modulation: 'ADSB'
+  },
+  'APT': {
+    modulation: 'APT'
+  },
+  'AIS': {
+    modulation: 'AIS'
   }
 };
 
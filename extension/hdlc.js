@@ -0,0 +1,114 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A deframer for the HDLC frames that AX.25 (APRS) and AIS
+ * use.
+ */
+
+/**
+ * A class to find the HDLC frames in a stream of bits.
+ *
+ * The frames are delimited by flags (01111110), a zero is stuffed after
+ * every five ones inside a frame, and seven ones in a row abort it. The
+ * bytes are sent least significant bit first, and end with a CRC-16 frame
+ * check sequence; only the frames with a good checksum are passed on.
+ * @param {number} minLength The length of the shortest frame, in bytes,
+ *     including its checksum.
+ * @param {number} maxLength The length of the longest frame, in bytes,
+ *     including its checksum.
+ * @param {function(Uint8Array, number)} onFrame A function that receives
+ *     the buffer containing each frame and the frame's length, including
+ *     its checksum. The buffer is reused for the next frame.
+ * @constructor
+ */
+function HdlcDeframer(minLength, maxLength, onFrame) {
+  var FCS_RESIDUE = 0xf0b8;
+
+  var crcTable = new Uint16Array(256);
+  for (var i = 0; i < 256; ++i) {
+    var crc = i;
+    for (var j = 0; j < 8; ++j) {
+      crc = crc & 1 ? (crc >>> 1) ^ 0x8408 : crc >>> 1;
+    }
+    crcTable[i] = crc;
+  }
+
+  var shift = 0;
+  var ones = 0;
+  var inFrame = false;
+  var frame = new Uint8Array(maxLength);
+  var frameLength = 0;
+  var frameByte = 0;
+  var frameBits = 0;
+
+  /**
+   * Finds the flags in the bits, removes the stuffed bits, and collects the
+   * frames' bytes.
+   * @param {number} bit The decoded bit.
+   */
+  function receiveBit(bit) {
+    shift = (shift >>> 1) | (bit << 7);
+    if (shift == 0x7e) {
+      if (inFrame && frameBits == 7 && frameLength >= minLength) {
+        receiveFrame();
+      }
+      inFrame = true;
+      frameLength = 0;
+      frameBits = 0;
+      ones = 0;
+      return;
+    }
+    if (bit) {
+      if (++ones > 6) {
+        inFrame = false;
+      }
+    } else {
+      var stuffed = ones == 5;
+      ones = 0;
+      if (stuffed) {
+        return;
+      }
+    }
+    if (!inFrame) {
+      return;
+    }
+    frameByte = (frameByte >>> 1) | (bit << 7);
+    if (++frameBits == 8) {
+      frameBits = 0;
+      if (frameLength == maxLength) {
+        inFrame = false;
+      } else {
+        frame[frameLength++] = frameByte;
+      }
+    }
+  }
+
+  /**
+   * Checks a frame's checksum and passes it on if it's good.
+   */
+  function receiveFrame() {
+    var crc = 0xffff;
+    for (var i = 0; i < frameLength; ++i) {
+      crc = (crc >>> 8) ^ crcTable[(crc ^ frame[i]) & 0xff];
+    }
+    if (crc == FCS_RESIDUE) {
+      onFrame(frame, frameLength);
+    }
+  }
+
+  return {
+    receiveBit: receiveBit
+  };
+}
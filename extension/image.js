@@ -0,0 +1,87 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+var context = imageCanvas.getContext('2d');
+var row = null;
+var drawnId = null;
+var drawnLines = 0;
+
+function exit() {
+  AuxWindows.closeCurrent();
+}
+
+function findRadio() {
+  var windows = chrome.app.window.getAll();
+  var found = null;
+  for (var i = 0; i < windows.length; ++i) {
+    var radio = windows[i].contentWindow['radio'];
+    if (radio && radio.getImage) {
+      if (radio.getMode().modulation == 'APT') {
+        return radio;
+      }
+      found = found || radio;
+    }
+  }
+  return found;
+}
+
+function showImage() {
+  var radio = findRadio();
+  var image = radio && radio.getImage();
+  if (!image || !image.pixels) {
+    statusText.textContent = 'No image has been received yet.';
+    return;
+  }
+  if (imageCanvas.height != image.maxLines) {
+    imageCanvas.width = image.width;
+    imageCanvas.height = image.maxLines;
+    row = context.createImageData(image.width, 1);
+    drawnId = null;
+  }
+  if (image.id != drawnId || image.lines < drawnLines) {
+    context.clearRect(0, 0, imageCanvas.width, imageCanvas.height);
+    drawnId = image.id;
+    drawnLines = 0;
+  }
+  // Only the lines that arrived since the last time are drawn.
+  var first = Math.max(drawnLines, image.lines - image.maxLines);
+  for (var line = first; line < image.lines; ++line) {
+    var y = line % image.maxLines;
+    var offset = y * image.width;
+    for (var x = 0; x < image.width; ++x) {
+      var value = image.pixels[offset + x];
+      row.data[4 * x] = value;
+      row.data[4 * x + 1] = value;
+      row.data[4 * x + 2] = value;
+      row.data[4 * x + 3] = 255;
+    }
+    context.putImageData(row, 0, y);
+  }
+  drawnLines = image.lines;
+  statusText.textContent = image.lines + ' lines received.';
+}
+
+function clearImage() {
+  var radio = findRadio();
+  if (radio) {
+    radio.clearImage();
+  }
+  showImage();
+}
+
+clearButton.addEventListener('click', clearImage);
+closeButton.addEventListener('click', exit);
+
+showImage();
+setInterval(showImage, 1000);
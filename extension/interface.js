@@ -15,14 +15,25 @@
 /**
  * UI controller.
  * @param {RadioController} fmRadio The FM radio controller object.
+ * @param {number=} opt_deviceIndex The index of the radio's USB tuner.
  * @constructor
  */
-function Interface(fmRadio) {
+function Interface(fmRadio, opt_deviceIndex) {
+
+  /**
+   * The index of the radio's USB tuner.
+   */
+  var deviceIndex = opt_deviceIndex || 0;
 
   /**
    * The application state and configuration.
    */
-  var appConfig = new AppConfig();
+  var appConfig = new AppConfig(deviceIndex);
+
+  /**
+   * The tuner whose radio is the only one that can be heard, or -1.
+   */
+  var soloDevice = -1;
 
   /**
    * The station presets.
@@ -34,79 +45,207 @@ function Interface(fmRadio) {
    */
   var currentBand = Bands['WW']['FM'];
 
+  /**
+   * The capture file being played back, if any.
+   */
+  var filePlayer = null;
+
+  /**
+   * The interval between measurements in the occupancy log, in
+   * milliseconds.
+   */
+  var OCCUPANCY_INTERVAL = 1000;
+
+  /**
+   * The values the UI is showing, so that updates only touch the elements
+   * whose values have changed.
+   */
+  var shown = {};
+
+  /**
+   * Whether an update of the UI is waiting for the next animation frame.
+   */
+  var updatePending = false;
+
+  /**
+   * How many updates were requested and applied, and how long it took to
+   * apply them, in milliseconds.
+   */
+  var updateStats = {requested: 0, applied: 0, totalTime: 0, maxTime: 0};
+
   /**
    * Updates the UI.
+   *
+   * The radio asks for updates often, for example on every step of a scan,
+   * so they are coalesced and applied in the next animation frame, and
+   * only the elements that changed are touched. This keeps the main thread
+   * free to schedule the audio.
    */
   function update() {
-    setVisible(powerOffButton, fmRadio.isPlaying());
-    setVisible(powerOnButton, !fmRadio.isPlaying());
+    appConfig.state.frequency.set(getFrequency());
+    ++updateStats.requested;
+    if (!updatePending) {
+      updatePending = true;
+      requestAnimationFrame(applyUpdate);
+    }
+  }
+
+  /**
+   * Applies the pending update to the UI.
+   */
+  function applyUpdate() {
+    var startTime = performance.now();
+    updatePending = false;
+
+    showPower(fmRadio.isPlaying());
 
     var frequency = getFrequency();
-    appConfig.state.frequency.set(frequency);
-    frequencyDisplay.textContent = currentBand.toDisplayName(frequency);
-
-    if (fmRadio.isStereoEnabled()) {
-      stereoEnabledIndicator.classList.remove('stereoDisabled');
-      if (fmRadio.isStereo()) {
-        stereoActiveIndicator.classList.remove('stereoUnavailable');
-      } else {
-        stereoActiveIndicator.classList.add('stereoUnavailable');
-      }
-    } else {
-      stereoEnabledIndicator.classList.add('stereoDisabled');
-      stereoActiveIndicator.classList.add('stereoUnavailable');
+    var mode = currentBand.getMode();
+    if (changed('frequency', currentBand.toDisplayName(frequency))) {
+      frequencyDisplay.textContent = shown['frequency'];
     }
 
-    if (fmRadio.isScanning()) {
-      bandBox.classList.add('scanning');
-    } else {
-      bandBox.classList.remove('scanning');
+    var stereoEnabled = fmRadio.isStereoEnabled();
+    if (changed('stereoEnabled', stereoEnabled)) {
+      setClass(stereoEnabledIndicator, 'stereoDisabled', !stereoEnabled);
+    }
+    if (changed('stereo', stereoEnabled && fmRadio.isStereo())) {
+      setClass(stereoActiveIndicator, 'stereoUnavailable', !shown['stereo']);
     }
 
-    if (isFreeTuning()) {
-      bandBox.textContent = 'ft';
-      bandBox.classList.add('freeTuning');
-      frequencyDisplay.classList.add('freeTuning');
-      frequencyInput.classList.add('freeTuning');
-      freeTuningStuff.classList.add('freeTuning');
-      var mode = currentBand.getMode();
-      for (var i = 0; i < modulationDisplay.options.length; ++i) {
-        var option = modulationDisplay.options[i];
-        if (option.value == mode.modulation && !option.selected) {
-          option.selected = true;
-          break;
+    var rds = fmRadio.getRds();
+    if (changed('rds', rds ? [rds.ps.trim(), rds.rt].filter(
+        function(text) { return text; }).join(' \u2014 ') : '')) {
+      rdsDisplay.textContent = shown['rds'];
+    }
+    if (changed('rdsPi', rds ? 'PI ' + ('000' + rds.pi.toString(16))
+        .slice(-4).toUpperCase() : '')) {
+      rdsDisplay.title = shown['rdsPi'];
+    }
+
+    if (changed('scanning', fmRadio.isScanning())) {
+      setClass(bandBox, 'scanning', shown['scanning']);
+    }
+
+    var freeTuning = isFreeTuning();
+    if (changed('freeTuning', freeTuning)) {
+      setClass(bandBox, 'freeTuning', freeTuning);
+      setClass(frequencyDisplay, 'freeTuning', freeTuning);
+      setClass(frequencyInput, 'freeTuning', freeTuning);
+      setClass(rdsDisplay, 'freeTuning', freeTuning);
+      setClass(freeTuningStuff, 'freeTuning', freeTuning);
+    }
+    if (changed('bandName', freeTuning ? 'ft' : currentBand.getName())) {
+      bandBox.textContent = shown['bandName'];
+    }
+    if (freeTuning) {
+      if (changed('modulation', mode.modulation)) {
+        for (var i = 0; i < modulationDisplay.options.length; ++i) {
+          var option = modulationDisplay.options[i];
+          if (option.value == mode.modulation && !option.selected) {
+            option.selected = true;
+            break;
+          }
         }
+        setVisible(bandwidthBox, mode.modulation == 'AM'
+                                 || mode.modulation == 'USB'
+                                 || mode.modulation == 'LSB');
+        setVisible(maxfBox, mode.modulation == 'NBFM');
+      }
+      if (changed('freqStep', currentBand.getStep())) {
+        freqStepDisplay.textContent = shown['freqStep'];
+      }
+      if (changed('bandwidth', Number(mode.bandwidth) || 0)) {
+        bandwidthDisplay.textContent = shown['bandwidth'];
+      }
+      if (changed('maxf', Number(mode.maxF) || 0)) {
+        maxfDisplay.textContent = shown['maxf'];
+      }
+      if (changed('upconverter', isUpconverterEnabled() ? 'On' : 'Off')) {
+        upconverterDisplay.textContent = shown['upconverter'];
+      }
+      if (changed('squelch', mode.squelch || 0)) {
+        squelchDisplay.textContent = shown['squelch'];
       }
-      freqStepDisplay.textContent = currentBand.getStep();
-      setVisible(bandwidthBox, mode.modulation == 'AM'
-                               || mode.modulation == 'USB'
-                               || mode.modulation == 'LSB');
-      bandwidthDisplay.textContent = Number(mode.bandwidth) || 0;
-      setVisible(maxfBox, mode.modulation == 'NBFM');
-      maxfDisplay.textContent = Number(mode.maxF) || 0;
-      upconverterDisplay.textContent = isUpconverterEnabled() ? 'On' : 'Off';
-      squelchDisplay.textContent = (mode.squelch || 0);
     } else {
-      bandBox.textContent = currentBand.getName();
-      bandBox.classList.remove('freeTuning');
-      frequencyDisplay.classList.remove('freeTuning');
-      frequencyInput.classList.remove('freeTuning');
-      freeTuningStuff.classList.remove('freeTuning');
+      delete shown['modulation'];
     }
-    
+
     var volume = Math.round(fmRadio.getVolume() * 100);
-    volumeLabel.textContent = volume;
-    volumeSlider.value = volume;
-    if (volume == 0) {
-      volumeLabel.classList.add('volumeMuted');
-    } else {
-      volumeLabel.classList.remove('volumeMuted');
+    if (changed('volume', volume)) {
+      volumeLabel.textContent = volume;
+      volumeSlider.value = volume;
+      setClass(volumeLabel, 'volumeMuted', volume == 0);
     }
 
-    setVisible(recordButton, !fmRadio.isRecording());
-    setVisible(stopButton, fmRadio.isRecording());
+    if (changed('recording', fmRadio.isRecording())) {
+      setVisible(recordButton, !shown['recording']);
+      setVisible(stopButton, shown['recording']);
+    }
 
-    selectCurrentPreset();
+    if (document.activeElement != presetsBox &&
+        changed('preset', [frequency, currentBand.getName(),
+                           mode.modulation].join(' '))) {
+      selectCurrentPreset();
+    }
+
+    var time = performance.now() - startTime;
+    ++updateStats.applied;
+    updateStats.totalTime += time;
+    updateStats.maxTime = Math.max(updateStats.maxTime, time);
+  }
+
+  /**
+   * Remembers a value shown in the UI.
+   * @param {string} key The value's name.
+   * @param {*} value The value that should be shown.
+   * @return {boolean} Whether the value is different from the one that
+   *     was shown, so the UI must be changed to show it.
+   */
+  function changed(key, value) {
+    if (key in shown && shown[key] === value) {
+      return false;
+    }
+    shown[key] = value;
+    return true;
+  }
+
+  /**
+   * Returns how many updates of the UI were requested and applied, and how
+   * long they took on average and at most, in milliseconds.
+   * @return {{requested:number,applied:number,averageTime:number,maxTime:number}}
+   *     The update statistics.
+   */
+  function getUpdateStats() {
+    return {
+      requested: updateStats.requested,
+      applied: updateStats.applied,
+      averageTime: updateStats.applied ?
+          updateStats.totalTime / updateStats.applied : 0,
+      maxTime: updateStats.maxTime
+    };
+  }
+
+  /**
+   * Shows the 'Power On' or the 'Power Off' button.
+   * @param {boolean} on Whether the radio is on.
+   */
+  function showPower(on) {
+    if (changed('power', on)) {
+      setVisible(powerOffButton, on);
+      setVisible(powerOnButton, !on);
+    }
+  }
+
+  /**
+   * Adds a class to an element or removes it.
+   */
+  function setClass(element, className, present) {
+    if (present) {
+      element.classList.add(className);
+    } else {
+      element.classList.remove(className);
+    }
   }
 
   /**
@@ -125,8 +264,7 @@ function Interface(fmRadio) {
    * Called when the 'Power On' button is pressed.
    */
   function powerOn() {
-    setVisible(powerOffButton, true);
-    setVisible(powerOnButton, false);
+    showPower(true);
     fmRadio.start();
   }
 
@@ -136,8 +274,7 @@ function Interface(fmRadio) {
    */
   function powerOff() {
     saveSettings();
-    setVisible(powerOffButton, false);
-    setVisible(powerOnButton, true);
+    showPower(false);
     if (fmRadio.isPlaying()) {
       fmRadio.stop();
     }
@@ -220,6 +357,34 @@ function Interface(fmRadio) {
         currentBand.getStep());
   }
 
+  /**
+   * Scans the saved stations in the current band and mode, staying on each
+   * one while it's active.
+   * Called when the 'k' or 'K' keys are pressed.
+   * @param {boolean} withPriority Whether to use the current frequency as
+   *     the priority channel, which is checked every few hundred
+   *     milliseconds and taken over as soon as it's active.
+   */
+  function scanPresets(withPriority) {
+    var saved = presets.get();
+    var channels = [];
+    for (var freq in saved) {
+      var preset = saved[freq];
+      if (preset['band'] == currentBand.getName() &&
+          preset['mode'].modulation == currentBand.getMode().modulation) {
+        channels.push(upconvert(Number(freq)));
+      }
+    }
+    var options = {};
+    if (withPriority) {
+      options['priority'] = fmRadio.getFrequency();
+      if (channels.indexOf(options['priority']) < 0) {
+        channels.push(options['priority']);
+      }
+    }
+    fmRadio.scanPresets(channels, options);
+  }
+
   /**
    * Enables or disables stereo.
    * Called when the stereo icon is clicked.
@@ -473,7 +638,19 @@ function Interface(fmRadio) {
       'gain': appConfig.settings.gain.get(),
       'useUpconverter': appConfig.settings.upconverter.isEnabled(),
       'upconverterFreq': appConfig.settings.upconverter.get(),
-      'enableFreeTuning': appConfig.settings.freeTuning.isEnabled()
+      'enableFreeTuning': appConfig.settings.freeTuning.isEnabled(),
+      'offsetTuning': appConfig.settings.offsetTuning.isEnabled(),
+      'driftTracking': appConfig.settings.driftTracking.isEnabled(),
+      'rds': appConfig.settings.rds.isEnabled(),
+      'aprs': appConfig.settings.aprs.isEnabled(),
+      'pocsag': appConfig.settings.pocsag.isEnabled(),
+      'tunerSource': appConfig.settings.tunerSource.getType(),
+      'tunerAddress': appConfig.settings.tunerSource.getAddress(),
+      'simulatedStations': appConfig.settings.tunerSource.getStations(),
+      'enableSharing': appConfig.settings.sharing.isEnabled(),
+      'sharingPort': appConfig.settings.sharing.getPort(),
+      'timeShiftMinutes': appConfig.settings.timeShift.getMinutes(),
+      'iqTimeShiftMegabytes': appConfig.settings.timeShift.getIqMegabytes()
     };
     AuxWindows.settings(settings);
   }
@@ -490,6 +667,20 @@ function Interface(fmRadio) {
     appConfig.settings.upconverter.enable(newSettings['useUpconverter']);
     appConfig.settings.upconverter.set(newSettings['upconverterFreq']);
     appConfig.settings.freeTuning.enable(newSettings['enableFreeTuning']);
+    appConfig.settings.offsetTuning.enable(newSettings['offsetTuning']);
+    appConfig.settings.driftTracking.enable(newSettings['driftTracking']);
+    appConfig.settings.rds.enable(newSettings['rds']);
+    appConfig.settings.aprs.enable(newSettings['aprs']);
+    appConfig.settings.pocsag.enable(newSettings['pocsag']);
+    appConfig.settings.tunerSource.setType(newSettings['tunerSource']);
+    appConfig.settings.tunerSource.setAddress(newSettings['tunerAddress']);
+    appConfig.settings.tunerSource.setStations(
+        newSettings['simulatedStations']);
+    appConfig.settings.sharing.enable(newSettings['enableSharing']);
+    appConfig.settings.sharing.setPort(newSettings['sharingPort']);
+    appConfig.settings.timeShift.setMinutes(newSettings['timeShiftMinutes']);
+    appConfig.settings.timeShift.setIqMegabytes(
+        newSettings['iqTimeShiftMegabytes']);
     restoreSettings();
     restoreStation();
     displayPresets();
@@ -505,8 +696,46 @@ function Interface(fmRadio) {
       fmRadio.setManualGain(appConfig.settings.gain.get());
     }
     fmRadio.setCorrectionPpm(appConfig.settings.ppm.get());
+    fmRadio.setOffsetTuning(appConfig.settings.offsetTuning.isEnabled());
+    fmRadio.setDriftTracking(appConfig.settings.driftTracking.isEnabled());
+    if (fmRadio.isRdsEnabled() != appConfig.settings.rds.isEnabled()) {
+      fmRadio.enableRds(appConfig.settings.rds.isEnabled());
+    }
+    fmRadio.enableDecoder('APRS', appConfig.settings.aprs.isEnabled());
+    fmRadio.enableDecoder('POCSAG', appConfig.settings.pocsag.isEnabled());
+    if (!filePlayer) {
+      fmRadio.setTunerFactory(getTunerFactory());
+    }
+    fmRadio.setSharingPort(appConfig.settings.sharing.isEnabled()
+        ? appConfig.settings.sharing.getPort() : 0);
+    fmRadio.setTimeShiftLength(
+        appConfig.settings.timeShift.getMinutes() * 60,
+        appConfig.settings.timeShift.getIqMegabytes() * 1048576);
   }
   
+  /**
+   * Returns a function that creates the tuner chosen in the settings.
+   * @return {?Function} The function, or null for the USB tuner.
+   */
+  function getTunerFactory() {
+    if (appConfig.settings.tunerSource.getType() == 'simulator') {
+      var stations = parseSimulatedStations(
+          appConfig.settings.tunerSource.getStations());
+      return function(ppm, gain) {
+        return new BandSimulator(stations, ppm, {realTime: true});
+      };
+    }
+    if (appConfig.settings.tunerSource.getType() != 'rtltcp') {
+      return null;
+    }
+    var address = appConfig.settings.tunerSource.getAddress().split(':');
+    var host = address[0] || 'localhost';
+    var port = Number(address[1]) || 1234;
+    return function(ppm, gain) {
+      return new RtlTcpClient(host, port, ppm, gain);
+    };
+  }
+
   /**
    * Returns whether the upconverter is enabled.
    * @return {boolean} Whether the upconverter is enabled.
@@ -723,6 +952,204 @@ function Interface(fmRadio) {
     fmRadio.stopRecording();
   }
 
+  /**
+   * Plays again the last 30 seconds of audio, or goes back to the live
+   * audio if it was already doing that.
+   */
+  function toggleReplay() {
+    if (fmRadio.isReplaying()) {
+      fmRadio.stopReplay();
+    } else {
+      fmRadio.replay(30);
+    }
+  }
+
+  /**
+   * Asks the user for a file and saves the last 5 minutes of audio into it.
+   */
+  function saveLastMinutes() {
+    var opt = {
+      type: 'saveFile',
+      suggestedName: (currentBand.toDisplayName(getFrequency(), true)
+                      + " - "
+                      + new Date().toLocaleString() + ".wav")
+                     .replace(/[:/\\]/g, '_')
+    };
+    chrome.fileSystem.chooseEntry(opt, function(entry) {
+      entry && fmRadio.saveTimeShift(entry, 300);
+    });
+  }
+
+  /**
+   * Asks the user for a file and saves the last 5 minutes of the I/Q
+   * signal into it.
+   */
+  function saveLastMinutesBaseband() {
+    if (!fmRadio.hasIqTimeShift()) {
+      return;
+    }
+    var opt = {
+      type: 'saveFile',
+      suggestedName: (currentBand.toDisplayName(getFrequency(), true)
+                      + " - "
+                      + new Date().toLocaleString() + " - IQ.wav")
+                     .replace(/[:/\\]/g, '_')
+    };
+    chrome.fileSystem.chooseEntry(opt, function(entry) {
+      entry && fmRadio.saveIqTimeShift(entry, 300);
+    });
+  }
+
+  /**
+   * Asks the user for the file to save the tuner's output into.
+   */
+  function startCapture() {
+    var opt = {
+      type: 'saveFile',
+      suggestedName: (currentBand.toDisplayName(getFrequency(), true)
+                      + " - "
+                      + new Date().toLocaleString() + ".rriq")
+                     .replace(/[:/\\]/g, '_')
+    };
+    chrome.fileSystem.chooseEntry(opt, doCapture);
+  }
+
+  /**
+   * Starts saving the tuner's output into a file.
+   */
+  function doCapture(entry) {
+    fmRadio.startCapture(entry);
+  }
+
+  /**
+   * Stops saving the tuner's output.
+   */
+  function stopCapture() {
+    fmRadio.stopCapture();
+  }
+
+  /**
+   * Asks the user for a capture file and starts playing it back.
+   */
+  function openCapture() {
+    chrome.fileSystem.chooseEntry({type: 'openFile'}, function(entry) {
+      if (!entry) {
+        return;
+      }
+      entry.file(function(file) {
+        var player = new IqFilePlayer(file);
+        switchTuner(player, function() { return player; }, true);
+      });
+    });
+  }
+
+  /**
+   * Stops playing back a capture file and goes back to the USB tuner.
+   */
+  function closeCapture() {
+    if (filePlayer) {
+      switchTuner(null, getTunerFactory(), fmRadio.isPlaying());
+    }
+  }
+
+  /**
+   * Restarts the radio with a different tuner.
+   * @param {IqFilePlayer} player The capture file player, if any.
+   * @param {?Function} factory The function that creates the tuner, or
+   *     null for the USB tuner.
+   * @param {boolean} restart Whether to start the radio afterwards.
+   */
+  function switchTuner(player, factory, restart) {
+    fmRadio.stop(function() {
+      filePlayer = player;
+      fmRadio.setTunerFactory(factory);
+      if (restart) {
+        fmRadio.start(function() {
+          if (filePlayer) {
+            setFrequency(downconvert(filePlayer.getCenterFrequency()), true);
+          }
+        });
+      }
+    });
+  }
+
+  /**
+   * Moves the capture file's playback position.
+   * @param {number} seconds The number of seconds to move.
+   */
+  function seekCapture(seconds) {
+    if (filePlayer) {
+      filePlayer.seekBy(seconds * filePlayer.getSpeed());
+    }
+  }
+
+  /**
+   * Changes the capture file's playback speed.
+   * @param {number} factor The factor to multiply the speed by.
+   */
+  function changeCaptureSpeed(factor) {
+    if (filePlayer) {
+      filePlayer.setSpeed(Math.min(32, filePlayer.getSpeed() * factor));
+    }
+  }
+
+  /**
+   * Asks the user for the file to log the channels' occupancy into. An
+   * existing log for the same channels is continued.
+   */
+  function startOccupancyLog() {
+    var opt = {
+      type: 'saveFile',
+      suggestedName: (currentBand.toDisplayName(getFrequency(), true)
+                      + " - Occupancy.rroc")
+                     .replace(/[:/\\]/g, '_')
+    };
+    chrome.fileSystem.chooseEntry(opt, doOccupancyLog);
+  }
+
+  /**
+   * Starts logging the occupancy of the band's channels into a file.
+   */
+  function doOccupancyLog(entry) {
+    fmRadio.startOccupancyLog(entry, currentBand.getStep(),
+                              OCCUPANCY_INTERVAL);
+  }
+
+  /**
+   * Stops logging the channels' occupancy.
+   */
+  function stopOccupancyLog() {
+    fmRadio.stopOccupancyLog();
+  }
+
+  /**
+   * Asks the user for the file to record the I/Q signal into.
+   */
+  function startBasebandRecording() {
+    var opt = {
+      type: 'saveFile',
+      suggestedName: (currentBand.toDisplayName(getFrequency(), true)
+                      + " - "
+                      + new Date().toLocaleString() + " - IQ.wav")
+                     .replace(/[:/\\]/g, '_')
+    };
+    chrome.fileSystem.chooseEntry(opt, doRecordBaseband);
+  }
+
+  /**
+   * Starts recording the I/Q signal into a file.
+   */
+  function doRecordBaseband(entry) {
+    fmRadio.startBasebandRecording(entry);
+  }
+
+  /**
+   * Stops recording the I/Q signal.
+   */
+  function stopBasebandRecording() {
+    fmRadio.stopBasebandRecording();
+  }
+
   /**
    * Shows an error window with the given message.
    * @param {string} msg The message to show.
@@ -746,6 +1173,9 @@ function Interface(fmRadio) {
       saveSettings();
     } else if (type == 'exit') {
       close();
+    } else if (type == 'solo') {
+      soloDevice = data;
+      fmRadio.setMuted(soloDevice != -1 && soloDevice != deviceIndex);
     }
   }
 
@@ -757,6 +1187,21 @@ function Interface(fmRadio) {
     e.stopPropagation();
   }
 
+  /**
+   * Makes this radio the only one that can be heard, or lets all the radios
+   * be heard again if it already was.
+   */
+  function toggleSolo() {
+    var msg = {
+      'type': 'solo',
+      'data': soloDevice == deviceIndex ? -1 : deviceIndex
+    };
+    var windows = chrome.app.window.getAll();
+    for (var i = 0; i < windows.length; ++i) {
+      windows[i].contentWindow.postMessage(msg, '*');
+    }
+  }
+
   /**
    * Shows the help window.
    */
@@ -831,6 +1276,72 @@ function Interface(fmRadio) {
         case 87:  // W
           stopRecording();
           break;
+        case 105: // i
+          startBasebandRecording();
+          break;
+        case 73:  // I
+          stopBasebandRecording();
+          break;
+        case 110: // n
+          AuxWindows.newRadio();
+          break;
+        case 109: // m
+          toggleSolo();
+          break;
+        case 77:  // M
+          AuxWindows.monitor();
+          break;
+        case 100: // d
+          AuxWindows.messages();
+          break;
+        case 103: // g
+          AuxWindows.image();
+          break;
+        case 114: // r
+          toggleReplay();
+          break;
+        case 104: // h
+          saveLastMinutes();
+          break;
+        case 72:  // H
+          saveLastMinutesBaseband();
+          break;
+        case 99:  // c
+          startCapture();
+          break;
+        case 67:  // C
+          stopCapture();
+          break;
+        case 107: // k
+          scanPresets(false);
+          break;
+        case 75:  // K
+          scanPresets(true);
+          break;
+        case 117: // u
+          startOccupancyLog();
+          break;
+        case 85:  // U
+          stopOccupancyLog();
+          break;
+        case 111: // o
+          openCapture();
+          break;
+        case 79:  // O
+          closeCapture();
+          break;
+        case 106: // j
+          seekCapture(-10);
+          break;
+        case 108: // l
+          seekCapture(10);
+          break;
+        case 91:  // [
+          changeCaptureSpeed(0.5);
+          break;
+        case 93:  // ]
+          changeCaptureSpeed(2);
+          break;
         case 32:
           togglePower();
           break;
@@ -939,14 +1450,21 @@ function Interface(fmRadio) {
 
   return {
     attach: attach,
-    update: update
+    update: update,
+    getUpdateStats: getUpdateStats
   };
 }
 
-var radio = new RadioController();
-var iface = new Interface(radio);
+var deviceIndex = Number((location.hash.match(/device=(\d+)/) || [])[1]) || 0;
+var radio = new RadioController(deviceIndex);
+var iface = new Interface(radio, deviceIndex);
 
 window.addEventListener('load', function() {
+  if (deviceIndex > 0) {
+    var suffix = ' (tuner ' + (deviceIndex + 1) + ')';
+    document.title += suffix;
+    document.querySelector('.titleText').textContent += suffix;
+  }
   AuxWindows.resizeCurrentTo(500, 225);
   iface.attach();
 });
@@ -0,0 +1,479 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview Functions to save and play back the tuner's output.
+ *
+ * The capture files have a 64-byte header, followed by the unsigned 8-bit
+ * I/Q samples as they come from the tuner, followed by an index.
+ *
+ * The header contains these little-endian fields:
+ *   0: uint32  "RRIQ"
+ *   4: uint32  Version (1)
+ *   8: uint32  Header size (64)
+ *  12: uint32  Sample rate
+ *  16: uint32  Size of each index entry (32)
+ *  20: uint32  Number of index entries (0 until the capture is finished)
+ *  24: float64 Position of the index in the file (0 until it's finished)
+ *  32: float64 Start time, in milliseconds since the epoch
+ *  40: float64 Center frequency at the start
+ *
+ * Each index entry consists of 4 float64 numbers: the number of the first
+ * sample in a block, the time the block was received (in milliseconds since
+ * the epoch), the tuner's center frequency, and the gain (-1 for automatic).
+ * There is an index entry for every block, so an entry can be found from a
+ * time or a sample number in constant time.
+ */
+
+/**
+ * A class to save the tuner's output into a capture file.
+ * @param {FileEntry} fileEntry An entry for the capture file.
+ * @param {number} sampleRate The sample rate.
+ * @param {number} frequency The center frequency at the start.
+ * @constructor
+ */
+function IqFileWriter(fileEntry, sampleRate, frequency) {
+
+  var HEADER_SIZE = 64;
+  var ENTRY_SIZE = 32;
+
+  var fileWriter;
+  var queue = [];
+  var writing = true;
+  var startTime = Date.now();
+  var sampleCount = 0;
+  var index = [];
+
+  queue.push(new Blob([createHeader(0, 0)]));
+  fileEntry.createWriter(function(writer) {
+    fileWriter = writer;
+    writer.onwriteend = processQueue;
+    writer.onerror = processError;
+    processQueue();
+  });
+
+  /**
+   * Writes the contents of the queue and schedules the next execution of
+   * this function, if the queue is empty. After finish() was called and
+   * the queue goes empty, writes the index, then fixes up the header and
+   * stops rescheduling.
+   */
+  function processQueue() {
+    if (queue == null) {
+      return;
+    }
+    if (queue.length == 0) {
+      if (writing) {
+        setTimeout(processQueue, 1000);
+      } else if (index != null) {
+        var entries = new Float64Array(index);
+        index = null;
+        fileWriter.write(new Blob([entries]));
+      } else {
+        var entryCount = (fileWriter.length - indexOffset()) / ENTRY_SIZE;
+        queue = null;
+        fileWriter.seek(0);
+        fileWriter.write(new Blob([createHeader(entryCount, indexOffset())]));
+      }
+      return;
+    }
+    var blob = new Blob(queue);
+    queue = [];
+    fileWriter.write(blob);
+  }
+
+  /**
+   * Empties the queue and stops writing.
+   */
+  function processError() {
+    writing = false;
+    queue = null;
+  }
+
+  /**
+   * Returns the position of the index in the file.
+   * @return {number} The position.
+   */
+  function indexOffset() {
+    return HEADER_SIZE + sampleCount * 2;
+  }
+
+  /**
+   * Creates the file header.
+   * @param {number} entryCount The number of index entries.
+   * @param {number} offset The position of the index in the file.
+   * @return {ArrayBuffer} The header.
+   */
+  function createHeader(entryCount, offset) {
+    var header = new ArrayBuffer(HEADER_SIZE);
+    new Uint32Array(header, 0, 6).set([
+      0x51495252,   // "RRIQ"
+      1,            // version
+      HEADER_SIZE,
+      sampleRate,
+      ENTRY_SIZE,
+      entryCount
+    ]);
+    new Float64Array(header, 24, 3).set([offset, startTime, frequency]);
+    return header;
+  }
+
+  /**
+   * Writes a block of samples. It copies the samples immediately, so the
+   * buffer can be transferred elsewhere afterwards.
+   * @param {ArrayBuffer} buffer The block of samples from the tuner.
+   * @param {number} centerFrequency The tuner's center frequency.
+   * @param {?number} gain The tuner's gain, or null for automatic gain.
+   */
+  function writeBlock(buffer, centerFrequency, gain) {
+    if (!writing) {
+      return;
+    }
+    index.push(sampleCount, Date.now(), centerFrequency,
+               gain == null ? -1 : gain);
+    sampleCount += buffer.byteLength / 2;
+    queue.push(new Blob([buffer]));
+  }
+
+  /**
+   * Finishes writing to the capture file.
+   */
+  function finish() {
+    writing = false;
+  }
+
+  /**
+   * Tells whether the class has finished writing to the capture file.
+   */
+  function hasFinished() {
+    return !writing;
+  }
+
+  return {
+    writeBlock: writeBlock,
+    finish: finish,
+    hasFinished: hasFinished
+  };
+}
+
+/**
+ * A tuner that plays back a capture file. It has the same interface as
+ * RTL2832U, so RadioController can use it instead of a real tuner, and it
+ * also supports seeking and fast-forwarding.
+ *
+ * Samples are delivered at the file's sample rate. After a seek, playback
+ * starts a little before the requested position so that the demodulator's
+ * filters have time to settle.
+ * @param {File} file The capture file.
+ * @constructor
+ */
+function IqFilePlayer(file) {
+
+  /**
+   * Seconds of signal to play before the position we seek to.
+   */
+  var WARMUP_TIME = 0.05;
+
+  var errorHandler;
+  var sampleRate = 0;
+  var dataStart = 0;
+  var dataEnd = 0;
+  var startTime = 0;
+  var startFrequency = 0;
+  var index = new Float64Array(0);
+  var position = 0;
+  var speed = 1;
+  var readyAt = 0;
+
+  /**
+   * Reads the file's header and index.
+   * @param {Function} kont The continuation for this function.
+   */
+  function open(kont) {
+    readSlice(0, 64, function(buffer) {
+    var header = new Uint32Array(buffer, 0, 6);
+    var fields = new Float64Array(buffer, 24, 3);
+    if (header[0] != 0x51495252 || header[1] != 1) {
+      throwError('This file is not a Radio Receiver capture file.');
+      return;
+    }
+    dataStart = header[2];
+    sampleRate = header[3];
+    startTime = fields[1];
+    startFrequency = fields[2];
+    var entrySize = header[4];
+    var entryCount = header[5];
+    dataEnd = entryCount ? fields[0] : file.size;
+    dataEnd -= (dataEnd - dataStart) % 2;
+    position = dataStart;
+    readSlice(dataEnd, dataEnd + entryCount * entrySize, function(buffer) {
+    index = new Float64Array(buffer);
+    kont();
+    })});
+  }
+
+  /**
+   * Reads a section of the file.
+   * @param {number} start The position of the first byte.
+   * @param {number} end The position after the last byte.
+   * @param {Function} kont The continuation for this function. It receives
+   *     an ArrayBuffer with the data.
+   */
+  function readSlice(start, end, kont) {
+    var reader = new FileReader();
+    reader.onload = function() {
+      kont(reader.result);
+    };
+    reader.onerror = function() {
+      throwError('Cannot read the capture file: ' + reader.error.name);
+    };
+    reader.readAsArrayBuffer(file.slice(start, end));
+  }
+
+  /**
+   * "Sets" the sample rate. The rate can't be changed, so this function
+   * returns the file's rate, and the radio decodes the file at that rate.
+   * @param {number} rate The requested sample rate, which is ignored.
+   * @param {Function} kont The continuation for this function. Receives the
+   *     file's sample rate as its first parameter.
+   */
+  function setSampleRate(rate, kont) {
+    kont(sampleRate);
+  }
+
+  /**
+   * "Tunes" to the given frequency. The frequency can't be changed, so this
+   * function returns the center frequency at the current position.
+   * @param {number} freq The requested frequency, which is ignored.
+   * @param {Function} kont The continuation for this function, which receives
+   *     the center frequency.
+   */
+  function setCenterFrequency(freq, kont) {
+    kont(getCenterFrequency());
+  }
+
+  /**
+   * Resets the sample buffer.
+   * @param {Function} kont The continuation for this function.
+   */
+  function resetBuffer(kont) {
+    readyAt = 0;
+    kont();
+  }
+
+  /**
+   * Reads a block of samples from the file. The block is delivered when
+   * a real tuner would have finished capturing it. When the playback
+   * speed is faster than normal, it skips the samples between blocks.
+   * @param {number} length The number of samples to read.
+   * @param {Function} kont The continuation for this function. It will
+   *     receive as its argument an ArrayBuffer containing the samples.
+   */
+  function readSamples(length, kont) {
+    var start = position;
+    var end = Math.min(dataEnd, start + length * 2);
+    position = Math.min(dataEnd, start + Math.floor(length * speed) * 2);
+    var now = Date.now();
+    readyAt = Math.max(now, readyAt) + 1000 * length / sampleRate;
+    var deliverAt = readyAt;
+    readSlice(start, end, function(data) {
+      var buffer = new Uint8Array(length * 2);
+      buffer.set(new Uint8Array(data));
+      for (var i = data.byteLength; i < buffer.length; ++i) {
+        buffer[i] = 128;
+      }
+      setTimeout(function() {
+        kont(buffer.buffer);
+      }, Math.max(0, deliverAt - Date.now()));
+    });
+  }
+
+  /**
+   * "Stops" the tuner.
+   * @param {Function} kont The continuation for this function.
+   */
+  function close(kont) {
+    kont();
+  }
+
+  /**
+   * Finds the index entry that covers a given time or sample number.
+   * Since entries are written periodically, the entry's position is
+   * estimated and then corrected, taking a few steps at most.
+   * @param {number} field The field to compare: 0 for the sample number,
+   *     1 for the time.
+   * @param {number} value The value to look for.
+   * @return {number} The number of the entry, or -1 if there is no index.
+   */
+  function findEntry(field, value) {
+    var count = index.length / 4;
+    if (count == 0) {
+      return -1;
+    }
+    var first = index[field];
+    var last = index[(count - 1) * 4 + field];
+    var entry = last > first
+        ? Math.floor((count - 1) * (value - first) / (last - first)) : 0;
+    entry = Math.max(0, Math.min(count - 1, entry));
+    while (entry > 0 && index[entry * 4 + field] > value) {
+      --entry;
+    }
+    while (entry < count - 1 && index[(entry + 1) * 4 + field] <= value) {
+      ++entry;
+    }
+    return entry;
+  }
+
+  /**
+   * Returns the current sample number.
+   * @return {number} The sample number.
+   */
+  function getSample() {
+    return (position - dataStart) / 2;
+  }
+
+  /**
+   * Returns the time the current sample was captured.
+   * @return {number} The time, in milliseconds since the epoch.
+   */
+  function getTime() {
+    var sample = getSample();
+    var entry = findEntry(0, sample);
+    if (entry < 0) {
+      return startTime + 1000 * sample / sampleRate;
+    }
+    return index[entry * 4 + 1] +
+        1000 * (sample - index[entry * 4]) / sampleRate;
+  }
+
+  /**
+   * Returns the tuner's center frequency at the current position.
+   * @return {number} The center frequency.
+   */
+  function getCenterFrequency() {
+    var entry = findEntry(0, getSample());
+    return entry < 0 ? startFrequency : index[entry * 4 + 2];
+  }
+
+  /**
+   * Returns the tuner's gain at the current position.
+   * @return {?number} The gain in dB, or null for automatic gain.
+   */
+  function getGain() {
+    var entry = findEntry(0, getSample());
+    var gain = entry < 0 ? -1 : index[entry * 4 + 3];
+    return gain < 0 ? null : gain;
+  }
+
+  /**
+   * Returns the times of the first and last samples in the file.
+   * @return {{start:number,end:number}} The times, in milliseconds since
+   *     the epoch.
+   */
+  function getTimeRange() {
+    var count = index.length / 4;
+    var lastSample = (dataEnd - dataStart) / 2;
+    if (count == 0) {
+      return {start: startTime,
+              end: startTime + 1000 * lastSample / sampleRate};
+    }
+    var last = (count - 1) * 4;
+    return {
+      start: index[1],
+      end: index[last + 1] + 1000 * (lastSample - index[last]) / sampleRate
+    };
+  }
+
+  /**
+   * Moves to the sample that was captured at the given time.
+   * @param {number} time The time, in milliseconds since the epoch.
+   */
+  function seekTo(time) {
+    var entry = findEntry(1, time);
+    var sample;
+    if (entry < 0) {
+      sample = (time - startTime) * sampleRate / 1000;
+    } else {
+      sample = index[entry * 4] + (time - index[entry * 4 + 1]) * sampleRate / 1000;
+      if (entry * 4 + 4 < index.length) {
+        sample = Math.min(sample, index[entry * 4 + 4]);
+      }
+    }
+    sample = Math.floor(sample - WARMUP_TIME * sampleRate);
+    position = dataStart + 2 * Math.max(0, sample);
+    position = Math.min(dataEnd, position);
+  }
+
+  /**
+   * Moves the given number of seconds forwards or backwards.
+   * @param {number} seconds The number of seconds to move.
+   */
+  function seekBy(seconds) {
+    seekTo(getTime() + 1000 * seconds);
+  }
+
+  /**
+   * Sets the playback speed.
+   * @param {number} newSpeed The speed, 1 for real time.
+   */
+  function setSpeed(newSpeed) {
+    speed = Math.max(1, newSpeed);
+  }
+
+  /**
+   * Returns the playback speed.
+   * @return {number} The speed, 1 for real time.
+   */
+  function getSpeed() {
+    return speed;
+  }
+
+  /**
+   * Handles an error.
+   * @param {string} msg The error message.
+   */
+  function throwError(msg) {
+    if (errorHandler) {
+      errorHandler(msg);
+    } else {
+      throw msg;
+    }
+  }
+
+  /**
+   * Sets a function to call if there's an error.
+   * @param {Function} func The function to call on error.
+   */
+  function setOnError(func) {
+    errorHandler = func;
+  }
+
+  return {
+    open: open,
+    setSampleRate: setSampleRate,
+    setCenterFrequency: setCenterFrequency,
+    resetBuffer: resetBuffer,
+    readSamples: readSamples,
+    close: close,
+    setOnError: setOnError,
+    getTime: getTime,
+    getTimeRange: getTimeRange,
+    getCenterFrequency: getCenterFrequency,
+    getGain: getGain,
+    seekTo: seekTo,
+    seekBy: seekBy,
+    setSpeed: setSpeed,
+    getSpeed: getSpeed
+  };
+}
@@ -0,0 +1,61 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+var MAX_ROWS = 200;
+var lastTime = {};
+
+function exit() {
+  AuxWindows.closeCurrent();
+}
+
+function showMessages() {
+  var windows = chrome.app.window.getAll();
+  var newMessages = [];
+  for (var i = 0; i < windows.length; ++i) {
+    var radio = windows[i].contentWindow['radio'];
+    if (radio && radio.getMessages) {
+      var device = radio.getStats().device;
+      var messages = radio.getMessages(lastTime[device]);
+      for (var j = 0; j < messages.length; ++j) {
+        messages[j].device = device;
+        newMessages.push(messages[j]);
+        lastTime[device] = messages[j].time;
+      }
+    }
+  }
+  newMessages.sort(function(a, b) { return a.time - b.time; });
+  for (var i = 0; i < newMessages.length; ++i) {
+    var msg = newMessages[i];
+    var row = document.createElement('tr');
+    addCell(row, new Date(msg.time).toLocaleTimeString());
+    addCell(row, msg.device + 1);
+    addCell(row, msg.type);
+    addCell(row, msg.text);
+    messagesTable.insertBefore(row, messagesTable.firstChild);
+  }
+  while (messagesTable.childNodes.length > MAX_ROWS) {
+    messagesTable.removeChild(messagesTable.lastChild);
+  }
+}
+
+function addCell(row, text) {
+  var cell = document.createElement('td');
+  cell.textContent = text;
+  row.appendChild(cell);
+}
+
+closeButton.addEventListener('click', exit);
+
+showMessages();
+setInterval(showMessages, 1000);
@@ -0,0 +1,76 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+function exit() {
+  AuxWindows.closeCurrent();
+}
+
+function getAllStats() {
+  var allStats = [];
+  var windows = chrome.app.window.getAll();
+  for (var i = 0; i < windows.length; ++i) {
+    var radio = windows[i].contentWindow['radio'];
+    if (radio && radio.getStats) {
+      allStats.push(radio.getStats());
+    }
+  }
+  allStats.sort(function(a, b) { return a.device - b.device; });
+  return allStats;
+}
+
+function showStats() {
+  var allStats = getAllStats();
+  while (statsTable.firstChild) {
+    statsTable.removeChild(statsTable.firstChild);
+  }
+  for (var i = 0; i < allStats.length; ++i) {
+    var stats = allStats[i];
+    var tuner = stats.tuner || {};
+    var row = document.createElement('tr');
+    addCell(row, stats.device + 1);
+    addCell(row, stats.playing ? (stats.frequency / 1e6).toFixed(3) + ' MHz'
+                               : 'Off');
+    addCell(row, Math.round(stats.cpuLoad * 100) + '%');
+    addCell(row, stats.processedBlocks);
+    addCell(row, stats.droppedBlocks);
+    addCell(row, stats.messageRate >= 0.05 ?
+                 stats.messageRate.toFixed(1) + '/s' : '');
+    addCell(row, tuner.underruns == null ? '' : tuner.underruns);
+    addCell(row, stats.drift == null ? '' :
+                 (stats.drift >= 0 ? '+' : '') + stats.drift.toFixed(2) + ' PPM');
+    var scan = stats.scan;
+    addCell(row, scan == null ? '' :
+                 scan.channelsPerSecond.toFixed(1) + ' ch/s' +
+                 (scan.priorityLatency == null ? '' :
+                  ', ' + Math.round(scan.priorityLatency) + ' ms'));
+    addCell(row, stats.sharingClients);
+    var ui = stats.ui;
+    addCell(row, ui == null || ui.applied == 0 ? '' :
+                 ui.averageTime.toFixed(2) + ' ms, ' +
+                 ui.maxTime.toFixed(1) + ' max');
+    statsTable.appendChild(row);
+  }
+}
+
+function addCell(row, text) {
+  var cell = document.createElement('td');
+  cell.textContent = text;
+  row.appendChild(cell);
+}
+
+closeButton.addEventListener('click', exit);
+
+showStats();
+setInterval(showStats, 1000);
+AuxWindows.resizeCurrentTo(760, 0);
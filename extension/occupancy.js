@@ -0,0 +1,490 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview Functions to log how busy a row of channels is, and to get
+ * statistics out of the log.
+ *
+ * The occupancy logs have a 64-byte header, followed by a record for every
+ * measurement. Records are only ever appended, and all have the same size,
+ * so the file grows by the same number of bytes every interval, and the
+ * record for a time can be found with a binary search.
+ *
+ * The header contains these little-endian fields:
+ *   0: uint32  "RROC"
+ *   4: uint32  Version (1)
+ *   8: uint32  Header size (64)
+ *  12: uint32  Size of each record
+ *  16: uint32  Number of channels
+ *  20: uint32  Interval between measurements, in milliseconds
+ *  24: float64 Frequency of the first channel
+ *  32: float64 Distance between channels, which is also their width
+ *  40: float64 Time of the first measurement, in milliseconds since the
+ *              epoch
+ *
+ * Each record consists of a float64 with the time of the measurement, in
+ * milliseconds since the epoch, followed by a uint8 for each channel, and
+ * padding up to a multiple of 8 bytes. The channel's power is stored in
+ * half-dB steps, from 1 for -127.5 dB to 255 for -0.5 dB relative to full
+ * scale. 0 means that the channel was not measured, because it was outside
+ * the tuner's span at the time.
+ */
+
+/**
+ * Converts a channel's power into its value in a record.
+ * @param {number} power The power, in dB, or NaN if it wasn't measured.
+ * @return {number} The value for the record.
+ */
+function occupancyLevelToValue(power) {
+  if (isNaN(power)) {
+    return 0;
+  }
+  return Math.max(1, Math.min(255, Math.round(2 * (power + 128))));
+}
+
+/**
+ * Converts a channel's value in a record into its power.
+ * @param {number} value The value in the record.
+ * @return {number} The power, in dB, or NaN if it wasn't measured.
+ */
+function occupancyValueToLevel(value) {
+  return value == 0 ? NaN : value / 2 - 128;
+}
+
+/**
+ * A class to write the measurements of a row of channels into an
+ * occupancy log.
+ *
+ * If the file is already a log for the same channels and interval, the new
+ * records are appended to it, so logging can go on for weeks even if the
+ * radio is restarted. Otherwise, the file is overwritten.
+ * @param {FileEntry} fileEntry An entry for the log file.
+ * @param {number} firstFrequency The frequency of the first channel.
+ * @param {number} step The distance between channels.
+ * @param {number} count The number of channels.
+ * @param {number} interval The interval between measurements, in
+ *     milliseconds.
+ * @constructor
+ */
+function OccupancyLogWriter(fileEntry, firstFrequency, step, count, interval) {
+
+  var HEADER_SIZE = 64;
+  var RECORD_SIZE = 8 + 8 * Math.ceil(count / 8);
+
+  var fileWriter;
+  var queue = [];
+  var writing = true;
+  var startTime = 0;
+
+  fileEntry.createWriter(function(writer) {
+    fileWriter = writer;
+    writer.onerror = processError;
+    fileEntry.file(function(file) {
+      var reader = new FileReader();
+      reader.onload = function() {
+        writer.onwriteend = processQueue;
+        var end = findAppendPosition(reader.result, file.size);
+        if (end >= 0) {
+          writer.seek(end);
+          processQueue();
+        } else if (writer.length > 0) {
+          writer.truncate(0);
+        } else {
+          processQueue();
+        }
+      };
+      reader.onerror = processError;
+      reader.readAsArrayBuffer(file.slice(0, HEADER_SIZE));
+    }, processError);
+  }, processError);
+
+  /**
+   * Checks whether an existing file is a log for the same channels and
+   * interval, and returns where the next record should go. If the file is
+   * not such a log, it queues a new header.
+   * @param {ArrayBuffer} buffer The start of the file.
+   * @param {number} size The size of the file.
+   * @return {number} The position after the last whole record, or -1 if
+   *     the file must be overwritten.
+   */
+  function findAppendPosition(buffer, size) {
+    if (buffer.byteLength == HEADER_SIZE) {
+      var header = new Uint32Array(buffer, 0, 6);
+      var fields = new Float64Array(buffer, 24, 3);
+      if (header[0] == 0x434f5252 && header[1] == 1 &&
+          header[2] == HEADER_SIZE && header[3] == RECORD_SIZE &&
+          header[4] == count && header[5] == interval &&
+          fields[0] == firstFrequency && fields[1] == step) {
+        return size - (size - HEADER_SIZE) % RECORD_SIZE;
+      }
+    }
+    queue.unshift(new Blob([createHeader()]));
+    return -1;
+  }
+
+  /**
+   * Writes the contents of the queue and schedules the next execution of
+   * this function, if the queue is empty. After finish() was called and
+   * the queue goes empty, stops rescheduling.
+   */
+  function processQueue() {
+    if (queue == null) {
+      return;
+    }
+    if (queue.length == 0) {
+      if (writing) {
+        setTimeout(processQueue, 1000);
+      } else {
+        queue = null;
+      }
+      return;
+    }
+    var blob = new Blob(queue);
+    queue = [];
+    fileWriter.write(blob);
+  }
+
+  /**
+   * Empties the queue and stops writing.
+   */
+  function processError() {
+    writing = false;
+    queue = null;
+  }
+
+  /**
+   * Creates the file header.
+   * @return {ArrayBuffer} The header.
+   */
+  function createHeader() {
+    var header = new ArrayBuffer(HEADER_SIZE);
+    new Uint32Array(header, 0, 6).set([
+      0x434f5252,   // "RROC"
+      1,            // version
+      HEADER_SIZE,
+      RECORD_SIZE,
+      count,
+      interval
+    ]);
+    new Float64Array(header, 24, 3).set([
+      firstFrequency, step, startTime || Date.now()]);
+    return header;
+  }
+
+  /**
+   * Writes a measurement.
+   * @param {number} time The time of the measurement, in milliseconds since
+   *     the epoch.
+   * @param {Array.<number>|Float32Array} powers The power in each channel,
+   *     in dB, or NaN for the channels that weren't measured.
+   */
+  function write(time, powers) {
+    if (!writing) {
+      return;
+    }
+    startTime = startTime || time;
+    var record = new ArrayBuffer(RECORD_SIZE);
+    new Float64Array(record, 0, 1)[0] = time;
+    var values = new Uint8Array(record, 8, count);
+    for (var i = 0; i < count; ++i) {
+      values[i] = occupancyLevelToValue(powers[i]);
+    }
+    queue.push(record);
+  }
+
+  /**
+   * Finishes writing to the log.
+   */
+  function finish() {
+    writing = false;
+  }
+
+  /**
+   * Returns how many bytes the log grows by every day.
+   * @return {number} The number of bytes.
+   */
+  function getBytesPerDay() {
+    return RECORD_SIZE * 86400000 / interval;
+  }
+
+  return {
+    write: write,
+    finish: finish,
+    getBytesPerDay: getBytesPerDay
+  };
+}
+
+/**
+ * A class to get statistics out of an occupancy log. Only the records for
+ * the requested time range are read, a few thousand at a time, so logs of
+ * any length can be queried.
+ * @param {Blob} file The log file.
+ * @constructor
+ */
+function OccupancyLogReader(file) {
+
+  var CHUNK_RECORDS = 4096;
+
+  var errorHandler;
+  var headerSize = 0;
+  var recordSize = 0;
+  var recordCount = 0;
+  var channelCount = 0;
+  var interval = 0;
+  var firstFrequency = 0;
+  var step = 0;
+  var startTime = 0;
+  var endTime = 0;
+
+  /**
+   * Reads the file's header and the time of its last record.
+   * @param {Function} kont The continuation for this function.
+   */
+  function open(kont) {
+    readSlice(0, 64, function(buffer) {
+    if (buffer.byteLength < 64) {
+      throwError('This file is not a Radio Receiver occupancy log.');
+      return;
+    }
+    var header = new Uint32Array(buffer, 0, 6);
+    var fields = new Float64Array(buffer, 24, 3);
+    if (header[0] != 0x434f5252 || header[1] != 1) {
+      throwError('This file is not a Radio Receiver occupancy log.');
+      return;
+    }
+    headerSize = header[2];
+    recordSize = header[3];
+    channelCount = header[4];
+    interval = header[5];
+    firstFrequency = fields[0];
+    step = fields[1];
+    startTime = fields[2];
+    recordCount = Math.floor((file.size - headerSize) / recordSize);
+    if (recordCount == 0) {
+      endTime = startTime;
+      kont();
+      return;
+    }
+    readTime(recordCount - 1, function(time) {
+    endTime = time;
+    kont();
+    })});
+  }
+
+  /**
+   * Reads a section of the file.
+   * @param {number} start The position of the first byte.
+   * @param {number} end The position after the last byte.
+   * @param {Function} kont The continuation for this function. It receives
+   *     an ArrayBuffer with the data.
+   */
+  function readSlice(start, end, kont) {
+    var reader = new FileReader();
+    reader.onload = function() {
+      kont(reader.result);
+    };
+    reader.onerror = function() {
+      throwError('Cannot read the occupancy log: ' + reader.error.name);
+    };
+    reader.readAsArrayBuffer(file.slice(start, end));
+  }
+
+  /**
+   * Reads the time of a record.
+   * @param {number} record The number of the record.
+   * @param {Function} kont The continuation for this function. It receives
+   *     the time, in milliseconds since the epoch.
+   */
+  function readTime(record, kont) {
+    var pos = headerSize + record * recordSize;
+    readSlice(pos, pos + 8, function(buffer) {
+      kont(new Float64Array(buffer)[0]);
+    });
+  }
+
+  /**
+   * Finds the first record taken at or after a given time, with a binary
+   * search that reads only the records' times.
+   * @param {number} time The time, in milliseconds since the epoch.
+   * @param {Function} kont The continuation for this function. It receives
+   *     the number of the record, which is the number of records if there
+   *     are none after that time.
+   */
+  function findRecord(time, kont) {
+    var low = 0;
+    var high = recordCount;
+    function probe() {
+      if (low >= high) {
+        kont(low);
+        return;
+      }
+      var middle = (low + high) >> 1;
+      readTime(middle, function(middleTime) {
+        if (middleTime < time) {
+          low = middle + 1;
+        } else {
+          high = middle;
+        }
+        probe();
+      });
+    }
+    probe();
+  }
+
+  /**
+   * Computes statistics for every channel over a range of time.
+   * @param {number} start The start of the range, in milliseconds since the
+   *     epoch.
+   * @param {number} end The end of the range, in milliseconds since the
+   *     epoch.
+   * @param {number} threshold The power above which a channel is busy, in
+   *     dB relative to full scale.
+   * @param {Function} kont The continuation for this function. It receives
+   *     an object with the number of records in the range, and an array
+   *     with the statistics for each channel: its frequency, the number of
+   *     times it was measured, the fraction of those when it was busy, and
+   *     its average and highest power in dB. The power of the channels
+   *     that were never measured is NaN.
+   */
+  function query(start, end, threshold, kont) {
+    var thresholdValue = occupancyLevelToValue(threshold);
+    var measured = new Float64Array(channelCount);
+    var busy = new Float64Array(channelCount);
+    var sums = new Float64Array(channelCount);
+    var highest = new Uint8Array(channelCount);
+    var records = 0;
+    findRecord(start, function(record) {
+      readChunk(record);
+    });
+
+    /**
+     * Adds up the values of a chunk of records, and goes on with the next
+     * chunk until the end of the range.
+     * @param {number} record The number of the chunk's first record.
+     */
+    function readChunk(record) {
+      var count = Math.min(CHUNK_RECORDS, recordCount - record);
+      if (count <= 0) {
+        finish();
+        return;
+      }
+      var pos = headerSize + record * recordSize;
+      readSlice(pos, pos + count * recordSize, function(buffer) {
+        for (var r = 0; r < count; ++r) {
+          var offset = r * recordSize;
+          if (new Float64Array(buffer, offset, 1)[0] >= end) {
+            finish();
+            return;
+          }
+          ++records;
+          var values = new Uint8Array(buffer, offset + 8, channelCount);
+          for (var i = 0; i < channelCount; ++i) {
+            var value = values[i];
+            if (value == 0) {
+              continue;
+            }
+            ++measured[i];
+            if (value >= thresholdValue) {
+              ++busy[i];
+            }
+            sums[i] += Math.pow(10, occupancyValueToLevel(value) / 10);
+            highest[i] = Math.max(highest[i], value);
+          }
+        }
+        readChunk(record + count);
+      });
+    }
+
+    /**
+     * Computes the statistics from the sums and passes them on.
+     */
+    function finish() {
+      var channels = [];
+      for (var i = 0; i < channelCount; ++i) {
+        channels.push({
+          frequency: firstFrequency + i * step,
+          measured: measured[i],
+          occupancy: measured[i] ? busy[i] / measured[i] : 0,
+          averagePower: 10 * Math.log(sums[i] / measured[i]) / Math.LN10,
+          highestPower: occupancyValueToLevel(highest[i])
+        });
+      }
+      kont({records: records, channels: channels});
+    }
+  }
+
+  /**
+   * Returns the channels in the log.
+   * @return {{first:number,step:number,count:number}} The frequency of the
+   *     first channel, the distance between channels, and their number.
+   */
+  function getChannels() {
+    return {first: firstFrequency, step: step, count: channelCount};
+  }
+
+  /**
+   * Returns the interval between measurements.
+   * @return {number} The interval, in milliseconds.
+   */
+  function getInterval() {
+    return interval;
+  }
+
+  /**
+   * Returns the times of the first and last records in the log.
+   * @return {{start:number,end:number}} The times, in milliseconds since
+   *     the epoch.
+   */
+  function getTimeRange() {
+    return {start: startTime, end: endTime};
+  }
+
+  /**
+   * Returns the number of records in the log.
+   * @return {number} The number of records.
+   */
+  function getRecordCount() {
+    return recordCount;
+  }
+
+  /**
+   * Handles an error.
+   * @param {string} msg The error message.
+   */
+  function throwError(msg) {
+    if (errorHandler) {
+      errorHandler(msg);
+    } else {
+      throw msg;
+    }
+  }
+
+  /**
+   * Sets a function to call if there's an error.
+   * @param {Function} func The function to call on error.
+   */
+  function setOnError(func) {
+    errorHandler = func;
+  }
+
+  return {
+    open: open,
+    query: query,
+    getChannels: getChannels,
+    getInterval: getInterval,
+    getTimeRange: getTimeRange,
+    getRecordCount: getRecordCount,
+    setOnError: setOnError
+  };
+}
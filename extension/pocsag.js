@@ -0,0 +1,357 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A decoder for the POCSAG messages that paging networks
+ * send as 2-FSK over narrowband FM.
+ */
+
+/**
+ * A class to decode POCSAG pages in demodulated narrowband FM audio.
+ *
+ * The audio is decimated to about 24 kHz, where a receiver for each of the
+ * 512, 1200 and 2400 baud rates recovers the bit clock from the signal's
+ * transitions and integrates the signal over each bit. Whichever receiver
+ * finds a synchronization codeword follows the batches that come after it,
+ * so the baud rate is detected on its own; the polarity too, since it
+ * depends on the transmitter and the tuner. Up to two wrong bits in each
+ * codeword are corrected with its BCH code; a page with a codeword that
+ * can't be corrected is dropped.
+ *
+ * All the state has a fixed size, so it can run for days.
+ * @param {number} sampleRate The sample rate of the audio.
+ * @constructor
+ */
+function PocsagDecoder(sampleRate) {
+  var BAUD_RATES = [512, 1200, 2400];
+  var DECIMATION = Math.max(1, Math.floor(sampleRate / 19200));
+  var LOW_RATE = sampleRate / DECIMATION;
+  var CLOCK_GAIN = 0.1;
+  var LEVEL_WEIGHT = 0.02;
+  var SYNC_CODEWORD = 0x7cd215d8;
+  var IDLE_CODEWORD = 0x7a89c197;
+  var BCH_POLY = 0x769;
+  var MAX_SYNC_ERRORS = 2;
+  // Noise sometimes looks like a synchronization codeword, but then most
+  // of the codewords that follow can't be corrected.
+  var MAX_BAD_CODEWORDS = 2;
+  var BATCH_CODEWORDS = 16;
+  // Enough for the longest alphanumeric pages, of about 500 characters.
+  var MAX_MESSAGE_CODEWORDS = 180;
+  var NUMERIC_CHARS = '0123456789*U -)(';
+
+  var downsampler = new Downsampler(
+      sampleRate, LOW_RATE, getLowPassFIRCoeffs(sampleRate, 3000, 4 * DECIMATION + 1));
+
+  // The error pattern for the syndrome of every one or two wrong bits.
+  var errorPatterns = new Uint32Array(1024);
+  for (var i = 0; i < 31; ++i) {
+    for (var j = i; j < 31; ++j) {
+      var pattern = ((1 << i) | (1 << j)) >>> 0;
+      errorPatterns[syndrome(pattern)] = pattern;
+    }
+  }
+
+  var receivers = [];
+  for (var i = 0; i < BAUD_RATES.length; ++i) {
+    receivers.push({
+      baud: BAUD_RATES[i],
+      clockStep: BAUD_RATES[i] / LOW_RATE,
+      clock: 0,
+      sum: 0,
+      count: 0,
+      high: 0,
+      low: 0,
+      lastSign: 0,
+      register: 0,
+      synced: false,
+      inverted: false,
+      bitCount: 0,
+      codewordCount: 0,
+      badCodewords: 0,
+      message: null
+    });
+  }
+
+  var messages = [];
+
+  /**
+   * Decodes the pages in a block of audio.
+   * @param {Float32Array} samples The demodulated audio.
+   * @return {Array.<Object>} The pages that ended in this block.
+   */
+  function process(samples) {
+    messages = [];
+    var low = downsampler.downsample(samples);
+    for (var r = 0; r < receivers.length; ++r) {
+      receiveSamples(receivers[r], low);
+    }
+    return messages;
+  }
+
+  /**
+   * Recovers the bits from the audio for one baud rate. The clock is
+   * nudged so the transitions between bits fall where it wraps around,
+   * and the signal is integrated between wraps and compared with the
+   * midpoint of the recent high and low bits.
+   * @param {Object} rx The receiver's state.
+   * @param {Float32Array} samples The decimated audio.
+   */
+  function receiveSamples(rx, samples) {
+    var clock = rx.clock;
+    var sum = rx.sum;
+    var count = rx.count;
+    var lastSign = rx.lastSign;
+    var mid = (rx.high + rx.low) / 2;
+    for (var i = 0; i < samples.length; ++i) {
+      var sample = samples[i];
+      var sign = sample > mid ? 1 : 0;
+      if (sign != lastSign) {
+        lastSign = sign;
+        clock -= (clock < 0.5 ? clock : clock - 1) * CLOCK_GAIN;
+      }
+      sum += sample;
+      ++count;
+      clock += rx.clockStep;
+      if (clock >= 1) {
+        clock -= 1;
+        var value = sum / count;
+        sum = 0;
+        count = 0;
+        var bit = value > mid ? 1 : 0;
+        if (bit) {
+          rx.high += (value - rx.high) * LEVEL_WEIGHT;
+        } else {
+          rx.low += (value - rx.low) * LEVEL_WEIGHT;
+        }
+        mid = (rx.high + rx.low) / 2;
+        receiveBit(rx, bit);
+      }
+    }
+    rx.clock = clock;
+    rx.sum = sum;
+    rx.count = count;
+    rx.lastSign = lastSign;
+  }
+
+  /**
+   * Looks for the synchronization codeword in the bits, and then collects
+   * the codewords of each batch.
+   * @param {Object} rx The receiver's state.
+   * @param {number} bit The bit, as it came from the receiver.
+   */
+  function receiveBit(rx, bit) {
+    rx.register = ((rx.register << 1) | bit) >>> 0;
+    if (!rx.synced) {
+      if (bitErrors(rx.register, SYNC_CODEWORD) <= MAX_SYNC_ERRORS) {
+        rx.inverted = false;
+      } else if (bitErrors(~rx.register, SYNC_CODEWORD) <= MAX_SYNC_ERRORS) {
+        rx.inverted = true;
+      } else {
+        return;
+      }
+      rx.synced = true;
+      rx.bitCount = 0;
+      rx.codewordCount = 0;
+      rx.badCodewords = 0;
+      return;
+    }
+    if (++rx.bitCount < 32) {
+      return;
+    }
+    rx.bitCount = 0;
+    var codeword = (rx.inverted ? ~rx.register : rx.register) >>> 0;
+    if (rx.codewordCount == BATCH_CODEWORDS) {
+      // Another batch must follow right away, or the transmission is over.
+      rx.codewordCount = 0;
+      rx.badCodewords = 0;
+      if (bitErrors(codeword, SYNC_CODEWORD) > MAX_SYNC_ERRORS) {
+        rx.synced = false;
+        endMessage(rx);
+      }
+      return;
+    }
+    receiveCodeword(rx, codeword, rx.codewordCount >> 1);
+    ++rx.codewordCount;
+  }
+
+  /**
+   * Corrects a codeword, and adds it to the current page.
+   * @param {Object} rx The receiver's state.
+   * @param {number} codeword The codeword.
+   * @param {number} frame The number of the frame it is in, from 0 to 7.
+   */
+  function receiveCodeword(rx, codeword, frame) {
+    codeword = correct(codeword);
+    if (codeword == null) {
+      if (rx.message) {
+        rx.message.active = false;
+      }
+      if (++rx.badCodewords > MAX_BAD_CODEWORDS) {
+        rx.synced = false;
+      }
+      return;
+    }
+    if (codeword == IDLE_CODEWORD) {
+      endMessage(rx);
+    } else if (codeword & 0x80000000) {
+      var msg = rx.message;
+      if (msg && msg.active && msg.length < MAX_MESSAGE_CODEWORDS) {
+        msg.data[msg.length++] = (codeword >>> 11) & 0xfffff;
+      }
+    } else {
+      endMessage(rx);
+      rx.message = rx.message || {data: new Int32Array(MAX_MESSAGE_CODEWORDS)};
+      rx.message.active = true;
+      rx.message.address = (((codeword >>> 13) & 0x3ffff) << 3) | frame;
+      rx.message.func = (codeword >>> 11) & 3;
+      rx.message.length = 0;
+    }
+  }
+
+  /**
+   * Finishes the current page, if there is one, and adds it to the
+   * messages.
+   * @param {Object} rx The receiver's state.
+   */
+  function endMessage(rx) {
+    var msg = rx.message;
+    if (!msg || !msg.active) {
+      return;
+    }
+    msg.active = false;
+    var content = msg.length == 0 ? '' :
+                  msg.func == 0 ? decodeNumeric(msg.data, msg.length) :
+                  decodeAlpha(msg.data, msg.length);
+    messages.push({
+      type: 'POCSAG',
+      address: msg.address,
+      func: msg.func,
+      baud: rx.baud,
+      content: content,
+      text: msg.address + '/' + msg.func + ': ' +
+            (msg.length == 0 ? '(tone only)' : content)
+    });
+  }
+
+  /**
+   * Decodes a numeric page, made of 4-bit characters.
+   * @param {Int32Array} data The 20 bits of each message codeword.
+   * @param {number} length The number of codewords.
+   * @return {string} The page's text.
+   */
+  function decodeNumeric(data, length) {
+    var text = '';
+    for (var i = 0; i < length; ++i) {
+      for (var shift = 16; shift >= 0; shift -= 4) {
+        var digit = (data[i] >>> shift) & 0xf;
+        // The least significant bit goes first.
+        digit = ((digit & 1) << 3) | ((digit & 2) << 1) |
+                ((digit & 4) >> 1) | ((digit & 8) >> 3);
+        text += NUMERIC_CHARS[digit];
+      }
+    }
+    return text.replace(/ +$/, '');
+  }
+
+  /**
+   * Decodes an alphanumeric page, made of 7-bit characters that run
+   * across codewords.
+   * @param {Int32Array} data The 20 bits of each message codeword.
+   * @param {number} length The number of codewords.
+   * @return {string} The page's text.
+   */
+  function decodeAlpha(data, length) {
+    var text = '';
+    var ch = 0;
+    var bits = 0;
+    for (var i = 0; i < length; ++i) {
+      for (var b = 19; b >= 0; --b) {
+        ch = (ch >> 1) | (((data[i] >>> b) & 1) << 6);
+        if (++bits == 7) {
+          if (ch >= 32 && ch < 127) {
+            text += String.fromCharCode(ch);
+          } else if (ch == 10 || ch == 13) {
+            text += ' ';
+          }
+          ch = 0;
+          bits = 0;
+        }
+      }
+    }
+    return text.trim();
+  }
+
+  /**
+   * Corrects up to two wrong bits in a codeword with its BCH code, and
+   * checks its parity.
+   * @param {number} codeword The codeword.
+   * @return {?number} The corrected codeword, or null if it has too many
+   *     wrong bits.
+   */
+  function correct(codeword) {
+    var bch = codeword >>> 1;
+    var wrongBits = 0;
+    var s = syndrome(bch);
+    if (s != 0) {
+      var pattern = errorPatterns[s];
+      if (!pattern) {
+        return null;
+      }
+      bch = (bch ^ pattern) >>> 0;
+      wrongBits = bitErrors(pattern, 0);
+    }
+    var parity = bitErrors(bch, 0) & 1;
+    if (parity != (codeword & 1) && wrongBits == 2) {
+      return null;
+    }
+    return ((bch << 1) | parity) >>> 0;
+  }
+
+  /**
+   * Computes the BCH syndrome of the 31 bits of a codeword before its
+   * parity bit.
+   * @param {number} bch The bits.
+   * @return {number} The 10-bit syndrome, which is 0 for a valid codeword.
+   */
+  function syndrome(bch) {
+    var rem = bch;
+    for (var i = 30; i >= 10; --i) {
+      if (rem & (1 << i)) {
+        rem ^= BCH_POLY << (i - 10);
+      }
+    }
+    return rem & 0x3ff;
+  }
+
+  /**
+   * Counts the bits that differ between two words.
+   * @param {number} a The first word.
+   * @param {number} b The second word.
+   * @return {number} The number of different bits.
+   */
+  function bitErrors(a, b) {
+    var x = (a ^ b) >>> 0;
+    var count = 0;
+    while (x) {
+      x &= x - 1;
+      ++count;
+    }
+    return count;
+  }
+
+  return {
+    process: process
+  };
+}
@@ -0,0 +1,254 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A scanner that watches a list of channels, like the memory
+ * scan of a handheld scanner.
+ */
+
+/**
+ * A class that decides which channels the radio must listen to while
+ * scanning a list of channels, such as the saved stations. RadioController
+ * asks it what to do with each block of samples, and tells it what the
+ * block contained.
+ *
+ * The tuner receives many channels at once, so the power of all the
+ * channels within the tuner's span is measured in every block, and the
+ * tuner is only retuned to reach the channels outside it. A channel is
+ * active when its power is some dB above the noise level. The scanner then
+ * stays on that channel until it has been quiet for the hang time, and
+ * goes on scanning from the next channel.
+ *
+ * The priority channel is checked at least every few hundred milliseconds:
+ * in every block when it's within the tuner's span, and otherwise with a
+ * short look away from the channel being scanned or listened to. It takes
+ * over from any other channel as soon as it's active.
+ *
+ * Options:
+ *     priority: the priority channel's frequency (default none).
+ *     dwell: how long each channel is measured for, in milliseconds, unless
+ *         the channel has its own dwell time (default 50).
+ *     hang: how long to stay on a channel after it goes quiet, in
+ *         milliseconds (default 2000).
+ *     priorityInterval: how often to check the priority channel, in
+ *         milliseconds (default 300).
+ *     threshold: how far above the noise level a channel's power must be
+ *         for it to be active, in dB (default 10).
+ * @param {Array.<number|{frequency:number,dwell:number}>} channels The
+ *     channels' frequencies, and optionally their own dwell times.
+ * @param {function(number):number} getCenter A function that returns the
+ *     tuner's center frequency to receive a channel.
+ * @param {Object=} opt_options The scanner's options.
+ * @constructor
+ */
+function PresetScanner(channels, getCenter, opt_options) {
+  var options = opt_options || {};
+  var priority = options['priority'] == null ? null : options['priority'];
+  var dwell = options['dwell'] || 50;
+  var hang = options['hang'] == null ? 2000 : options['hang'];
+  var priorityInterval = options['priorityInterval'] || 300;
+  var threshold = options['threshold'] || 10;
+
+  var list = [];
+  for (var i = 0; i < channels.length; ++i) {
+    var channel = channels[i];
+    list.push(typeof channel == 'number' ?
+        {frequency: channel, dwell: dwell} :
+        {frequency: channel.frequency, dwell: channel.dwell || dwell});
+  }
+  list.sort(function(a, b) { return a.frequency - b.frequency; });
+  var priorityChannel = {frequency: priority, dwell: dwell};
+  for (var i = 0; i < list.length; ++i) {
+    if (list[i].frequency == priority) {
+      priorityChannel = list[i];
+    }
+  }
+
+  var position = 0;
+  var active = null;
+  var quietSince = null;
+  var lastPriorityCheck = null;
+  var scanTime = 0;
+  var scannedChannels = 0;
+  var priorityChecks = 0;
+  var priorityGaps = 0;
+  var maxPriorityGap = 0;
+
+  /**
+   * Decides what to do with the next block of samples.
+   * @param {number} now The current time, in milliseconds.
+   * @param {number} center The tuner's current center frequency.
+   * @param {number} maxDistance How far the center frequency for a
+   *     channel, as given by getCenter, can be from the tuner's center
+   *     frequency for the channel to be received without retuning.
+   * @return {Object} The block's plan: the time it was made, the center
+   *     frequency to tune to, the channel to demodulate, the channels to
+   *     measure, how long the block should be in milliseconds (or null for
+   *     a normal block), whether the radio is listening to an active
+   *     channel, and whether the block is a short look at the priority
+   *     channel. When scanning, it also has the number of scanned channels
+   *     at the start of the measure list, and where to go on scanning.
+   */
+  function nextBlock(now, center, maxDistance) {
+    function fits(c, channel) {
+      return Math.abs(c - getCenter(channel.frequency)) <= maxDistance;
+    }
+    var priorityDue = priority != null && active != priorityChannel &&
+        (lastPriorityCheck == null ||
+         now - lastPriorityCheck >= priorityInterval);
+    if (priorityDue && !fits(center, priorityChannel)) {
+      return {
+        time: now,
+        center: getCenter(priority),
+        frequency: priority,
+        measure: [priority],
+        duration: priorityChannel.dwell,
+        listening: false,
+        lookingBack: true
+      };
+    }
+    var measure = [];
+    if (active) {
+      var activeCenter =
+          fits(center, active) ? center : getCenter(active.frequency);
+      measure.push(active.frequency);
+      if (active != priorityChannel && priority != null &&
+          fits(activeCenter, priorityChannel)) {
+        measure.push(priority);
+      }
+      return {
+        time: now,
+        center: activeCenter,
+        frequency: active.frequency,
+        measure: measure,
+        duration: null,
+        listening: true,
+        lookingBack: false
+      };
+    }
+    // Retune so the first channel to scan is at the edge of the span, to
+    // fit as many of the following channels as possible.
+    var first = list[position];
+    var groupCenter = fits(center, first) ? center :
+        getCenter(first.frequency) + maxDistance;
+    var duration = 0;
+    var end = position;
+    do {
+      measure.push(list[end].frequency);
+      duration = Math.max(duration, list[end].dwell);
+      ++end;
+    } while (end < list.length && fits(groupCenter, list[end]));
+    var count = measure.length;
+    if (priority != null && measure.indexOf(priority) < 0 &&
+        fits(groupCenter, priorityChannel)) {
+      measure.push(priority);
+    }
+    return {
+      time: now,
+      center: groupCenter,
+      frequency: first.frequency,
+      measure: measure,
+      duration: duration,
+      listening: false,
+      lookingBack: false,
+      count: count,
+      next: end % list.length
+    };
+  }
+
+  /**
+   * Updates the scan with the measurements of a block. The blocks for
+   * listening may arrive after the scanner has moved on to another
+   * channel, since the radio reads them ahead.
+   * @param {Object} block The block's plan, as returned by nextBlock.
+   * @param {number} now The current time, in milliseconds.
+   * @param {Float32Array} powers The power of the channels in the block's
+   *     measure list, in dB.
+   * @param {number} noise The noise level in the block, in dB.
+   */
+  function receiveBlock(block, now, powers, noise) {
+    var found = null;
+    for (var i = 0; i < block.measure.length; ++i) {
+      var isActive = powers[i] >= noise + threshold;
+      if (block.measure[i] == priority) {
+        if (lastPriorityCheck != null) {
+          var gap = now - lastPriorityCheck;
+          ++priorityChecks;
+          priorityGaps += gap;
+          maxPriorityGap = Math.max(maxPriorityGap, gap);
+        }
+        lastPriorityCheck = now;
+        if (isActive && active != priorityChannel) {
+          found = priorityChannel;
+        }
+      }
+      if (block.listening && i == 0 && active &&
+          block.frequency == active.frequency) {
+        if (isActive) {
+          quietSince = null;
+        } else if (quietSince == null) {
+          quietSince = now;
+        } else if (now - quietSince >= hang) {
+          position = (list.indexOf(active) + 1) % list.length;
+          active = null;
+        }
+      }
+      if (block.count != null && i < block.count && isActive && !found) {
+        found = list[position + i];
+      }
+    }
+    if (block.count != null) {
+      scanTime += now - block.time;
+      scannedChannels += block.count;
+      position = block.next;
+    }
+    if (found) {
+      active = found;
+      quietSince = null;
+    }
+    if (active == priorityChannel) {
+      lastPriorityCheck = null;
+    }
+  }
+
+  /**
+   * Returns the channel the radio is listening to.
+   * @return {?number} The channel's frequency, or null while scanning.
+   */
+  function getActiveChannel() {
+    return active ? active.frequency : null;
+  }
+
+  /**
+   * Returns the scan's statistics.
+   * @return {{channelsPerSecond:number,priorityLatency:?number,maxPriorityLatency:?number}}
+   *     How many channels are checked per second while scanning, and the
+   *     average and longest time between checks of the priority channel, in
+   *     milliseconds, or null if there is no priority channel.
+   */
+  function getStats() {
+    return {
+      channelsPerSecond: scanTime ? 1000 * scannedChannels / scanTime : 0,
+      priorityLatency: priorityChecks ? priorityGaps / priorityChecks : null,
+      maxPriorityLatency: priorityChecks ? maxPriorityGap : null
+    };
+  }
+
+  return {
+    nextBlock: nextBlock,
+    receiveBlock: receiveBlock,
+    getActiveChannel: getActiveChannel,
+    getStats: getStats
+  };
+}
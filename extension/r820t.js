@@ -55,6 +55,25 @@ function R820T(com, xtalFreq, throwError) {
   var BIT_REVS = [0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
                   0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf];
 
+  /**
+   * The bandwidths of the IF low-pass filter's settings, widest first.
+   */
+  var LOW_PASS_BWS = [1700000, 1600000, 1550000, 1450000, 1200000, 900000,
+                      700000, 550000, 450000, 350000];
+
+  /**
+   * The bandwidths added by each of the two IF high-pass filter settings
+   * when they are moved out of the way.
+   */
+  var HIGH_PASS_BW_1 = 350000;
+  var HIGH_PASS_BW_2 = 380000;
+
+  /**
+   * The intermediate frequency the tuner uses after initialization, with
+   * its 6 MHz filter.
+   */
+  var WIDE_IF_FREQ = 3570000;
+
   /**
    * Whether the PLL in the tuner is locked.
    */
@@ -88,6 +107,56 @@ function R820T(com, xtalFreq, throwError) {
     });
   }
 
+  /**
+   * Sets the bandwidth of the tuner's IF filters. Only signals within the
+   * bandwidth reach the demodulator chip, so strong signals outside of the
+   * sample rate don't alias into the samples. The intermediate frequency
+   * moves with the filters, so the tuner must be retuned afterwards.
+   * @param {number} bw The bandwidth, in Hz. The narrowest setting is
+   *     350 kHz, and anything over 2.43 MHz gets the 6 MHz filter.
+   * @param {Function} kont The continuation for this function, which
+   *     receives the new intermediate frequency.
+   */
+  function setBandwidth(bw, kont) {
+    var ifFreq = WIDE_IF_FREQ;
+    var reg0a = 0x10;
+    var reg0b = 0x6b;
+    if (bw <= LOW_PASS_BWS[0] + HIGH_PASS_BW_1 + HIGH_PASS_BW_2) {
+      reg0a = 0x00;
+      reg0b = 0x80;
+      ifFreq = 2300000;
+      var realBw = 0;
+      if (bw > LOW_PASS_BWS[0] + HIGH_PASS_BW_1) {
+        bw -= HIGH_PASS_BW_2;
+        ifFreq += HIGH_PASS_BW_2;
+        realBw += HIGH_PASS_BW_2;
+      } else {
+        reg0b |= 0x20;
+      }
+      if (bw > LOW_PASS_BWS[0]) {
+        bw -= HIGH_PASS_BW_1;
+        ifFreq += HIGH_PASS_BW_1;
+        realBw += HIGH_PASS_BW_1;
+      } else {
+        reg0b |= 0x40;
+      }
+      for (var i = 1; i < LOW_PASS_BWS.length; ++i) {
+        if (bw > LOW_PASS_BWS[i]) {
+          break;
+        }
+      }
+      reg0b |= 16 - i;
+      realBw += LOW_PASS_BWS[i - 1];
+      ifFreq -= realBw / 2;
+    }
+    writeEach([
+      [0x0a, reg0a, 0x10],
+      [0x0b, reg0b, 0xef]
+    ], function() {
+    kont(ifFreq);
+    });
+  }
+
   /**
    * Stops the tuner.
    * @param {Function} kont The continuation for this function.
@@ -386,6 +455,7 @@ function R820T(com, xtalFreq, throwError) {
   return {
     init: init,
     setFrequency: setFrequency,
+    setBandwidth: setBandwidth,
     setAutoGain: setAutoGain,
     setManualGain: setManualGain,
     close: close
@@ -14,15 +14,46 @@
 
 /**
  * High-level radio control functions.
+ *
+ * Each controller uses one USB tuner and has its own demodulator worker
+ * and audio output, so several controllers can run side by side, one per
+ * tuner. The tuners are numbered in the order the system lists them.
+ * @param {number=} opt_deviceIndex The index of the USB tuner to use,
+ *     0 by default.
  * @constructor
  */
-function RadioController() {
+function RadioController(opt_deviceIndex) {
 
   var TUNERS = [{'vendorId': 0x0bda, 'productId': 0x2832}, 
                 {'vendorId': 0x0bda, 'productId': 0x2838}];
-  var SAMPLE_RATE = 1024000; // Must be a multiple of 512 * BUFS_PER_SEC
+  // Blocks are whole multiples of 512 samples, so sample rates that are
+  // multiples of 512 * BUFS_PER_SEC give blocks of exactly 1/BUFS_PER_SEC
+  // seconds; others give slightly shorter blocks.
+  var WIDE_SAMPLE_RATE = 1024000;
+  var NARROW_SAMPLE_RATE = 256000;
+  var NARROW_MAX_FM_DEVIATION = 25000;
+  // ADS-B needs each half-microsecond chip to be a sample.
+  var ADSB_SAMPLE_RATE = 2000000;
   var BUFS_PER_SEC = 5;
-  var SAMPLES_PER_BUF = Math.floor(SAMPLE_RATE / BUFS_PER_SEC);
+  var MAX_MESSAGES = 500;
+  // APT images have 2080 pixels per line. Enough lines are kept for a
+  // whole satellite pass, after which the oldest lines are overwritten.
+  var IMAGE_WIDTH = 2080;
+  var MAX_IMAGE_LINES = 2048;
+  var MESSAGE_RATE_WEIGHT = 0.1;
+  var PPM_ESTIMATE_BLOCKS = 3;
+  var PPM_ESTIMATE_MAX_BLOCKS = 50;
+  var PPM_TARGET_ERROR = 0.5;
+  var DRIFT_GAIN = 0.02;
+  var MAX_DRIFT_PPM = 50;
+  var MIN_DRIFT_LEVEL = 0.1;
+  var DRIFT_HISTORY_BLOCKS = 25;
+  var DRIFT_HISTORY_LENGTH = 720;
+  var PPM_SEARCH_RANGE = 100;
+  var MIN_CARRIER_SNR = 25;
+  // The occupancy log only measures the channels in the middle of the
+  // tuner's span, away from where its filters roll off.
+  var OCCUPANCY_SPAN = 0.8;
   var NULL_FUNC = function(){};
   var STATE = {
     OFF: 0,
@@ -30,7 +61,8 @@ function RadioController() {
     PLAYING: 2,
     STOPPING: 3,
     CHG_FREQ: 4,
-    SCANNING: 5
+    SCANNING: 5,
+    SCANNING_PRESETS: 6
   };
   var SUBSTATE = {
     USB: 1,
@@ -40,6 +72,7 @@ function RadioController() {
     DETECTING: 5
   };
 
+  var deviceIndex = opt_deviceIndex || 0;
   var decoder = new Worker('decode-worker.js');
   var player = new Player();
   var state = new State(STATE.OFF);
@@ -50,14 +83,54 @@ function RadioController() {
   var actualFrequency = 0;
   var stereo = true;
   var stereoEnabled = true;
+  var rdsEnabled = true;
+  var rds = null;
+  var staleRdsBlocks = 0;
+  var dataDecoders = {};
   var volume = 1;
   var ppm = 0;
   var actualPpm = 0;
   var estimatingPpm = false;
   var offsetCount = -1;
-  var offsetSum = 0;
+  var offsets = [];
   var autoGain = true;
   var gain = 0;
+  var tunerFactory = null;
+  var iqWriter = null;
+  var occupancyLog = null;
+  var occupancyChannels = null;
+  var occupancyLogId = 0;
+  var nextOccupancyTime = 0;
+  var presetScanner = null;
+  var presetScanId = 0;
+  var sharingPort = 0;
+  var server = null;
+  var gainChanged = false;
+  var offsetTuning = false;
+  var retuneNeeded = false;
+  var requestedRate = WIDE_SAMPLE_RATE;
+  var sampleRate = WIDE_SAMPLE_RATE;
+  var samplesPerBuf = getSamplesPerBuf(sampleRate);
+  var driftTracking = false;
+  var driftPpm = 0;
+  var driftBlocks = 0;
+  var driftHistory = [];
+  var processedBlocks = 0;
+  var droppedBlocks = 0;
+  var cpuLoad = 0;
+  var messages = [];
+  var messageRate = 0;
+  var image = null;
+  var imageLines = 0;
+  var imageId = 0;
+  var basebandEntry = null;
+  var basebandSaver = null;
+  var basebandRate = 0;
+  var basebandFrequency = 0;
+  var timeShiftSeconds = 300;
+  var iqTimeShiftBytes = 0;
+  var timeShift = null;
+  var iqTimeShift = null;
   var errorHandler;
   var tuner;
   var connection;
@@ -69,7 +142,11 @@ function RadioController() {
    *     starts playing.
    */
   function start(opt_callback) {
-    if (state.state == STATE.OFF) {
+    if (state.state == STATE.OFF && tunerFactory) {
+      state = new State(STATE.STARTING, SUBSTATE.TUNER, opt_callback);
+      connection = null;
+      processState();
+    } else if (state.state == STATE.OFF) {
       state = new State(STATE.STARTING, SUBSTATE.USB, opt_callback);
       chrome.permissions.request(
         {'permissions': [{'usbDevices': TUNERS}]},
@@ -107,7 +184,8 @@ function RadioController() {
    */
   function setFrequency(freq) {
     if (state.state == STATE.PLAYING || state.state == STATE.CHG_FREQ
-        || state.state == STATE.SCANNING) {
+        || state.state == STATE.SCANNING
+        || state.state == STATE.SCANNING_PRESETS) {
       state = new State(STATE.CHG_FREQ, null, freq);
     } else {
       frequency = freq;
@@ -128,8 +206,14 @@ function RadioController() {
    * @param {Object} newMode The new mode.
    */
   function setMode(newMode) {
+    if (newMode.modulation == 'APT' && mode.modulation != 'APT') {
+      clearImage();
+    }
     mode = newMode;
     decoder.postMessage([1, newMode]);
+    resetRds();
+    stopSampleRateUsers();
+    updateSampleRate();
   }
 
   /**
@@ -176,12 +260,40 @@ function RadioController() {
     }
   }
 
+  /**
+   * Scans a list of channels, such as the saved stations, with the current
+   * mode. Unlike scan(), it doesn't stop at the first active channel: it
+   * listens to it until it goes quiet, and then goes on scanning, until the
+   * radio is tuned to another frequency.
+   * @param {Array.<number|{frequency:number,dwell:number}>} channels The
+   *     channels' frequencies, in Hz, and optionally how long each one
+   *     must be measured for, in milliseconds.
+   * @param {Object=} opt_options The options for the scan: the priority
+   *     channel, the dwell and hang times, how often to check the priority
+   *     channel, and how far above the noise a channel is active. See
+   *     PresetScanner.
+   */
+  function scanPresets(channels, opt_options) {
+    if (channels.length == 0) {
+      return;
+    }
+    if (state.state == STATE.PLAYING || state.state == STATE.SCANNING ||
+        state.state == STATE.SCANNING_PRESETS) {
+      presetScanner = new PresetScanner(
+          channels, getCenterFrequency, opt_options);
+      ++presetScanId;
+      state = new State(STATE.SCANNING_PRESETS);
+      ui && ui.update();
+    }
+  }
+
   /**
    * Returns whether the radio is doing a frequency scan.
    * @return {boolean} Whether the radio is doing a frequency scan.
    */
   function isScanning() {
-    return state.state == STATE.SCANNING;
+    return state.state == STATE.SCANNING ||
+           state.state == STATE.SCANNING_PRESETS;
   }
 
   /**
@@ -225,6 +337,67 @@ function RadioController() {
     return stereoEnabled;
   }
 
+  /**
+   * Enables or disables decoding the RDS information of FM stations.
+   * @param {boolean} enable Whether RDS decoding should be enabled.
+   */
+  function enableRds(enable) {
+    rdsEnabled = enable;
+    resetRds();
+    ui && ui.update();
+  }
+
+  /**
+   * Returns whether RDS decoding is enabled.
+   * @return {boolean} Whether RDS decoding is enabled.
+   */
+  function isRdsEnabled() {
+    return rdsEnabled;
+  }
+
+  /**
+   * Returns the RDS information of the current station.
+   * @return {?{pi:number,ps:string,rt:string,af:Array.<number>}} The
+   *     station's PI code, name, radio text, and alternative frequencies
+   *     in Hz, or null if none has been decoded.
+   */
+  function getRds() {
+    return rds;
+  }
+
+  /**
+   * Forgets the RDS information, and has the decoder start afresh, as must
+   * be done when tuning to another station. The replies for the blocks that
+   * are still in flight have the old station's information, so they are
+   * ignored.
+   */
+  function resetRds() {
+    rds = null;
+    staleRdsBlocks = playingBlocks;
+    decoder.postMessage([3, rdsEnabled]);
+  }
+
+  /**
+   * Enables or disables a decoder for the digital data sent in the
+   * demodulated audio. Its output is kept with the other messages.
+   * @param {string} name The decoder's name: 'APRS' and 'POCSAG' decode
+   *     the packets and pages sent in narrowband FM.
+   * @param {boolean} enable Whether to run the decoder.
+   */
+  function enableDecoder(name, enable) {
+    dataDecoders[name] = enable;
+    decoder.postMessage([4, name, enable]);
+  }
+
+  /**
+   * Returns whether a data decoder is enabled.
+   * @param {string} name The decoder's name.
+   * @return {boolean} Whether the decoder is enabled.
+   */
+  function isDecoderEnabled(name) {
+    return !!dataDecoders[name];
+  }
+
   /**
    * Sets the playing volume.
    * @param {number} newVolume The volume, a value between 0 and 1.
@@ -295,6 +468,455 @@ function RadioController() {
     return gain;
   }
 
+  /**
+   * Sets a function that creates the tuner to read samples from, instead of
+   * the USB tuner. The tuner it returns must have the same methods as
+   * RTL2832U. The setting takes effect the next time the radio is started.
+   * @param {?function(number, ?number):Object} factory A function that
+   *     receives the frequency correction factor and the gain (null for
+   *     automatic gain) and returns a tuner, or null to use the USB tuner.
+   */
+  function setTunerFactory(factory) {
+    tunerFactory = factory;
+  }
+
+  /**
+   * Sets the port to share the tuner's samples on, using the rtl_tcp
+   * protocol. The setting takes effect the next time the radio is started.
+   * @param {number} port The TCP port, or 0 not to share the tuner.
+   */
+  function setSharingPort(port) {
+    sharingPort = port;
+  }
+
+  /**
+   * Starts sharing the tuner's samples, if it was requested.
+   */
+  function startServer() {
+    if (!sharingPort || server) {
+      return;
+    }
+    server = new RtlTcpServer(sharingPort, {
+      setFrequency: tuneExactly,
+      setGain: changeGain
+    });
+    server.setOnError(throwError);
+    server.start(NULL_FUNC);
+  }
+
+  /**
+   * Stops sharing the tuner's samples.
+   */
+  function stopServer() {
+    if (server) {
+      server.stop(NULL_FUNC);
+      server = null;
+    }
+  }
+
+  /**
+   * Returns the number of programs receiving the tuner's samples.
+   * @return {number} The number of clients.
+   */
+  function getSharingClients() {
+    return server ? server.getClientCount() : 0;
+  }
+
+  /**
+   * Enables or disables offset tuning. With offset tuning, the tuner is
+   * tuned a quarter of the sample rate above the station, which keeps the
+   * tuner's DC spike away from the station; the decoder shifts the samples
+   * back almost for free. Takes effect immediately if the radio is playing.
+   * @param {boolean} enable Whether to use offset tuning.
+   */
+  function setOffsetTuning(enable) {
+    if (offsetTuning == !!enable) {
+      return;
+    }
+    offsetTuning = !!enable;
+    if (state.state == STATE.PLAYING || state.state == STATE.CHG_FREQ) {
+      retuneNeeded = true;
+      var freq = state.state == STATE.CHG_FREQ ? state.param : frequency;
+      state = new State(STATE.CHG_FREQ, state.substate, freq);
+    }
+  }
+
+  /**
+   * Returns whether offset tuning is enabled.
+   * @return {boolean} Whether offset tuning is enabled.
+   */
+  function isOffsetTuning() {
+    return offsetTuning;
+  }
+
+  /**
+   * Returns the sample rate the tuner should use for the current mode.
+   * Narrowband modes don't need the whole megahertz that broadcast FM
+   * needs, so they use a quarter of the rate, which needs a quarter of the
+   * USB bandwidth and of the decoder's time. The rate doesn't change while
+   * the tuner's samples are being shared or captured, since whoever
+   * receives them expects the rate they started with. ADS-B and AIS can't
+   * be decoded at any other rate than their own, so switching to them stops
+   * the capture and the sharing; see stopSampleRateUsers.
+   * @return {number} The sample rate, in samples per second.
+   */
+  function getWantedSampleRate() {
+    if (mode.modulation == 'ADSB') {
+      return ADSB_SAMPLE_RATE;
+    }
+    if (mode.modulation == 'AIS') {
+      return WIDE_SAMPLE_RATE;
+    }
+    if (sharingPort) {
+      return WIDE_SAMPLE_RATE;
+    }
+    if (iqWriter) {
+      return requestedRate;
+    }
+    switch (mode.modulation) {
+      case 'AM':
+      case 'LSB':
+      case 'USB':
+      case 'APT':
+        return NARROW_SAMPLE_RATE;
+      case 'NBFM':
+        return mode.maxF <= NARROW_MAX_FM_DEVIATION ?
+            NARROW_SAMPLE_RATE : WIDE_SAMPLE_RATE;
+      default:
+        return WIDE_SAMPLE_RATE;
+    }
+  }
+
+  /**
+   * Stops capturing and sharing the tuner's samples if the current mode
+   * needs a different sample rate than the one they started with. The
+   * capture file only records one sample rate, and the network clients
+   * don't expect it to change, so the samples at the new rate would be
+   * read wrongly.
+   */
+  function stopSampleRateUsers() {
+    if (getWantedSampleRate() == requestedRate) {
+      return;
+    }
+    var stopped = [];
+    if (iqWriter) {
+      iqWriter.finish();
+      iqWriter = null;
+      stopped.push('capturing');
+    }
+    if (server) {
+      stopServer();
+      stopped.push('sharing');
+    }
+    if (stopped.length > 0) {
+      ui && ui.update();
+      throwError('Stopped ' + stopped.join(' and ') + ' the tuner\'s ' +
+                 'samples, because the ' + mode.modulation + ' mode needs ' +
+                 'a different sample rate.');
+    }
+  }
+
+  /**
+   * Changes the tuner's sample rate if the current mode needs a different
+   * one. Takes effect immediately if the radio is playing; otherwise, when
+   * it starts playing or stops scanning.
+   */
+  function updateSampleRate() {
+    if (getWantedSampleRate() != requestedRate &&
+        (state.state == STATE.PLAYING || state.state == STATE.CHG_FREQ)) {
+      var freq = state.state == STATE.CHG_FREQ ? state.param : frequency;
+      state = new State(STATE.CHG_FREQ, state.substate, freq);
+    }
+  }
+
+  /**
+   * Sets the tuner's sample rate to the one wanted for the current mode,
+   * and reconfigures the decoder for the rate the tuner actually uses.
+   * @param {Function} kont The continuation for this function.
+   */
+  function changeSampleRate(kont) {
+    requestedRate = getWantedSampleRate();
+    tuner.setSampleRate(requestedRate, function(rate) {
+      sampleRate = rate;
+      samplesPerBuf = getSamplesPerBuf(rate);
+      decoder.postMessage([1, mode, rate]);
+      kont();
+    });
+  }
+
+  /**
+   * Returns the number of samples to read in each block at a sample rate.
+   * @param {number} rate The sample rate.
+   * @return {number} The number of samples per block.
+   */
+  function getSamplesPerBuf(rate) {
+    return 512 * Math.max(1, Math.floor(rate / BUFS_PER_SEC / 512));
+  }
+
+  /**
+   * Returns the sample rate the tuner is using.
+   * @return {number} The sample rate, in samples per second.
+   */
+  function getSampleRate() {
+    return sampleRate;
+  }
+
+  /**
+   * Enables or disables tracking the tuner's frequency drift. The tuner's
+   * crystal drifts by several PPM as it warms up; while tracking, the
+   * offset of FM stations is measured in every block and the drift is
+   * corrected by the decoder's frequency shift, slowly, without retuning.
+   * @param {boolean} enable Whether to track the drift.
+   */
+  function setDriftTracking(enable) {
+    driftTracking = !!enable;
+    if (!driftTracking) {
+      resetDrift();
+    }
+  }
+
+  /**
+   * Returns whether the frequency drift is being tracked.
+   * @return {boolean} Whether the drift is tracked.
+   */
+  function isDriftTracking() {
+    return driftTracking;
+  }
+
+  /**
+   * Forgets the tracked frequency drift.
+   */
+  function resetDrift() {
+    driftPpm = 0;
+    driftBlocks = 0;
+    driftHistory = [];
+  }
+
+  /**
+   * Updates the tracked frequency drift with a new measurement.
+   * @param {number} offset How far the station was from where it should be,
+   *     after the current drift correction, in Hz.
+   */
+  function trackDrift(offset) {
+    var error = -1e6 * offset / frequency;
+    driftPpm = Math.max(-MAX_DRIFT_PPM,
+                        Math.min(MAX_DRIFT_PPM, driftPpm + DRIFT_GAIN * error));
+    if (++driftBlocks % DRIFT_HISTORY_BLOCKS == 0) {
+      driftHistory.push({time: Date.now(), ppm: driftPpm});
+      if (driftHistory.length > DRIFT_HISTORY_LENGTH) {
+        driftHistory.shift();
+      }
+    }
+  }
+
+  /**
+   * Returns the tracked frequency drift.
+   * @return {number} The drift, in parts per million.
+   */
+  function getDrift() {
+    return driftPpm;
+  }
+
+  /**
+   * Returns the tracked frequency drift over the last hour, measured every
+   * 5 seconds.
+   * @return {Array.<{time:number,ppm:number}>} The time of each measurement,
+   *     in milliseconds since the epoch, and the drift, in parts per million.
+   */
+  function getDriftHistory() {
+    return driftHistory.slice();
+  }
+
+  /**
+   * Returns the frequency the decoder must shift the samples by to bring a
+   * station to the center, including the correction for the tracked drift.
+   * @param {number} freq The station's frequency.
+   * @return {number} The frequency shift.
+   */
+  function getDecoderOffset(freq) {
+    return actualFrequency - freq + driftPpm * freq / 1e6;
+  }
+
+  /**
+   * Returns the frequency to tune the tuner to to receive a station.
+   * @param {number} freq The station's frequency.
+   * @return {number} The tuner's center frequency.
+   */
+  function getCenterFrequency(freq) {
+    return freq + (offsetTuning && !isWholeBandMode() ? sampleRate / 4 : 0);
+  }
+
+  /**
+   * Returns whether the current mode uses all the bandwidth of the
+   * samples, so the tuner must be tuned right to the signal.
+   * @return {boolean} Whether it uses all the bandwidth.
+   */
+  function isWholeBandMode() {
+    return mode.modulation == 'ADSB';
+  }
+
+  /**
+   * Returns whether the tuner must be retuned to receive a station, or if
+   * the station is close enough to the tuner's current center frequency
+   * that the decoder can shift it to the center instead.
+   * @param {number} freq The station's frequency.
+   * @return {boolean} Whether the tuner must be retuned.
+   */
+  function mustRetune(freq) {
+    return Math.abs(actualFrequency - getCenterFrequency(freq)) >
+           getMaxTuningDistance();
+  }
+
+  /**
+   * Returns how far the tuner's center frequency can be from the one that
+   * getCenterFrequency gives for a station, for the decoder to receive the
+   * station without retuning.
+   * @return {number} The distance, in Hz.
+   */
+  function getMaxTuningDistance() {
+    return sampleRate * (isWholeBandMode() ? 0.01 :
+                         offsetTuning ? 0.15 : 0.3);
+  }
+
+  /**
+   * Returns the width of a channel in the current mode, to measure its
+   * power. SSB channels are measured on both sides of their frequency.
+   * @return {number} The width, in Hz.
+   */
+  function getChannelWidth() {
+    switch (mode.modulation) {
+      case 'WBFM':
+        return 150000;
+      case 'NBFM':
+        return 2 * (mode.maxF + 3000);
+      case 'AM':
+        return mode.bandwidth;
+      case 'LSB':
+      case 'USB':
+        return 2 * mode.bandwidth;
+      default:
+        return 25000;
+    }
+  }
+
+  /**
+   * Tunes the device so that the given frequency is exactly at the center
+   * of the samples, as an rtl_tcp client expects, and tunes the radio to
+   * that frequency.
+   * @param {number} freq The frequency, in Hz.
+   */
+  function tuneExactly(freq) {
+    if (state.state == STATE.PLAYING || state.state == STATE.CHG_FREQ) {
+      state = new State(STATE.CHG_FREQ, SUBSTATE.TUNING, freq);
+    } else {
+      setFrequency(freq);
+    }
+  }
+
+  /**
+   * Changes the tuner's gain while the radio is playing.
+   * @param {?number} newGain The gain in dB, or null for automatic gain.
+   */
+  function changeGain(newGain) {
+    if (newGain == null) {
+      setAutoGain();
+    } else {
+      setManualGain(newGain);
+    }
+    if (state.state == STATE.PLAYING || state.state == STATE.CHG_FREQ) {
+      gainChanged = true;
+      var freq = state.state == STATE.CHG_FREQ ? state.param : frequency;
+      state = new State(STATE.CHG_FREQ, state.substate, freq);
+    }
+    ui && ui.update();
+  }
+
+  /**
+   * Silences or unsilences this radio without changing its volume.
+   * @param {boolean} mute Whether to silence the radio.
+   */
+  function setMuted(mute) {
+    player.setMuted(mute);
+  }
+
+  /**
+   * Returns the statistics of this radio's pipeline, to find out how many
+   * tuners the computer can keep up with.
+   * @return {Object} The tuner's index and frequency, the number of blocks
+   *     demodulated and dropped, the fraction of real time the demodulator
+   *     spends on each block, the number of messages decoded per second,
+   *     the tracked frequency drift, the preset scan's throughput, the
+   *     number of network clients, the tuner's own statistics, if any, and
+   *     how long the window takes to update.
+   */
+  function getStats() {
+    return {
+      device: deviceIndex,
+      playing: isPlaying(),
+      frequency: frequency,
+      processedBlocks: processedBlocks,
+      droppedBlocks: droppedBlocks,
+      cpuLoad: cpuLoad,
+      messageRate: messageRate,
+      drift: driftTracking ? driftPpm : null,
+      scan: state.state == STATE.SCANNING_PRESETS ?
+          presetScanner.getStats() : null,
+      sharingClients: getSharingClients(),
+      tuner: getTunerStats(),
+      ui: ui ? ui.getUpdateStats() : null
+    };
+  }
+
+  /**
+   * Returns the latest messages decoded by digital modes, like ADS-B.
+   * @param {number=} opt_since Only return the messages decoded after this
+   *     time, in milliseconds since the epoch.
+   * @return {Array.<Object>} The messages, oldest first. Each has a type,
+   *     a text summary, the time it was decoded, and fields that depend on
+   *     its type.
+   */
+  function getMessages(opt_since) {
+    var since = opt_since || 0;
+    return messages.filter(function(msg) { return msg.time > since; });
+  }
+
+  /**
+   * Returns the image decoded by the APT mode. The pixels are kept in a
+   * buffer that is allocated once; when it is full, each new line
+   * overwrites the oldest one.
+   * @return {{id:number,width:number,lines:number,maxLines:number,pixels:Uint8Array}}
+   *     An identifier that changes when the image is cleared, the width of
+   *     the image, the number of lines received since it was cleared, the
+   *     number of lines the buffer holds, and the buffer. Line number n is
+   *     at row n % maxLines of the buffer. The buffer is null until the
+   *     first line arrives.
+   */
+  function getImage() {
+    return {
+      id: imageId,
+      width: IMAGE_WIDTH,
+      lines: imageLines,
+      maxLines: MAX_IMAGE_LINES,
+      pixels: image
+    };
+  }
+
+  /**
+   * Forgets the image decoded by the APT mode, to start a new one.
+   */
+  function clearImage() {
+    imageLines = 0;
+    ++imageId;
+  }
+
+  /**
+   * Returns the statistics of the current tuner, if it keeps any.
+   * @return {Object} The statistics, or null.
+   */
+  function getTunerStats() {
+    return tuner && tuner.getStats ? tuner.getStats() : null;
+  }
+
   /**
    * Saves a reference to the current user interface controller.
    * @param {Object} iface The controller. Must have an update() method.
@@ -348,6 +970,8 @@ function RadioController() {
         return stateChangeFrequency();
       case STATE.SCANNING:
         return stateScanning();
+      case STATE.SCANNING_PRESETS:
+        return statePresetScanning();
       case STATE.STOPPING:
         return stateStopping();
     }
@@ -365,23 +989,30 @@ function RadioController() {
   function stateStarting() {
     if (state.substate == SUBSTATE.USB) {
       state = new State(STATE.STARTING, SUBSTATE.TUNER, state.param);
-      doFindDevices(0);
+      doFindDevices(0, []);
     } else if (state.substate == SUBSTATE.TUNER) {
       state = new State(STATE.STARTING, SUBSTATE.ALL_ON, state.param);
       actualPpm = ppm;
-      tuner = new RTL2832U(connection, actualPpm, autoGain ? null : gain);
+      resetDrift();
+      if (connection) {
+        tuner = new RTL2832U(connection, actualPpm, autoGain ? null : gain);
+      } else {
+        tuner = tunerFactory(actualPpm, autoGain ? null : gain);
+      }
       tuner.setOnError(throwError);
       tuner.open(function() {
-      tuner.setSampleRate(SAMPLE_RATE, function(rate) {
-      offsetSum = 0;
-      offsetCount = -1;
-      tuner.setCenterFrequency(frequency, function(actualFreq) {
+      changeSampleRate(function() {
+      resetPpmEstimate();
+      tuner.setCenterFrequency(getCenterFrequency(frequency),
+          function(actualFreq) {
       actualFrequency = actualFreq;
       processState();
       })})});
     } else if (state.substate == SUBSTATE.ALL_ON) {
       var cb = state.param;
       state = new State(STATE.PLAYING);
+      allocateTimeShift();
+      startServer();
       tuner.resetBuffer(function() {
       cb && cb();
       ui && ui.update();
@@ -391,27 +1022,44 @@ function RadioController() {
   }
 
   /**
-   * Finds the first matching tuner USB device in the tuner device definition
-   * list and transitions to the next substate.
-   * @param {number} index The first element in the list to find.
+   * Lists all the matching tuner USB devices in the tuner device definition
+   * list, opens the one for this controller and transitions to the next
+   * substate.
+   * @param {number} index The next element in the list to find.
+   * @param {Array.<Object>} found The devices found so far.
    */
-  function doFindDevices(index) {
-    if (index == TUNERS.length) {
+  function doFindDevices(index, found) {
+    if (index < TUNERS.length) {
+      chrome.usb.getDevices(TUNERS[index], function(devices) {
+        doFindDevices(index + 1, found.concat(devices || []));
+      });
+      return;
+    }
+    if (found.length == 0) {
       state = new State(STATE.OFF);
       throwError('USB tuner device not found. The Radio Receiver ' +
                  'app needs an RTL2832U-based DVB-T dongle ' +
                  '(with an R820T tuner chip) to work.');
-    } else {
-      chrome.usb.findDevices(TUNERS[index],
-          function(conns) {
-            if (conns.length == 0) {
-              doFindDevices(index + 1);
-            } else {
-              connection = conns[0];
-              processState();
-            }
-          });
+      return;
     }
+    if (deviceIndex >= found.length) {
+      state = new State(STATE.OFF);
+      throwError('USB tuner device number ' + (deviceIndex + 1) +
+                 ' not found. Only ' + found.length +
+                 ' tuners are plugged in.');
+      return;
+    }
+    found.sort(function(a, b) { return a.device - b.device; });
+    chrome.usb.openDevice(found[deviceIndex], function(conn) {
+      if (!conn) {
+        state = new State(STATE.OFF);
+        throwError('Could not open USB tuner device number ' +
+                   (deviceIndex + 1) + '.');
+        return;
+      }
+      connection = conn;
+      processState();
+    });
   }
 
   /**
@@ -422,13 +1070,24 @@ function RadioController() {
    */
   function statePlaying() {
     ++requestingBlocks;
-    tuner.readSamples(SAMPLES_PER_BUF, function(data) {
+    tuner.readSamples(samplesPerBuf, function(data) {
       --requestingBlocks;
       if (state.state == STATE.PLAYING) {
+        shareBlock(data);
         if (playingBlocks <= 2) {
           ++playingBlocks;
-          decoder.postMessage(
-              [0, data, stereoEnabled, actualFrequency - frequency], [data]);
+          var msg = [0, data, stereoEnabled, getDecoderOffset(frequency)];
+          var blockData = getOccupancyRequest() || {};
+          if (estimatingPpm) {
+            blockData['estimatingPpm'] = true;
+            if (usesCarrierForPpm()) {
+              blockData['findCarrier'] = getPpmSearchWidth();
+            }
+          }
+          msg.push(blockData);
+          decoder.postMessage(msg, [data]);
+        } else {
+          ++droppedBlocks;
         }
       }
       processState();
@@ -446,13 +1105,28 @@ function RadioController() {
     if (requestingBlocks > 0) {
       return;
     }
+    var exact = state.substate == SUBSTATE.TUNING;
     frequency = state.param;
     ui && ui.update();
-    offsetSum = 0;
-    offsetCount = -1;
-    if (Math.abs(actualFrequency - frequency) > 300000) {
-      tuner.setCenterFrequency(frequency, function(actualFreq) {
-      actualFrequency = frequency;
+    resetPpmEstimate();
+    resetRds();
+    if (gainChanged && tuner.setGain) {
+      gainChanged = false;
+      tuner.setGain(autoGain ? null : gain, function() {
+        processState();
+      });
+      return;
+    }
+    if (getWantedSampleRate() != requestedRate) {
+      retuneNeeded = true;
+      changeSampleRate(processState);
+      return;
+    }
+    if (exact || retuneNeeded || mustRetune(frequency)) {
+      retuneNeeded = false;
+      var center = exact ? frequency : getCenterFrequency(frequency);
+      tuner.setCenterFrequency(center, function(actualFreq) {
+      actualFrequency = actualFreq;
       tuner.resetBuffer(function() {
       state = new State(STATE.PLAYING);
       startPipeline();
@@ -489,10 +1163,11 @@ function RadioController() {
       }
       ui && ui.update();
       state = new State(STATE.SCANNING, SUBSTATE.DETECTING, param);
-      offsetSum = 0;
-      offsetCount = -1;
-      if (Math.abs(actualFrequency - frequency) > 300000) {
-        tuner.setCenterFrequency(frequency, function(actualFreq) {
+      resetPpmEstimate();
+      resetRds();
+      if (mustRetune(frequency)) {
+        tuner.setCenterFrequency(getCenterFrequency(frequency),
+            function(actualFreq) {
         actualFrequency = actualFreq;
         tuner.resetBuffer(processState);
         });
@@ -506,12 +1181,13 @@ function RadioController() {
         'frequency': frequency
       };
       ++requestingBlocks;
-      tuner.readSamples(SAMPLES_PER_BUF, function(data) {
+      tuner.readSamples(samplesPerBuf, function(data) {
         --requestingBlocks;
         if (state.state == STATE.SCANNING) {
+          shareBlock(data);
           ++playingBlocks;
           decoder.postMessage(
-              [0, data, stereoEnabled, actualFrequency - frequency, scanData],
+              [0, data, stereoEnabled, getDecoderOffset(frequency), scanData],
               [data]);
         }
         processState();
@@ -519,6 +1195,95 @@ function RadioController() {
     }
   }
 
+  /**
+   * SCANNING_PRESETS state. Scans a list of channels.
+   *
+   * The preset scanner decides what to do with each block after it has
+   * seen the measurements of the last one, so while it's scanning there is
+   * only one block in flight, and this state goes on when the demodulator
+   * returns the block, instead of when the tuner delivers it. The channels
+   * that are within the tuner's span are measured without retuning, and
+   * blocks that only measure channels are shorter and muted.
+   *
+   * While it's listening to an active channel, the blocks are read like in
+   * the PLAYING state, with 2 blocks in flight so the audio doesn't have
+   * gaps, and the scanner sees their measurements a block or two late.
+   */
+  function statePresetScanning() {
+    var block = presetScanner.nextBlock(
+        Date.now(), actualFrequency, getMaxTuningDistance());
+    var pipelined = block.listening && block.center == actualFrequency;
+    if (requestingBlocks >= (pipelined ? 2 : 1)) {
+      return;
+    }
+    if (!block.lookingBack && block.frequency != frequency) {
+      frequency = block.frequency;
+      resetRds();
+      ui && ui.update();
+    }
+    if (block.center != actualFrequency) {
+      tuner.setCenterFrequency(block.center, function(actualFreq) {
+      actualFrequency = actualFreq;
+      tuner.resetBuffer(function() {
+      readPresetScanBlocks(block);
+      })});
+    } else {
+      readPresetScanBlocks(block);
+    }
+  }
+
+  /**
+   * Reads blocks for the preset scan: one if the scanner is scanning, or
+   * enough to have 2 blocks in flight if it's listening.
+   * @param {Object} block The blocks' plan, from the preset scanner.
+   */
+  function readPresetScanBlocks(block) {
+    do {
+      readPresetScanBlock(block);
+    } while (block.listening && requestingBlocks < 2);
+  }
+
+  /**
+   * Reads a block for the preset scan and sends it to the decoder, asking
+   * it to measure the block's channels.
+   * @param {Object} block The block's plan, from the preset scanner.
+   */
+  function readPresetScanBlock(block) {
+    var length = samplesPerBuf;
+    if (block.duration) {
+      length = Math.min(samplesPerBuf, 512 * Math.max(1,
+          Math.ceil(block.duration * sampleRate / 1000 / 512)));
+    }
+    ++requestingBlocks;
+    tuner.readSamples(length, function(data) {
+      --requestingBlocks;
+      if (state.state != STATE.SCANNING_PRESETS) {
+        processState();
+        return;
+      }
+      shareBlock(data);
+      ++playingBlocks;
+      var channelOffsets = [];
+      for (var i = 0; i < block.measure.length; ++i) {
+        channelOffsets.push(-getDecoderOffset(block.measure[i]));
+      }
+      var scanData = {
+        'presetScan': presetScanId,
+        'scanBlock': block,
+        'listening': block.listening,
+        'blockSamples': length,
+        'measureChannels': [channelOffsets, getChannelWidth()]
+      };
+      decoder.postMessage(
+          [0, data, stereoEnabled, getDecoderOffset(block.frequency),
+           scanData],
+          [data]);
+      if (block.listening) {
+        processState();
+      }
+    });
+  }
+
   /**
    * STOPPING state. Stops playing and shuts the tuner down.
    *
@@ -540,12 +1305,17 @@ function RadioController() {
       });
     } else if (state.substate == SUBSTATE.TUNER) {
       state = new State(STATE.STOPPING, SUBSTATE.USB, state.param);
-      chrome.usb.closeDevice(connection, function() {
+      if (connection) {
+        chrome.usb.closeDevice(connection, function() {
+          processState();
+        });
+      } else {
         processState();
-      });
+      }
     } else if (state.substate == SUBSTATE.USB) {
       var cb = state.param;
       state = new State(STATE.OFF);
+      stopServer();
       cb && cb();
       ui && ui.update();
     }
@@ -557,6 +1327,11 @@ function RadioController() {
    */
   function receiveDemodulated(msg) {
     --playingBlocks;
+    ++processedBlocks;
+    var blockSamples = msg.data[2]['blockSamples'] || samplesPerBuf;
+    var load = msg.data[2]['processingTime'] * sampleRate / blockSamples /
+               1000;
+    cpuLoad = processedBlocks == 1 ? load : cpuLoad * 0.9 + load * 0.1;
     var newStereo = msg.data[2]['stereo'];
     if (newStereo != stereo) {
       stereo = newStereo;
@@ -565,24 +1340,102 @@ function RadioController() {
     var level = msg.data[2]['signalLevel'];
     var left = new Float32Array(msg.data[0]);
     var right = new Float32Array(msg.data[1]);
-    player.play(left, right, level, squelch / 100);
+    if (msg.data[2]['presetScan'] && !msg.data[2]['listening']) {
+      player.play(left, right, 0, 1);
+    } else {
+      player.play(left, right, level, squelch / 100);
+    }
+    if (msg.data[2]['baseband']) {
+      var baseband = new Int16Array(msg.data[2]['baseband']);
+      var iqRate = msg.data[2]['basebandRate'];
+      saveBaseband(baseband, iqRate);
+      if (iqTimeShift) {
+        iqTimeShift.write(baseband, iqRate, frequency);
+      }
+    }
     if (state.state == STATE.SCANNING && msg.data[2]['scanning']) {
       if (msg.data[2]['signalLevel'] > 0.5) {
         setFrequency(msg.data[2].frequency);
       }
-    } else if (estimatingPpm) {
+    } else if (estimatingPpm && msg.data[2]['estimatingPpm']) {
       if (offsetCount >= 0) {
-        var sum = 0;
-        for (var i = 0; i < left.length; ++i) {
-          sum += left[i];
+        if (!usesCarrierForPpm()) {
+          offsets.push(msg.data[2]['fmOffset']);
+        } else if (msg.data[2]['carrierSnr'] >= MIN_CARRIER_SNR) {
+          offsets.push(msg.data[2]['carrierOffset']);
         }
-        offsetSum += sum / left.length;
       }
       ++offsetCount;
-      if (offsetCount == 50) {
+      if (offsetCount >= PPM_ESTIMATE_BLOCKS &&
+          (getPpmEstimate().error <= PPM_TARGET_ERROR ||
+           offsetCount == PPM_ESTIMATE_MAX_BLOCKS)) {
         estimatingPpm = false;
       }
     }
+    receiveMessages(msg.data[2]['messages'] || []);
+    receiveImageLines(msg.data[2]['imageLines'] || []);
+    if (msg.data[2]['presetScan']) {
+      if (msg.data[2]['presetScan'] == presetScanId &&
+          state.state == STATE.SCANNING_PRESETS) {
+        presetScanner.receiveBlock(msg.data[2]['scanBlock'], Date.now(),
+                                   msg.data[2]['channelPowers'],
+                                   msg.data[2]['noiseLevel']);
+      }
+      if (!msg.data[2]['listening']) {
+        processState();
+      }
+    } else if (msg.data[2]['channelPowers']) {
+      logOccupancy(msg.data[2]);
+    }
+    if (staleRdsBlocks > 0) {
+      --staleRdsBlocks;
+    } else if (state.state == STATE.PLAYING && !msg.data[2]['scanning']) {
+      var newRds = msg.data[2]['rds'] || null;
+      if (JSON.stringify(newRds) != JSON.stringify(rds)) {
+        rds = newRds;
+        ui && ui.update();
+      }
+    }
+    if (driftTracking && state.state == STATE.PLAYING &&
+        !msg.data[2]['scanning'] && 'fmOffset' in msg.data[2] &&
+        level >= Math.max(squelch / 100, MIN_DRIFT_LEVEL)) {
+      trackDrift(msg.data[2]['fmOffset']);
+    }
+  }
+
+  /**
+   * Keeps the messages decoded from a block, and updates the rate at which
+   * they are decoded.
+   * @param {Array.<Object>} newMessages The messages.
+   */
+  function receiveMessages(newMessages) {
+    var now = Date.now();
+    for (var i = 0; i < newMessages.length; ++i) {
+      newMessages[i].time = now;
+      messages.push(newMessages[i]);
+    }
+    if (messages.length > MAX_MESSAGES) {
+      messages.splice(0, messages.length - MAX_MESSAGES);
+    }
+    var rate = newMessages.length * sampleRate / samplesPerBuf;
+    messageRate += MESSAGE_RATE_WEIGHT * (rate - messageRate);
+  }
+
+  /**
+   * Adds the image lines decoded from a block to the image.
+   * @param {Array.<Uint8Array>} lines The lines.
+   */
+  function receiveImageLines(lines) {
+    if (lines.length == 0) {
+      return;
+    }
+    if (!image) {
+      image = new Uint8Array(IMAGE_WIDTH * MAX_IMAGE_LINES);
+    }
+    for (var i = 0; i < lines.length; ++i) {
+      image.set(lines[i], (imageLines % MAX_IMAGE_LINES) * IMAGE_WIDTH);
+      ++imageLines;
+    }
   }
 
   decoder.addEventListener('message', receiveDemodulated);
@@ -593,8 +1446,36 @@ function RadioController() {
    */
   function estimatePpm(doEstimate) {
     estimatingPpm = doEstimate;
-    offsetSum = 0;
+    resetPpmEstimate();
+  }
+
+  /**
+   * Discards the measurements for the frequency correction estimate.
+   */
+  function resetPpmEstimate() {
     offsetCount = -1;
+    offsets = [];
+  }
+
+  /**
+   * Returns whether the frequency correction is estimated from the
+   * position of the station's carrier. FM stations don't have a steady
+   * carrier; the modulation spreads it into many lines that could be
+   * mistaken for it, so the DC of their demodulated audio is used instead.
+   * @return {boolean} Whether the carrier is used.
+   */
+  function usesCarrierForPpm() {
+    return mode.modulation != 'WBFM' && mode.modulation != 'NBFM';
+  }
+
+  /**
+   * Returns how far from the tuned frequency the decoder should look for
+   * the station's carrier to estimate the frequency correction.
+   * @return {number} The distance, in Hz.
+   */
+  function getPpmSearchWidth() {
+    return Math.min(sampleRate / 4,
+                    Math.max(5000, frequency * PPM_SEARCH_RANGE / 1e6));
   }
 
   /**
@@ -606,16 +1487,38 @@ function RadioController() {
 
   /**
    * Returns an estimated needed frequency correction.
-   * @return {number} The estimated correction, in parts per million.
+   *
+   * For AM and SSB the estimate comes from the position of the station's
+   * carrier in the spectrum, which is precise enough after a few blocks,
+   * under a second. For FM it comes from the DC of the demodulated audio,
+   * which is only as precise as the program's own DC is small, so it goes
+   * on for up to 10 seconds, until the error is small enough.
+   * @return {{ppm:number,error:number,carrier:boolean}} The estimated
+   *     correction, in parts per million; its standard error, in parts per
+   *     million, or NaN if there is no estimate; and whether the station's
+   *     carrier was used.
    */
   function getPpmEstimate() {
-    if (offsetCount > 0) {
-      var offset = offsetSum / offsetCount;
-      var freqOffset = 75000 * offset;
-      return Math.round(actualPpm - 1e6 * freqOffset / frequency);
-    } else {
-      return 0;
+    var carrier = usesCarrierForPpm();
+    var n = offsets.length;
+    if (n == 0) {
+      return {ppm: 0, error: NaN, carrier: carrier};
+    }
+    var sum = 0;
+    for (var i = 0; i < n; ++i) {
+      sum += offsets[i];
+    }
+    var mean = sum / n;
+    var variance = 0;
+    for (var i = 0; i < n; ++i) {
+      variance += (offsets[i] - mean) * (offsets[i] - mean);
     }
+    var error = n > 1 ? Math.sqrt(variance / (n - 1) / n) : Infinity;
+    return {
+      ppm: Math.round(actualPpm + driftPpm - 1e6 * mean / frequency),
+      error: 1e6 * error / frequency,
+      carrier: carrier
+    };
   }
 
   /**
@@ -641,6 +1544,317 @@ function RadioController() {
     return player.isWriting();
   }
 
+  /**
+   * Starts saving the tuner's output into the given file entry.
+   * @param {FileEntry} fileEntry The entry for the new capture file.
+   */
+  function startCapture(fileEntry) {
+    stopCapture();
+    iqWriter = new IqFileWriter(fileEntry, sampleRate, actualFrequency);
+    ui && ui.update();
+  }
+
+  /**
+   * Stops saving the tuner's output.
+   */
+  function stopCapture() {
+    if (iqWriter) {
+      iqWriter.finish();
+      iqWriter = null;
+      updateSampleRate();
+    }
+    ui && ui.update();
+  }
+
+  /**
+   * Tells whether the tuner's output is being saved.
+   */
+  function isCapturing() {
+    return iqWriter != null;
+  }
+
+  /**
+   * Starts logging the power of the channels in the tuner's span into the
+   * given file entry. The channels are the multiples of the step that are
+   * in the middle of the span when logging starts; if the tuner is retuned
+   * afterwards, the channels it doesn't cover anymore are logged as not
+   * measured. Each measurement is taken on the first block that arrives
+   * after its time, so it's only taken while the radio is playing, and the
+   * interval is effectively rounded to whole blocks.
+   * @param {FileEntry} fileEntry The entry for the log file.
+   * @param {number} step The distance between channels, in Hz.
+   * @param {number} interval The interval between measurements, in
+   *     milliseconds.
+   */
+  function startOccupancyLog(fileEntry, step, interval) {
+    stopOccupancyLog();
+    var center = actualFrequency || getCenterFrequency(frequency);
+    var halfSpan = (sampleRate * OCCUPANCY_SPAN - step) / 2;
+    var first = Math.ceil((center - halfSpan) / step);
+    var last = Math.floor((center + halfSpan) / step);
+    occupancyChannels = {
+      first: first * step,
+      step: step,
+      count: Math.max(1, last - first + 1),
+      interval: interval
+    };
+    occupancyLog = new OccupancyLogWriter(
+        fileEntry, occupancyChannels.first, step, occupancyChannels.count,
+        interval);
+    ++occupancyLogId;
+    nextOccupancyTime = 0;
+    ui && ui.update();
+  }
+
+  /**
+   * Stops logging the power of the channels.
+   */
+  function stopOccupancyLog() {
+    if (occupancyLog) {
+      occupancyLog.finish();
+      occupancyLog = null;
+      occupancyChannels = null;
+    }
+    ui && ui.update();
+  }
+
+  /**
+   * Tells whether the power of the channels is being logged.
+   */
+  function isLoggingOccupancy() {
+    return occupancyLog != null;
+  }
+
+  /**
+   * Returns the channels being logged.
+   * @return {?{first:number,step:number,count:number,interval:number}}
+   *     The frequency of the first channel, the distance between channels,
+   *     their number, and the interval between measurements in
+   *     milliseconds, or null if they aren't being logged.
+   */
+  function getOccupancyChannels() {
+    return occupancyChannels;
+  }
+
+  /**
+   * If a measurement for the occupancy log is due, returns the data that
+   * asks the decoder to measure the logged channels in the tuner's span.
+   * Measurements are kept on schedule, but after a pause, such as while
+   * the radio was scanning, the next one is taken right away and the
+   * missed ones are skipped.
+   * @return {?Object} The data for the decoder, or null.
+   */
+  function getOccupancyRequest() {
+    var now = Date.now();
+    if (!occupancyLog || now < nextOccupancyTime) {
+      return null;
+    }
+    var step = occupancyChannels.step;
+    nextOccupancyTime =
+        Math.max(nextOccupancyTime, now - occupancyChannels.interval) +
+        occupancyChannels.interval;
+    var halfSpan = (sampleRate * OCCUPANCY_SPAN - step) / 2;
+    var low = Math.max(0, Math.ceil(
+        (actualFrequency - halfSpan - occupancyChannels.first) / step));
+    var high = Math.min(occupancyChannels.count - 1, Math.floor(
+        (actualFrequency + halfSpan - occupancyChannels.first) / step));
+    if (low > high) {
+      occupancyLog.write(now, []);
+      return null;
+    }
+    var channelOffsets = [];
+    for (var i = low; i <= high; ++i) {
+      channelOffsets.push(
+          -getDecoderOffset(occupancyChannels.first + i * step));
+    }
+    return {
+      'measureChannels': [channelOffsets, step],
+      'occupancyTime': now,
+      'occupancyLog': occupancyLogId,
+      'occupancyChannel': low
+    };
+  }
+
+  /**
+   * Writes a measurement of the channels' power into the occupancy log.
+   * @param {Object} data The data sent by the decoder with the measurement.
+   */
+  function logOccupancy(data) {
+    if (!occupancyLog || data['occupancyLog'] != occupancyLogId) {
+      return;
+    }
+    var powers = new Float32Array(occupancyChannels.count);
+    for (var i = 0; i < powers.length; ++i) {
+      powers[i] = NaN;
+    }
+    powers.set(data['channelPowers'], data['occupancyChannel']);
+    occupancyLog.write(data['occupancyTime'], powers);
+  }
+
+  /**
+   * Gives a block of samples from the tuner to the capture file and to the
+   * network clients, if there are any. This must happen before the block
+   * is transferred to the demodulator.
+   * @param {ArrayBuffer} data The block of samples.
+   */
+  function shareBlock(data) {
+    if (iqWriter) {
+      iqWriter.writeBlock(data, actualFrequency, autoGain ? null : gain);
+    }
+    if (server) {
+      server.send(data);
+    }
+  }
+
+  /**
+   * Starts recording the downsampled I/Q signal into the given file entry.
+   * The samples are taken after the frequency shift and the first
+   * downsampling stage, so they are centered on the tuned frequency.
+   * @param {FileEntry} fileEntry The entry for the new WAV file.
+   */
+  function startBasebandRecording(fileEntry) {
+    stopBasebandRecording();
+    basebandEntry = fileEntry;
+    requestBaseband();
+    ui && ui.update();
+  }
+
+  /**
+   * Stops recording the downsampled I/Q signal.
+   */
+  function stopBasebandRecording() {
+    basebandEntry = null;
+    requestBaseband();
+    if (basebandSaver) {
+      basebandSaver.finish();
+      basebandSaver = null;
+    }
+    ui && ui.update();
+  }
+
+  /**
+   * Tells whether the radio is currently recording the I/Q signal.
+   */
+  function isRecordingBaseband() {
+    return basebandEntry != null;
+  }
+
+  /**
+   * Saves a block of downsampled I/Q samples. The file is created when the
+   * first block arrives, because its sample rate depends on the mode.
+   * If the sample rate or the frequency change afterwards, it stops
+   * recording, since the file can only describe one of each.
+   * @param {Int16Array} samples The interleaved I/Q samples.
+   * @param {number} rate The samples' sample rate.
+   */
+  function saveBaseband(samples, rate) {
+    if (!basebandEntry) {
+      return;
+    }
+    if (!basebandSaver) {
+      basebandRate = rate;
+      basebandFrequency = frequency;
+      basebandSaver = new WavSaver(basebandEntry, rate, frequency);
+    } else if (basebandRate != rate || basebandFrequency != frequency) {
+      stopBasebandRecording();
+      return;
+    }
+    basebandSaver.writeInterleaved(samples);
+  }
+
+  /**
+   * Tells the demodulator whether to send the downsampled I/Q signal,
+   * which is needed to record it or to keep it in the time shift buffer.
+   */
+  function requestBaseband() {
+    decoder.postMessage([2, basebandEntry != null || iqTimeShift != null]);
+  }
+
+  /**
+   * Sets how much of the radio's output to keep, so it can be played again
+   * or saved later. The setting takes effect the next time the radio is
+   * started.
+   * @param {number} seconds The number of seconds of audio to keep.
+   * @param {number} iqBytes The amount of memory for the downsampled I/Q
+   *     signal, in bytes. 0 not to keep it.
+   */
+  function setTimeShiftLength(seconds, iqBytes) {
+    timeShiftSeconds = seconds;
+    iqTimeShiftBytes = iqBytes;
+  }
+
+  /**
+   * Creates the time shift buffers, unless they already exist with the
+   * right size, so no memory is allocated while playing.
+   */
+  function allocateTimeShift() {
+    if (!timeShift || timeShift.getCapacity() != timeShiftSeconds) {
+      timeShift = timeShiftSeconds > 0
+          ? new TimeShiftBuffer(timeShiftSeconds) : null;
+      player.setTimeShift(timeShift);
+    }
+    if (iqTimeShiftBytes != (iqTimeShift ? iqTimeShift.getSize() : 0)) {
+      iqTimeShift = iqTimeShiftBytes > 0
+          ? new IqTimeShiftBuffer(iqTimeShiftBytes) : null;
+    }
+    requestBaseband();
+  }
+
+  /**
+   * Plays again the last few seconds of audio, and then goes back to
+   * playing the live audio.
+   * @param {number} seconds The number of seconds to play again.
+   */
+  function replay(seconds) {
+    player.replay(seconds);
+    ui && ui.update();
+  }
+
+  /**
+   * Stops playing again old audio and goes back to the live audio.
+   */
+  function stopReplay() {
+    player.stopReplay();
+    ui && ui.update();
+  }
+
+  /**
+   * Tells whether old audio is being played again.
+   */
+  function isReplaying() {
+    return player.isReplaying();
+  }
+
+  /**
+   * Saves the last few seconds of audio into a WAV file.
+   * @param {FileEntry} fileEntry The entry for the new WAV file.
+   * @param {number} seconds The number of seconds to save.
+   */
+  function saveTimeShift(fileEntry, seconds) {
+    if (timeShift) {
+      timeShift.save(fileEntry, seconds);
+    }
+  }
+
+  /**
+   * Saves the last few seconds of the downsampled I/Q signal into a
+   * WAV file.
+   * @param {FileEntry} fileEntry The entry for the new WAV file.
+   * @param {number} seconds The number of seconds to save.
+   */
+  function saveIqTimeShift(fileEntry, seconds) {
+    if (iqTimeShift && iqTimeShift.hasSamples()) {
+      iqTimeShift.save(fileEntry, seconds);
+    }
+  }
+
+  /**
+   * Tells whether the downsampled I/Q signal is being kept.
+   */
+  function hasIqTimeShift() {
+    return iqTimeShift != null && iqTimeShift.hasSamples();
+  }
+
   /**
    * Constructs a state object.
    * @param {number} state The state.
@@ -665,12 +1879,18 @@ function RadioController() {
     setSquelch: setSquelch,
     getSquelch: getSquelch,
     scan: scan,
+    scanPresets: scanPresets,
     isScanning: isScanning,
     isPlaying: isPlaying,
     isStopping: isStopping,
     isStereo: isStereo,
     enableStereo: enableStereo,
     isStereoEnabled: isStereoEnabled,
+    enableRds: enableRds,
+    isRdsEnabled: isRdsEnabled,
+    getRds: getRds,
+    enableDecoder: enableDecoder,
+    isDecoderEnabled: isDecoderEnabled,
     setVolume: setVolume,
     getVolume: getVolume,
     setCorrectionPpm: setCorrectionPpm,
@@ -685,6 +1905,39 @@ function RadioController() {
     startRecording: startRecording,
     stopRecording: stopRecording,
     isRecording: isRecording,
+    startCapture: startCapture,
+    stopCapture: stopCapture,
+    isCapturing: isCapturing,
+    startOccupancyLog: startOccupancyLog,
+    stopOccupancyLog: stopOccupancyLog,
+    isLoggingOccupancy: isLoggingOccupancy,
+    getOccupancyChannels: getOccupancyChannels,
+    startBasebandRecording: startBasebandRecording,
+    stopBasebandRecording: stopBasebandRecording,
+    isRecordingBaseband: isRecordingBaseband,
+    setTunerFactory: setTunerFactory,
+    setOffsetTuning: setOffsetTuning,
+    isOffsetTuning: isOffsetTuning,
+    getSampleRate: getSampleRate,
+    setDriftTracking: setDriftTracking,
+    isDriftTracking: isDriftTracking,
+    getDrift: getDrift,
+    getDriftHistory: getDriftHistory,
+    getTunerStats: getTunerStats,
+    setMuted: setMuted,
+    getStats: getStats,
+    getMessages: getMessages,
+    getImage: getImage,
+    clearImage: clearImage,
+    setSharingPort: setSharingPort,
+    getSharingClients: getSharingClients,
+    setTimeShiftLength: setTimeShiftLength,
+    replay: replay,
+    stopReplay: stopReplay,
+    isReplaying: isReplaying,
+    saveTimeShift: saveTimeShift,
+    saveIqTimeShift: saveIqTimeShift,
+    hasIqTimeShift: hasIqTimeShift,
     setInterface: setInterface,
     setOnError: setOnError
   };
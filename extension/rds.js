@@ -0,0 +1,430 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A decoder for the Radio Data System signal that broadcast
+ * FM stations send on a 57 kHz subcarrier.
+ */
+
+/**
+ * A class to decode the RDS signal in a demodulated broadcast FM signal.
+ * It finds the station's program identification code (PI), its name (PS),
+ * its radio text (RT) and its list of alternative frequencies (AF).
+ *
+ * The subcarrier is mixed down to baseband and decimated to about 8
+ * samples per bit with a triangular filter, which only needs a few
+ * operations for each input sample; everything else runs at the low rate.
+ * A Costas loop recovers the carrier, a Gardner detector the timing of the
+ * biphase symbols, and the bits are then decoded differentially and
+ * grouped into blocks, which are checked with their checkwords.
+ * @param {number} sampleRate The sample rate of the demodulated FM signal.
+ * @constructor
+ */
+function RdsDecoder(sampleRate) {
+  var SUBCARRIER_FREQ = 57000;
+  var CHIP_RATE = 2375;
+  var DECIMATION = Math.floor(sampleRate / (CHIP_RATE * 4));
+  var LOW_RATE = sampleRate / DECIMATION;
+  var CHIP_STEP = CHIP_RATE / LOW_RATE;
+  var COSTAS_ALPHA = 0.02;
+  var COSTAS_BETA = COSTAS_ALPHA * COSTAS_ALPHA / 4;
+  var TIMING_GAIN = 0.01;
+  var PAIRING_WEIGHT = 0.99;
+  var CHECKWORD_POLY = 0x1b9;
+  var OFFSETS = [0x0fc, 0x198, 0x168, 0x350, 0x1b4];
+  // The position in the group of each offset word's block: A, B, C, C', D.
+  var POSITIONS = [0, 1, 2, 2, 3];
+  var MAX_BAD_BLOCKS = 20;
+
+  var riseWeights = new Float32Array(DECIMATION);
+  var fallWeights = new Float32Array(DECIMATION);
+  for (var i = 0; i < DECIMATION; ++i) {
+    riseWeights[i] = (i + 1) / (DECIMATION * DECIMATION);
+    fallWeights[i] = (DECIMATION - i) / (DECIMATION * DECIMATION);
+  }
+  var lowPass = new FIRFilter(getLowPassFIRCoeffs(LOW_RATE, 2400, 15));
+  var mixCos = 1;
+  var mixSin = 0;
+  var mixStepCos = Math.cos(2 * Math.PI * SUBCARRIER_FREQ / sampleRate);
+  var mixStepSin = Math.sin(2 * Math.PI * SUBCARRIER_FREQ / sampleRate);
+  var decimPos = 0;
+  var curI = 0;
+  var curQ = 0;
+  var nextI = 0;
+  var nextQ = 0;
+
+  var carrierCos = 1;
+  var carrierSin = 0;
+  var carrierFreq = 0;
+  var power = new ExpAverage(LOW_RATE / 10);
+  var clock = 0;
+  var lastSample = 0;
+  var midChip = 0;
+  var lastChip = 0;
+  var chipParity = 0;
+  var pairing = [0, 0];
+  var lastBit = 0;
+
+  var register = 0;
+  var synced = false;
+  var blockPos = 0;
+  var bitCount = 0;
+  var badBlocks = 0;
+  var group = [0, 0, 0, 0];
+  var groupValid = [false, false, false, false];
+
+  var pi = null;
+  var lastPi = null;
+  var ps = [];
+  var rt = [];
+  var rtFlag = -1;
+  var af = [];
+  clearText();
+
+  /**
+   * Decodes the RDS signal in a block of the demodulated FM signal.
+   * @param {Float32Array} samples The demodulated FM signal.
+   */
+  function process(samples) {
+    var low = downconvert(samples);
+    lowPass.loadSamples(low[0]);
+    var filteredI = new Float32Array(low[0].length);
+    for (var i = 0; i < filteredI.length; ++i) {
+      filteredI[i] = lowPass.get(i);
+    }
+    lowPass.loadSamples(low[1]);
+    for (var i = 0; i < filteredI.length; ++i) {
+      receiveSample(filteredI[i], lowPass.get(i));
+    }
+    var carrier = normalizeOscillator(carrierCos, carrierSin);
+    carrierCos = carrier[0];
+    carrierSin = carrier[1];
+  }
+
+  /**
+   * Mixes the subcarrier down to baseband and decimates it with a
+   * triangular filter, two decimation periods long.
+   * @param {Float32Array} samples The demodulated FM signal.
+   * @return {Array.<Float32Array>} The I and Q components at the low rate.
+   */
+  function downconvert(samples) {
+    var count = Math.floor((decimPos + samples.length) / DECIMATION);
+    var outI = new Float32Array(count);
+    var outQ = new Float32Array(count);
+    var out = 0;
+    var c = mixCos;
+    var s = mixSin;
+    var pos = decimPos;
+    var cI = curI;
+    var cQ = curQ;
+    var nI = nextI;
+    var nQ = nextQ;
+    for (var i = 0; i < samples.length; ++i) {
+      var vI = samples[i] * c;
+      var vQ = -samples[i] * s;
+      var fall = fallWeights[pos];
+      var rise = riseWeights[pos];
+      cI += vI * fall;
+      cQ += vQ * fall;
+      nI += vI * rise;
+      nQ += vQ * rise;
+      var newC = c * mixStepCos - s * mixStepSin;
+      s = c * mixStepSin + s * mixStepCos;
+      c = newC;
+      if (++pos == DECIMATION) {
+        outI[out] = cI;
+        outQ[out] = cQ;
+        ++out;
+        cI = nI;
+        cQ = nQ;
+        nI = 0;
+        nQ = 0;
+        pos = 0;
+      }
+    }
+    decimPos = pos;
+    curI = cI;
+    curQ = cQ;
+    nextI = nI;
+    nextQ = nQ;
+    var osc = normalizeOscillator(c, s);
+    mixCos = osc[0];
+    mixSin = osc[1];
+    return [outI, outQ];
+  }
+
+  /**
+   * Recovers the carrier's phase for a sample at the low rate, and looks
+   * for the biphase chips in the resulting signal.
+   * @param {number} sampleI The I component of the sample.
+   * @param {number} sampleQ The Q component of the sample.
+   */
+  function receiveSample(sampleI, sampleQ) {
+    var c = carrierCos;
+    var s = carrierSin;
+    var vI = sampleI * c + sampleQ * s;
+    var vQ = sampleQ * c - sampleI * s;
+    var pwr = power.add(vI * vI + vQ * vQ);
+    if (pwr > 0) {
+      var error = Math.max(-1, Math.min(1, vI * vQ / pwr));
+      carrierFreq += COSTAS_BETA * error;
+      // The phase steps are small enough to rotate the carrier's phasor
+      // by them without computing their sines and cosines.
+      var step = carrierFreq + COSTAS_ALPHA * error;
+      carrierCos = c - s * step;
+      carrierSin = s + c * step;
+    }
+
+    var newClock = clock + CHIP_STEP;
+    if (clock < 0.5 && newClock >= 0.5) {
+      midChip = lastSample + (vI - lastSample) * (0.5 - clock) / CHIP_STEP;
+    }
+    if (newClock >= 1) {
+      var chip = lastSample + (vI - lastSample) * (1 - clock) / CHIP_STEP;
+      newClock -= 1;
+      if (pwr > 0) {
+        var timing = (chip - lastChip) * midChip / pwr;
+        newClock += TIMING_GAIN * Math.max(-1, Math.min(1, timing));
+      }
+      receiveChip(chip);
+    }
+    clock = newClock;
+    lastSample = vI;
+  }
+
+  /**
+   * Pairs up biphase chips into bits. In the right pairing, both chips of
+   * every pair have opposite signs, so the pairing with the largest
+   * differences is used.
+   * @param {number} chip The value of the chip.
+   */
+  function receiveChip(chip) {
+    var diff = chip - lastChip;
+    chipParity = 1 - chipParity;
+    pairing[chipParity] = pairing[chipParity] * PAIRING_WEIGHT +
+                          Math.abs(diff);
+    if (pairing[chipParity] > pairing[1 - chipParity]) {
+      var bit = diff > 0 ? 1 : 0;
+      receiveBit(bit ^ lastBit);
+      lastBit = bit;
+    }
+    lastChip = chip;
+  }
+
+  /**
+   * Finds the blocks in the bit stream.
+   * @param {number} bit The differentially decoded bit.
+   */
+  function receiveBit(bit) {
+    register = ((register << 1) | bit) & 0x3ffffff;
+    if (!synced) {
+      var type = getBlockType(register);
+      if (type >= 0) {
+        // A random bit pattern looks like a block every 200 bits or so,
+        // so the sync is dropped unless the next block is right too, and
+        // this block is not used.
+        synced = true;
+        blockPos = POSITIONS[type];
+        bitCount = 0;
+        badBlocks = MAX_BAD_BLOCKS - 1;
+        groupValid = [false, false, false, false];
+      }
+      return;
+    }
+    if (++bitCount < 26) {
+      return;
+    }
+    bitCount = 0;
+    blockPos = (blockPos + 1) % 4;
+    var type = getBlockType(register);
+    var valid = type >= 0 && POSITIONS[type] == blockPos;
+    if (valid) {
+      badBlocks = 0;
+    } else if (++badBlocks >= MAX_BAD_BLOCKS) {
+      synced = false;
+      return;
+    }
+    receiveBlock(register, valid);
+  }
+
+  /**
+   * Returns the type of a block, given by the offset word added to its
+   * checkword.
+   * @param {number} block The block, with its data and checkword.
+   * @return {number} The block type, or -1 if the checkword is wrong.
+   */
+  function getBlockType(block) {
+    var offset = getCheckword(block >> 10) ^ (block & 0x3ff);
+    return OFFSETS.indexOf(offset);
+  }
+
+  /**
+   * Computes a block's checkword, without the offset word.
+   * @param {number} data The block's data.
+   * @return {number} The checkword.
+   */
+  function getCheckword(data) {
+    var reg = 0;
+    for (var i = 15; i >= 0; --i) {
+      var feedback = ((data >> i) ^ (reg >> 9)) & 1;
+      reg = (reg << 1) & 0x3ff;
+      if (feedback) {
+        reg ^= CHECKWORD_POLY;
+      }
+    }
+    return reg;
+  }
+
+  /**
+   * Collects the blocks of a group.
+   * @param {number} block The block, with its data and checkword.
+   * @param {boolean} valid Whether the block's checkword is right.
+   */
+  function receiveBlock(block, valid) {
+    group[blockPos] = block >> 10;
+    groupValid[blockPos] = valid;
+    if (blockPos == 3) {
+      decodeGroup();
+      groupValid = [false, false, false, false];
+    }
+  }
+
+  /**
+   * Decodes the station information in a group.
+   */
+  function decodeGroup() {
+    if (groupValid[0]) {
+      setPi(group[0]);
+    }
+    if (pi == null || !groupValid[1]) {
+      return;
+    }
+    var b = group[1];
+    var type = b >> 12;
+    var versionB = (b >> 11) & 1;
+    if (type == 0) {
+      var addr = b & 3;
+      if (groupValid[3]) {
+        ps[addr * 2] = getChar(group[3] >> 8);
+        ps[addr * 2 + 1] = getChar(group[3] & 0xff);
+      }
+      if (!versionB && groupValid[2]) {
+        addAf(group[2] >> 8);
+        addAf(group[2] & 0xff);
+      }
+    } else if (type == 2) {
+      var addr = b & 15;
+      var flag = (b >> 4) & 1;
+      if (flag != rtFlag) {
+        rtFlag = flag;
+        rt = [];
+        for (var i = 0; i < 64; ++i) {
+          rt.push(' ');
+        }
+      }
+      if (versionB) {
+        if (groupValid[3]) {
+          rt[addr * 2] = getChar(group[3] >> 8);
+          rt[addr * 2 + 1] = getChar(group[3] & 0xff);
+        }
+      } else {
+        if (groupValid[2]) {
+          rt[addr * 4] = getChar(group[2] >> 8);
+          rt[addr * 4 + 1] = getChar(group[2] & 0xff);
+        }
+        if (groupValid[3]) {
+          rt[addr * 4 + 2] = getChar(group[3] >> 8);
+          rt[addr * 4 + 3] = getChar(group[3] & 0xff);
+        }
+      }
+    }
+  }
+
+  /**
+   * Sets the station's PI code. If it changes, it's a different station,
+   * so its information is forgotten. A code is only believed when two
+   * groups in a row have it, since noise can pass the checkword.
+   * @param {number} code The PI code.
+   */
+  function setPi(code) {
+    var confirmed = code == lastPi;
+    lastPi = code;
+    if (confirmed && code != pi) {
+      pi = code;
+      clearText();
+    }
+  }
+
+  /**
+   * Adds an alternative frequency from its code.
+   * @param {number} code The code. 1 to 204 are frequencies from 87.6 to
+   *     107.9 MHz; the rest are fillers or tell how many frequencies follow.
+   */
+  function addAf(code) {
+    if (code < 1 || code > 204) {
+      return;
+    }
+    var freq = 87500000 + code * 100000;
+    if (af.indexOf(freq) < 0) {
+      af.push(freq);
+      af.sort(function(a, b) { return a - b; });
+    }
+  }
+
+  /**
+   * Returns the character for a code of the RDS character set. Only the
+   * ASCII characters are supported.
+   * @param {number} code The character code.
+   * @return {string} The character.
+   */
+  function getChar(code) {
+    if (code == 0x0d) {
+      return '\r';
+    }
+    return code >= 0x20 && code < 0x7f ? String.fromCharCode(code) : ' ';
+  }
+
+  /**
+   * Forgets the station's name, radio text and alternative frequencies.
+   */
+  function clearText() {
+    ps = [' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '];
+    rt = [];
+    rtFlag = -1;
+    af = [];
+  }
+
+  /**
+   * Returns the information decoded so far.
+   * @return {?{pi:number,ps:string,rt:string,af:Array.<number>}} The
+   *     station's PI code, name, radio text, and alternative frequencies
+   *     in Hz, or null if no group has been decoded yet.
+   */
+  function getInfo() {
+    if (pi == null) {
+      return null;
+    }
+    return {
+      pi: pi,
+      ps: ps.join(''),
+      rt: rt.join('').split('\r')[0].replace(/\s+$/, ''),
+      af: af.slice()
+    };
+  }
+
+  return {
+    process: process,
+    getInfo: getInfo
+  };
+}
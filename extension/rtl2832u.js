@@ -27,7 +27,7 @@ function RTL2832U(conn, ppm, opt_gain) {
   var XTAL_FREQ = 28800000;
 
   /**
-   * Tuner intermediate frequency.
+   * Tuner intermediate frequency after initialization.
    */
   var IF_FREQ = 3570000;
 
@@ -51,6 +51,17 @@ function RTL2832U(conn, ppm, opt_gain) {
    */
   var tuner;
 
+  /**
+   * The tuner's current intermediate frequency, which depends on the
+   * bandwidth of its IF filters.
+   */
+  var ifFreq = IF_FREQ;
+
+  /**
+   * The frequency of the oscillator crystal, corrected by the PPM.
+   */
+  var xtalFreq = Math.floor(XTAL_FREQ * (1 + ppm / 1000000));
+
   /**
    * Initialize the demodulator.
    * @param {Function} kont The continuation for this function.
@@ -106,7 +117,6 @@ function RTL2832U(conn, ppm, opt_gain) {
       [CMD.DEMODREG, 0, 0x0d, 0x83, 1]
     ], function() {
 
-    var xtalFreq = Math.floor(XTAL_FREQ * (1 + ppm / 1000000));
     com.i2c.open(function() {
     R820T.check(com, function(found) {
     if (found) {
@@ -117,28 +127,55 @@ function RTL2832U(conn, ppm, opt_gain) {
                  'Only the R820T chip is supported.');
       return;
     }
-    var multiplier = -1 * Math.floor(IF_FREQ * (1<<22) / xtalFreq);
+    ifFreq = IF_FREQ;
     com.writeEach([
       [CMD.DEMODREG, 1, 0xb1, 0x1a, 1],
-      [CMD.DEMODREG, 0, 0x08, 0x4d, 1],
-      [CMD.DEMODREG, 1, 0x19, (multiplier >> 16) & 0x3f, 1],
-      [CMD.DEMODREG, 1, 0x1a, (multiplier >> 8) & 0xff, 1],
-      [CMD.DEMODREG, 1, 0x1b, multiplier & 0xff, 1],
+      [CMD.DEMODREG, 0, 0x08, 0x4d, 1]
+    ], function() {
+    setIfFrequency(function() {
+    com.writeEach([
       [CMD.DEMODREG, 1, 0x15, 0x01, 1]
     ], function() {
     tuner.init(function() {
-    setGain(opt_gain, function() {
+    setTunerGain(opt_gain, function() {
     com.i2c.close(kont);
-    })})})})})})})});
+    })})})})})})})})})});
+  }
+
+  /**
+   * Tells the demodulator the tuner's intermediate frequency, so it shifts
+   * the signal down to baseband.
+   * @param {Function} kont The continuation for this function.
+   */
+  function setIfFrequency(kont) {
+    var multiplier = -1 * Math.floor(ifFreq * (1<<22) / xtalFreq);
+    com.writeEach([
+      [CMD.DEMODREG, 1, 0x19, (multiplier >> 16) & 0x3f, 1],
+      [CMD.DEMODREG, 1, 0x1a, (multiplier >> 8) & 0xff, 1],
+      [CMD.DEMODREG, 1, 0x1b, multiplier & 0xff, 1]
+    ], kont);
   }
 
   /**
-   * Sets the requested gain.
+   * Changes the tuner's gain.
    * @param {number|null|undefined} gain The gain in dB, or null/undefined
    *     for automatic gain.
    * @param {Function} kont The continuation for this function.
    */
   function setGain(gain, kont) {
+    com.i2c.open(function() {
+    setTunerGain(gain, function() {
+    com.i2c.close(kont);
+    })});
+  }
+
+  /**
+   * Sets the requested gain. The I2C repeater must be open.
+   * @param {number|null|undefined} gain The gain in dB, or null/undefined
+   *     for automatic gain.
+   * @param {Function} kont The continuation for this function.
+   */
+  function setTunerGain(gain, kont) {
     if (gain == null) {
       tuner.setAutoGain(kont);
     } else {
@@ -147,7 +184,9 @@ function RTL2832U(conn, ppm, opt_gain) {
   }
 
   /**
-   * Set the sample rate.
+   * Set the sample rate. The tuner's IF filters are narrowed to just over
+   * the sample rate, which moves the intermediate frequency, so the tuner
+   * must be tuned again afterwards.
    * @param {number} rate The sample rate, in samples/sec.
    * @param {Function} kont The continuation for this function. Receives the
    *     sample rate that was actually set as its first parameter.
@@ -163,9 +202,14 @@ function RTL2832U(conn, ppm, opt_gain) {
       [CMD.DEMODREG, 1, 0x3e, (ppmOffset >> 8) & 0x3f, 1],
       [CMD.DEMODREG, 1, 0x3f, ppmOffset & 0xff, 1]
     ], function() {
+    com.i2c.open(function() {
+    tuner.setBandwidth(realRate, function(newIfFreq) {
+    ifFreq = newIfFreq;
+    com.i2c.close(function() {
+    setIfFrequency(function() {
     resetDemodulator(function() {
     kont(realRate);
-    })});
+    })})})})})});
   }
 
   /**
@@ -187,9 +231,9 @@ function RTL2832U(conn, ppm, opt_gain) {
    */
   function setCenterFrequency(freq, kont) {
     com.i2c.open(function() {
-    tuner.setFrequency(freq + IF_FREQ, function(actualFreq) {
+    tuner.setFrequency(freq + ifFreq, function(actualFreq) {
     com.i2c.close(function() {
-    kont(actualFreq - IF_FREQ);
+    kont(actualFreq - ifFreq);
     })})});
   }
 
@@ -254,6 +298,7 @@ function RTL2832U(conn, ppm, opt_gain) {
     open: open,
     setSampleRate: setSampleRate,
     setCenterFrequency: setCenterFrequency,
+    setGain: setGain,
     resetBuffer: resetBuffer,
     readSamples: readSamples,
     close: close,
@@ -0,0 +1,348 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * Commands understood by an rtl_tcp server. Each command is sent as a byte
+ * with the command code followed by a big-endian 32-bit parameter.
+ */
+var RTL_TCP_CMD = {
+  FREQUENCY: 0x01,
+  SAMPLE_RATE: 0x02,
+  GAIN_MODE: 0x03,
+  GAIN: 0x04,
+  FREQ_CORRECTION: 0x05
+};
+
+/**
+ * A tuner that receives its samples from an rtl_tcp server over the
+ * network. It has the same methods as RTL2832U.
+ *
+ * The samples are received into a ring buffer big enough to hold a couple
+ * of seconds of signal, so that network jitter doesn't starve the
+ * decoder. When the buffer doesn't have enough samples for a read, the
+ * read waits for them and is counted as an underrun; when the buffer fills
+ * up, the oldest samples are discarded and counted as an overflow.
+ * @param {string} host The server's host name or address.
+ * @param {number} port The server's TCP port.
+ * @param {number} ppm The frequency correction factor, in parts per million.
+ * @param {number=} opt_gain The optional gain in dB. If unspecified or null,
+ *     sets auto gain.
+ * @constructor
+ */
+function RtlTcpClient(host, port, ppm, opt_gain) {
+
+  /**
+   * The number of bytes for each sample.
+   */
+  var BYTES_PER_SAMPLE = 2;
+
+  /**
+   * The size of the greeting the server sends when a client connects.
+   */
+  var HEADER_SIZE = 12;
+
+  /**
+   * The number of seconds of signal the receive buffer can hold.
+   */
+  var BUFFER_SECONDS = 2;
+
+  /**
+   * The size of the socket's own receive buffer.
+   */
+  var SOCKET_BUFFER_SIZE = 262144;
+
+  var socketId = null;
+  var header = new Uint8Array(HEADER_SIZE);
+  var headerLength = 0;
+  var ring = new Uint8Array(0);
+  var ringStart = 0;
+  var ringFill = 0;
+  var pendingReads = [];
+  var underruns = 0;
+  var overflows = 0;
+  var firstRead = true;
+  var errorHandler;
+
+  /**
+   * Connects to the server and sets up the tuner's gain and frequency
+   * correction.
+   * @param {Function} kont The continuation for this function.
+   */
+  function open(kont) {
+    chrome.sockets.tcp.create({'bufferSize': SOCKET_BUFFER_SIZE},
+        function(info) {
+    socketId = info.socketId;
+    chrome.sockets.tcp.onReceive.addListener(onReceive);
+    chrome.sockets.tcp.onReceiveError.addListener(onReceiveError);
+    chrome.sockets.tcp.connect(socketId, host, port, function(result) {
+    if (chrome.runtime.lastError || result < 0) {
+      throwError('Could not connect to the rtl_tcp server at ' +
+                 host + ':' + port + '.');
+      return;
+    }
+    sendCommand(RTL_TCP_CMD.FREQ_CORRECTION, ppm, function() {
+    setGain(opt_gain, kont);
+    })})});
+  }
+
+  /**
+   * Sets the tuner's gain.
+   * @param {?number} gain The gain in dB, or null for automatic gain.
+   * @param {Function} kont The continuation for this function.
+   */
+  function setGain(gain, kont) {
+    if (gain == null) {
+      sendCommand(RTL_TCP_CMD.GAIN_MODE, 0, kont);
+    } else {
+      sendCommand(RTL_TCP_CMD.GAIN_MODE, 1, function() {
+      sendCommand(RTL_TCP_CMD.GAIN, Math.round(gain * 10), kont);
+      });
+    }
+  }
+
+  /**
+   * Sets the sample rate, and resizes the receive buffer to match it.
+   * @param {number} rate The sample rate, in samples per second.
+   * @param {Function} kont The continuation for this function. Receives the
+   *     sample rate that was set as its first parameter.
+   */
+  function setSampleRate(rate, kont) {
+    var size = BUFFER_SECONDS * rate * BYTES_PER_SAMPLE;
+    if (ring.length != size) {
+      ring = new Uint8Array(size);
+      ringStart = 0;
+      ringFill = 0;
+    }
+    sendCommand(RTL_TCP_CMD.SAMPLE_RATE, rate, function() {
+    kont(rate);
+    });
+  }
+
+  /**
+   * Tunes the device to the given frequency.
+   * @param {number} freq The frequency to tune to, in Hertz.
+   * @param {Function} kont The continuation for this function, which
+   *     receives the tuned frequency.
+   */
+  function setCenterFrequency(freq, kont) {
+    sendCommand(RTL_TCP_CMD.FREQUENCY, freq, function() {
+    kont(freq);
+    });
+  }
+
+  /**
+   * Discards the received samples. Call this before starting to read
+   * samples.
+   * @param {Function} kont The continuation for this function.
+   */
+  function resetBuffer(kont) {
+    ringStart = 0;
+    ringFill = 0;
+    firstRead = true;
+    kont();
+  }
+
+  /**
+   * Reads a block of samples off the receive buffer. If there aren't
+   * enough samples, waits until they arrive.
+   * @param {number} length The number of samples to read.
+   * @param {Function} kont The continuation for this function. It will
+   *     receive as its argument an ArrayBuffer containing the read samples,
+   *     which you can interpret as pairs of unsigned 8-bit integers; the
+   *     first one is the sample's I value, and the second one is its Q value.
+   */
+  function readSamples(length, kont) {
+    var bytes = length * BYTES_PER_SAMPLE;
+    if (bytes > ring.length) {
+      throwError('Cannot read more than ' + BUFFER_SECONDS +
+                 ' seconds of signal at once.');
+      return;
+    }
+    pendingReads.push({bytes: bytes, kont: kont});
+    var wanted = 0;
+    for (var i = 0; i < pendingReads.length; ++i) {
+      wanted += pendingReads[i].bytes;
+    }
+    if (wanted > ringFill && !firstRead) {
+      ++underruns;
+    }
+    firstRead = false;
+    setTimeout(serveReads, 0);
+  }
+
+  /**
+   * Completes the pending reads for which there are enough samples.
+   */
+  function serveReads() {
+    while (pendingReads.length > 0 && pendingReads[0].bytes <= ringFill) {
+      var read = pendingReads.shift();
+      var out = new Uint8Array(read.bytes);
+      var first = Math.min(read.bytes, ring.length - ringStart);
+      out.set(ring.subarray(ringStart, ringStart + first));
+      if (first < read.bytes) {
+        out.set(ring.subarray(0, read.bytes - first), first);
+      }
+      ringStart = (ringStart + read.bytes) % ring.length;
+      ringFill -= read.bytes;
+      read.kont(out.buffer);
+    }
+  }
+
+  /**
+   * Receives data from the server.
+   * @param {Object} info The received data and the socket it came from.
+   */
+  function onReceive(info) {
+    if (info.socketId != socketId) {
+      return;
+    }
+    var data = new Uint8Array(info.data);
+    if (headerLength < HEADER_SIZE) {
+      var headerPart = Math.min(data.length, HEADER_SIZE - headerLength);
+      header.set(data.subarray(0, headerPart), headerLength);
+      headerLength += headerPart;
+      data = data.subarray(headerPart);
+      if (headerLength == HEADER_SIZE && !checkHeader()) {
+        throwError('The server at ' + host + ':' + port +
+                   ' is not an rtl_tcp server.');
+        return;
+      }
+    }
+    if (ring.length == 0) {
+      return;
+    }
+    if (data.length > ring.length) {
+      data = data.subarray(data.length - ring.length);
+    }
+    var excess = ringFill + data.length - ring.length;
+    if (excess > 0) {
+      ++overflows;
+      ringStart = (ringStart + excess) % ring.length;
+      ringFill -= excess;
+    }
+    var end = (ringStart + ringFill) % ring.length;
+    var first = Math.min(data.length, ring.length - end);
+    ring.set(data.subarray(0, first), end);
+    if (first < data.length) {
+      ring.set(data.subarray(first), 0);
+    }
+    ringFill += data.length;
+    serveReads();
+  }
+
+  /**
+   * Checks that the greeting sent by the server starts with "RTL0".
+   * @return {boolean} Whether the greeting is correct.
+   */
+  function checkHeader() {
+    return header[0] == 0x52 && header[1] == 0x54 && header[2] == 0x4c &&
+           header[3] == 0x30;
+  }
+
+  /**
+   * Handles a network error.
+   * @param {Object} info The error code and the socket it came from.
+   */
+  function onReceiveError(info) {
+    if (info.socketId == socketId) {
+      throwError('The connection to the rtl_tcp server was lost ' +
+                 '(error ' + info.resultCode + ').');
+    }
+  }
+
+  /**
+   * Sends a command to the server.
+   * @param {number} cmd The command code.
+   * @param {number} param The command's parameter.
+   * @param {Function} kont The continuation for this function.
+   */
+  function sendCommand(cmd, param, kont) {
+    var buffer = new ArrayBuffer(5);
+    var view = new DataView(buffer);
+    view.setUint8(0, cmd);
+    view.setInt32(1, param, false);
+    chrome.sockets.tcp.send(socketId, buffer, function(info) {
+      if (chrome.runtime.lastError || info.resultCode < 0) {
+        throwError('Could not send a command to the rtl_tcp server.');
+        return;
+      }
+      kont();
+    });
+  }
+
+  /**
+   * Disconnects from the server.
+   * @param {Function} kont The continuation for this function.
+   */
+  function close(kont) {
+    chrome.sockets.tcp.onReceive.removeListener(onReceive);
+    chrome.sockets.tcp.onReceiveError.removeListener(onReceiveError);
+    pendingReads = [];
+    if (socketId == null) {
+      kont();
+      return;
+    }
+    var id = socketId;
+    socketId = null;
+    chrome.sockets.tcp.close(id, function() {
+      kont();
+    });
+  }
+
+  /**
+   * Returns the receive buffer's statistics.
+   * @return {Object} The number of underruns and overflows, and the
+   *     number of seconds of signal in the buffer.
+   */
+  function getStats() {
+    return {
+      underruns: underruns,
+      overflows: overflows,
+      buffered: ring.length ? BUFFER_SECONDS * ringFill / ring.length : 0
+    };
+  }
+
+  /**
+   * Handles an error.
+   * @param {string} msg The error message.
+   */
+  function throwError(msg) {
+    if (errorHandler) {
+      errorHandler(msg);
+    } else {
+      throw msg;
+    }
+  }
+
+  /**
+   * Sets a function to call if there's an error communicating with the
+   * server.
+   * @param {Function} func The function to call on error.
+   */
+  function setOnError(func) {
+    errorHandler = func;
+  }
+
+  return {
+    open: open,
+    setSampleRate: setSampleRate,
+    setCenterFrequency: setCenterFrequency,
+    setGain: setGain,
+    resetBuffer: resetBuffer,
+    readSamples: readSamples,
+    close: close,
+    getStats: getStats,
+    setOnError: setOnError
+  };
+}
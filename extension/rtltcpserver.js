@@ -0,0 +1,275 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * A server that shares the tuner's samples with other programs on the
+ * network, using the rtl_tcp protocol.
+ *
+ * Every block of samples is handed to every client as the same buffer.
+ * Each client can have a few blocks waiting to be sent; if a client falls
+ * further behind, new blocks are dropped for that client, so a slow client
+ * never holds up the tuner or the other clients.
+ *
+ * The commands that the clients send are passed to the given handler,
+ * which is an object with these optional methods:
+ *     setFrequency(frequency): tunes the device to the given frequency.
+ *     setGain(gain): sets the gain in dB, or automatic gain if null.
+ * @param {number} port The TCP port to listen on.
+ * @param {Object} handler The handler for the clients' commands.
+ * @constructor
+ */
+function RtlTcpServer(port, handler) {
+
+  /**
+   * The maximum number of blocks waiting to be sent to each client.
+   */
+  var MAX_QUEUED_BLOCKS = 4;
+
+  /**
+   * The size of a command sent by a client.
+   */
+  var COMMAND_SIZE = 5;
+
+  /**
+   * The tuner type sent in the greeting (R820T).
+   */
+  var TUNER_TYPE = 5;
+
+  /**
+   * The number of gain steps sent in the greeting.
+   */
+  var GAIN_STEPS = 29;
+
+  var serverId = null;
+  var clients = {};
+  var manualGain = false;
+  var errorHandler;
+
+  /**
+   * Starts listening for connections.
+   * @param {Function} kont The continuation for this function.
+   */
+  function start(kont) {
+    chrome.sockets.tcpServer.create({}, function(info) {
+    serverId = info.socketId;
+    chrome.sockets.tcpServer.listen(serverId, '0.0.0.0', port,
+        function(result) {
+    if (chrome.runtime.lastError || result < 0) {
+      chrome.sockets.tcpServer.close(serverId);
+      serverId = null;
+      throwError('Could not share the tuner on port ' + port + '.');
+      return;
+    }
+    chrome.sockets.tcpServer.onAccept.addListener(onAccept);
+    chrome.sockets.tcp.onReceive.addListener(onReceive);
+    chrome.sockets.tcp.onReceiveError.addListener(onReceiveError);
+    kont();
+    })});
+  }
+
+  /**
+   * Accepts a new client and sends it the greeting.
+   * @param {Object} info The server and client sockets.
+   */
+  function onAccept(info) {
+    if (info.socketId != serverId) {
+      return;
+    }
+    var id = info.clientSocketId;
+    clients[id] = {
+      queued: 0,
+      dropped: 0,
+      command: new Uint8Array(COMMAND_SIZE),
+      commandLength: 0
+    };
+    var greeting = new DataView(new ArrayBuffer(12));
+    greeting.setUint32(0, 0x52544c30, false);  // "RTL0"
+    greeting.setUint32(4, TUNER_TYPE, false);
+    greeting.setUint32(8, GAIN_STEPS, false);
+    chrome.sockets.tcp.send(id, greeting.buffer, function() {
+      chrome.sockets.tcp.setPaused(id, false);
+    });
+  }
+
+  /**
+   * Sends a block of samples to all the clients. The block is not copied,
+   * so the caller must not modify it, but it may transfer it to a worker
+   * afterwards, since the sockets API takes its data when called.
+   * @param {ArrayBuffer} buffer The block of samples.
+   */
+  function send(buffer) {
+    for (var id in clients) {
+      sendTo(Number(id), buffer);
+    }
+  }
+
+  /**
+   * Sends a block of samples to a client, unless it has too many blocks
+   * waiting already.
+   * @param {number} id The client's socket.
+   * @param {ArrayBuffer} buffer The block of samples.
+   */
+  function sendTo(id, buffer) {
+    var client = clients[id];
+    if (client.queued >= MAX_QUEUED_BLOCKS) {
+      ++client.dropped;
+      return;
+    }
+    ++client.queued;
+    chrome.sockets.tcp.send(id, buffer, function(info) {
+      --client.queued;
+      if (chrome.runtime.lastError || info.resultCode < 0) {
+        disconnect(id);
+      }
+    });
+  }
+
+  /**
+   * Receives commands from a client.
+   * @param {Object} info The received data and the socket it came from.
+   */
+  function onReceive(info) {
+    var client = clients[info.socketId];
+    if (!client) {
+      return;
+    }
+    var data = new Uint8Array(info.data);
+    for (var i = 0; i < data.length; ++i) {
+      client.command[client.commandLength++] = data[i];
+      if (client.commandLength == COMMAND_SIZE) {
+        client.commandLength = 0;
+        var view = new DataView(client.command.buffer);
+        runCommand(view.getUint8(0), view.getInt32(1, false));
+      }
+    }
+  }
+
+  /**
+   * Runs a command sent by a client. The sample rate and frequency
+   * correction can't be changed while the radio is playing, so those
+   * commands are ignored.
+   * @param {number} cmd The command code.
+   * @param {number} param The command's parameter.
+   */
+  function runCommand(cmd, param) {
+    switch (cmd) {
+      case RTL_TCP_CMD.FREQUENCY:
+        handler.setFrequency && handler.setFrequency(param);
+        break;
+      case RTL_TCP_CMD.GAIN_MODE:
+        manualGain = param != 0;
+        if (!manualGain) {
+          handler.setGain && handler.setGain(null);
+        }
+        break;
+      case RTL_TCP_CMD.GAIN:
+        if (manualGain) {
+          handler.setGain && handler.setGain(param / 10);
+        }
+        break;
+    }
+  }
+
+  /**
+   * Disconnects a client after a network error.
+   * @param {Object} info The error code and the socket it came from.
+   */
+  function onReceiveError(info) {
+    if (clients[info.socketId]) {
+      disconnect(info.socketId);
+    }
+  }
+
+  /**
+   * Disconnects a client.
+   * @param {number} id The client's socket.
+   */
+  function disconnect(id) {
+    if (clients[id]) {
+      delete clients[id];
+      chrome.sockets.tcp.close(id);
+    }
+  }
+
+  /**
+   * Disconnects all the clients and stops listening for connections.
+   * @param {Function} kont The continuation for this function.
+   */
+  function stop(kont) {
+    chrome.sockets.tcpServer.onAccept.removeListener(onAccept);
+    chrome.sockets.tcp.onReceive.removeListener(onReceive);
+    chrome.sockets.tcp.onReceiveError.removeListener(onReceiveError);
+    for (var id in clients) {
+      disconnect(Number(id));
+    }
+    if (serverId == null) {
+      kont();
+      return;
+    }
+    var socket = serverId;
+    serverId = null;
+    chrome.sockets.tcpServer.close(socket, function() {
+      kont();
+    });
+  }
+
+  /**
+   * Returns the number of connected clients.
+   * @return {number} The number of clients.
+   */
+  function getClientCount() {
+    return Object.keys(clients).length;
+  }
+
+  /**
+   * Returns the number of blocks that were dropped for each client.
+   * @return {Array.<number>} The number of dropped blocks for each client.
+   */
+  function getDroppedBlocks() {
+    var dropped = [];
+    for (var id in clients) {
+      dropped.push(clients[id].dropped);
+    }
+    return dropped;
+  }
+
+  /**
+   * Handles an error.
+   * @param {string} msg The error message.
+   */
+  function throwError(msg) {
+    if (errorHandler) {
+      errorHandler(msg);
+    } else {
+      throw msg;
+    }
+  }
+
+  /**
+   * Sets a function to call if there's an error.
+   * @param {Function} func The function to call on error.
+   */
+  function setOnError(func) {
+    errorHandler = func;
+  }
+
+  return {
+    start: start,
+    stop: stop,
+    send: send,
+    getClientCount: getClientCount,
+    getDroppedBlocks: getDroppedBlocks,
+    setOnError: setOnError
+  };
+}
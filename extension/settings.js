@@ -31,6 +31,22 @@ upconverterFreq.value = (settings && settings['upconverterFreq']) || 125000000;
 upconverterFreqInput.className = useUpconverter.checked ? '' : 'invisible';
 upconverterFreq.disabled = !useUpconverter.checked;
 enableFreeTuning.checked = settings && settings['enableFreeTuning'];
+offsetTuning.checked = settings && settings['offsetTuning'];
+driftTracking.checked = settings && settings['driftTracking'];
+enableRds.checked = !settings || settings['rds'] !== false;
+decodeAprs.checked = settings && settings['aprs'];
+decodePocsag.checked = settings && settings['pocsag'];
+tunerSource.value = (settings && settings['tunerSource']) || 'usb';
+tunerAddress.value = (settings && settings['tunerAddress']) || 'localhost:1234';
+tunerAddress.disabled = tunerSource.value != 'rtltcp';
+simulatedStations.value = (settings && settings['simulatedStations']) || '';
+simulatedStationsInput.className =
+    tunerSource.value == 'simulator' ? '' : 'invisible';
+enableSharing.checked = settings && settings['enableSharing'];
+sharingPort.value = (settings && settings['sharingPort']) || 1234;
+sharingPort.disabled = !enableSharing.checked;
+timeShiftMinutes.value = settings ? settings['timeShiftMinutes'] : 5;
+iqTimeShiftMegabytes.value = (settings && settings['iqTimeShiftMegabytes']) || 0;
 
 function save() {
   var msg = {
@@ -42,7 +58,19 @@ function save() {
       'gain': gain.value,
       'useUpconverter': useUpconverter.checked,
       'upconverterFreq': upconverterFreq.value,
-      'enableFreeTuning': enableFreeTuning.checked
+      'enableFreeTuning': enableFreeTuning.checked,
+      'offsetTuning': offsetTuning.checked,
+      'driftTracking': driftTracking.checked,
+      'rds': enableRds.checked,
+      'aprs': decodeAprs.checked,
+      'pocsag': decodePocsag.checked,
+      'tunerSource': tunerSource.value,
+      'tunerAddress': tunerAddress.value,
+      'simulatedStations': simulatedStations.value,
+      'enableSharing': enableSharing.checked,
+      'sharingPort': sharingPort.value,
+      'timeShiftMinutes': timeShiftMinutes.value,
+      'iqTimeShiftMegabytes': iqTimeShiftMegabytes.value
     }
   };
   window['opener'].postMessage(msg, '*');
@@ -61,6 +89,14 @@ estimatePpmLink.addEventListener('click', function() {
 autoGain.addEventListener('change', function() {
   gain.disabled = autoGain.checked;
 });
+tunerSource.addEventListener('change', function() {
+  tunerAddress.disabled = tunerSource.value != 'rtltcp';
+  simulatedStationsInput.className =
+      tunerSource.value == 'simulator' ? '' : 'invisible';
+});
+enableSharing.addEventListener('change', function() {
+  sharingPort.disabled = !enableSharing.checked;
+});
 useUpconverter.addEventListener('change', function() {
   upconverterFreq.disabled = !useUpconverter.checked;
   upconverterFreqInput.className = useUpconverter.checked ? '' : 'invisible';
@@ -0,0 +1,288 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * A ring buffer that keeps the last few minutes of demodulated audio
+ * (48k, 16-bit, stereo), so that it can be played back again or saved
+ * into a WAV file after the fact.
+ *
+ * All the memory is allocated by the constructor. Positions are counted in
+ * samples since the buffer was created, so a position stays valid until the
+ * buffer has wrapped around past it.
+ * @param {number} seconds The number of seconds of audio to keep.
+ * @constructor
+ */
+function TimeShiftBuffer(seconds) {
+
+  var RATE = 48000;
+
+  var size = Math.max(1, Math.floor(seconds * RATE));
+  var samples = new Int16Array(size * 2);
+  var written = 0;
+
+  /**
+   * Adds a block of samples at the end of the buffer.
+   * @param {Float32Array} leftSamples The samples for the left speaker,
+   *     or null to add silence.
+   * @param {Float32Array} rightSamples The samples for the right speaker,
+   *     or null to add silence.
+   * @param {number} length The number of samples to add.
+   */
+  function write(leftSamples, rightSamples, length) {
+    var pos = (written % size) * 2;
+    for (var i = 0; i < length; ++i) {
+      if (leftSamples) {
+        samples[pos] =
+            Math.floor(Math.max(-1, Math.min(1, leftSamples[i])) * 32767);
+        samples[pos + 1] =
+            Math.floor(Math.max(-1, Math.min(1, rightSamples[i])) * 32767);
+      } else {
+        samples[pos] = 0;
+        samples[pos + 1] = 0;
+      }
+      pos += 2;
+      if (pos == samples.length) {
+        pos = 0;
+      }
+    }
+    written += length;
+  }
+
+  /**
+   * Reads a block of samples from the buffer. The samples that are no
+   * longer in the buffer are returned as silence.
+   * @param {number} position The position of the first sample to read.
+   * @param {Float32Array} leftSamples The array for the left speaker.
+   * @param {Float32Array} rightSamples The array for the right speaker.
+   * @param {number} length The number of samples to read.
+   */
+  function read(position, leftSamples, rightSamples, length) {
+    var start = getStart();
+    var pos = (position % size) * 2;
+    for (var i = 0; i < length; ++i) {
+      if (position + i < start || position + i >= written) {
+        leftSamples[i] = 0;
+        rightSamples[i] = 0;
+      } else {
+        leftSamples[i] = samples[pos] / 32768;
+        rightSamples[i] = samples[pos + 1] / 32768;
+      }
+      pos += 2;
+      if (pos == samples.length) {
+        pos = 0;
+      }
+    }
+  }
+
+  /**
+   * Returns the position of the oldest sample in the buffer.
+   * @return {number} The position of the oldest sample.
+   */
+  function getStart() {
+    return Math.max(0, written - size);
+  }
+
+  /**
+   * Returns the position after the newest sample in the buffer.
+   * @return {number} The position for the next sample to be added.
+   */
+  function getEnd() {
+    return written;
+  }
+
+  /**
+   * Returns the position of the sample that was added the given number of
+   * seconds ago, or of the oldest sample if it's no longer in the buffer.
+   * @param {number} seconds The number of seconds.
+   * @return {number} The sample's position.
+   */
+  function getPositionBefore(seconds) {
+    return Math.max(getStart(), written - Math.floor(seconds * RATE));
+  }
+
+  /**
+   * Returns the number of seconds of audio that the buffer can keep.
+   * @return {number} The buffer's capacity, in seconds.
+   */
+  function getCapacity() {
+    return size / RATE;
+  }
+
+  /**
+   * Saves the last samples in the buffer into a WAV file.
+   * @param {FileEntry} fileEntry The entry for the new WAV file.
+   * @param {number} seconds The number of seconds to save.
+   */
+  function save(fileEntry, seconds) {
+    var start = getPositionBefore(seconds);
+    var saver = new WavSaver(fileEntry);
+    var from = (start % size) * 2;
+    var to = (written % size) * 2;
+    if (from >= to && written > start) {
+      saver.writeInterleaved(samples.subarray(from));
+      from = 0;
+    }
+    saver.writeInterleaved(samples.subarray(from, to));
+    saver.finish();
+  }
+
+  return {
+    write: write,
+    read: read,
+    getStart: getStart,
+    getEnd: getEnd,
+    getPositionBefore: getPositionBefore,
+    getCapacity: getCapacity,
+    save: save
+  };
+}
+
+/**
+ * A ring buffer that keeps the last part of the downsampled I/Q signal,
+ * so that it can be saved into a WAV file after the fact.
+ *
+ * To fit more signal into the same memory, the samples are kept in 8 bits
+ * with a shared exponent for every group of 64 I/Q pairs. A group's
+ * exponent is the smallest shift that makes all its samples fit into
+ * 8 bits, so weak signals keep all their resolution.
+ *
+ * The buffer can only hold one sample rate and center frequency. When
+ * either of them change, it forgets its previous contents.
+ * @param {number} bytes The amount of memory to use.
+ * @constructor
+ */
+function IqTimeShiftBuffer(bytes) {
+
+  var GROUP = 64;
+
+  var groups = Math.max(1, Math.floor(bytes / (GROUP * 2 + 1)));
+  var size = groups * GROUP;
+  var samples = new Int8Array(size * 2);
+  var exponents = new Uint8Array(groups);
+  var pending = new Int16Array(GROUP * 2);
+  var pendingLength = 0;
+  var written = 0;
+  var rate = 0;
+  var frequency = 0;
+  var startTime = new Date();
+
+  /**
+   * Adds a block of interleaved I/Q samples at the end of the buffer.
+   * @param {Int16Array} iqSamples The samples, alternating I and Q.
+   * @param {number} sampleRate The samples' sample rate.
+   * @param {number} centerFrequency The samples' center frequency.
+   */
+  function write(iqSamples, sampleRate, centerFrequency) {
+    if (sampleRate != rate || centerFrequency != frequency) {
+      rate = sampleRate;
+      frequency = centerFrequency;
+      written = 0;
+      pendingLength = 0;
+      startTime = new Date();
+    }
+    for (var i = 0; i < iqSamples.length; ++i) {
+      pending[pendingLength++] = iqSamples[i];
+      if (pendingLength == pending.length) {
+        writeGroup();
+        pendingLength = 0;
+      }
+    }
+  }
+
+  /**
+   * Compresses the pending group of samples into the buffer.
+   */
+  function writeGroup() {
+    var peak = 0;
+    for (var i = 0; i < pending.length; ++i) {
+      peak = Math.max(peak, Math.abs(pending[i]));
+    }
+    var shift = 0;
+    while ((peak >> shift) > 127) {
+      ++shift;
+    }
+    var group = (written / GROUP) % groups;
+    var pos = group * GROUP * 2;
+    exponents[group] = shift;
+    for (var i = 0; i < pending.length; ++i) {
+      samples[pos + i] = pending[i] >> shift;
+    }
+    written += GROUP;
+  }
+
+  /**
+   * Tells whether the buffer contains any samples.
+   * @return {boolean} Whether there are any samples.
+   */
+  function hasSamples() {
+    return written > 0;
+  }
+
+  /**
+   * Saves the last samples in the buffer into a WAV file.
+   * @param {FileEntry} fileEntry The entry for the new WAV file.
+   * @param {number} seconds The number of seconds to save.
+   */
+  function save(fileEntry, seconds) {
+    var count = Math.min(written, size, Math.floor(seconds * rate));
+    count -= count % GROUP;
+    var first = (written - count) / GROUP;
+    var fileStart = new Date(
+        Math.max(startTime.getTime(), Date.now() - 1000 * count / rate));
+    var saver = new WavSaver(fileEntry, rate, frequency, fileStart);
+    var chunk = new Int16Array(Math.min(count, GROUP * 1024) * 2);
+    var chunkPos = 0;
+    for (var g = 0; g < count / GROUP; ++g) {
+      var group = (first + g) % groups;
+      var shift = exponents[group];
+      var pos = group * GROUP * 2;
+      for (var i = 0; i < GROUP * 2; ++i) {
+        chunk[chunkPos++] = samples[pos + i] << shift;
+      }
+      if (chunkPos == chunk.length) {
+        saver.writeInterleaved(chunk);
+        chunkPos = 0;
+      }
+    }
+    if (chunkPos > 0) {
+      saver.writeInterleaved(chunk.subarray(0, chunkPos));
+    }
+    saver.finish();
+  }
+
+  /**
+   * Returns the amount of memory the buffer was created with.
+   * @return {number} The buffer's size, in bytes.
+   */
+  function getSize() {
+    return bytes;
+  }
+
+  /**
+   * Returns the number of seconds of signal that the buffer can keep at
+   * the current sample rate.
+   * @return {number} The buffer's capacity, in seconds.
+   */
+  function getCapacity() {
+    return rate ? size / rate : 0;
+  }
+
+  return {
+    write: write,
+    hasSamples: hasSamples,
+    save: save,
+    getSize: getSize,
+    getCapacity: getCapacity
+  };
+}
@@ -15,14 +15,26 @@
 /**
  * A class to save a WAV file (48k, 16-bit, stereo).
  *
+ * It can also save I/Q samples at another sample rate, with the I component
+ * in the left channel and the Q component in the right channel. In that
+ * case, it adds an 'auxi' chunk with the center frequency and the recording
+ * times, like other SDR programs do.
+ *
  * The FileSystem API doesn't buffer writes, so this class implements that
  * buffer. The processor writes out the contents of the queue until it's
  * empty, and then polls it once a second for new items to write.
  * @param {FileEntry} fileEntry An entry for the WAV file.
+ * @param {number=} opt_rate The sample rate, 48000 by default.
+ * @param {number=} opt_frequency The center frequency of the I/Q samples.
+ *     Only specify this parameter when saving I/Q samples.
+ * @param {Date=} opt_startTime The time when the first sample was received,
+ *     if it wasn't now.
  * @constructor
  */
-function WavSaver(fileEntry) {
+function WavSaver(fileEntry, opt_rate, opt_frequency, opt_startTime) {
 
+  var rate = opt_rate || 48000;
+  var startTime = opt_startTime || new Date();
   var fileWriter;
   var queue = [];
   var writing = true;
@@ -39,7 +51,7 @@ function WavSaver(fileEntry) {
    * Writes the contents of the queue and schedules the next execution of
    * this function, if the queue is empty. After finish() was called and
    * the queue goes empty, fixes up the chunk sizes in the headers and
-   * stops rescheduling.
+   * stops.
    */
   function processQueue() {
     if (queue == null) {
@@ -51,6 +63,7 @@ function WavSaver(fileEntry) {
       } else {
         fileWriter.seek(0);
         fileWriter.write(new Blob([createHeader(fileWriter.length).buffer]));
+        queue = null;
       }
       return;      
     }
@@ -68,31 +81,80 @@ function WavSaver(fileEntry) {
   }
 
   /**
-   * Puts the contents of the given array in the queue.
+   * Puts a copy of the contents of the given array in the queue, so the
+   * caller can reuse the array.
    */
   function writeArray(arr) {
     if (writing) {
-      queue.push(arr.buffer);
+      queue.push(new Blob([arr]));
     }
   }
 
+  /**
+   * Returns the size of the WAV headers.
+   * @return {number} The size of the headers, in bytes.
+   */
+  function getHeaderSize() {
+    return opt_frequency == null ? 44 : 120;
+  }
+
   /**
    * Creates a WAV header's data.
    * @param {number} size The total file size.
    */
   function createHeader(size) {
-    return new Int32Array([
+    var header = new Int32Array(getHeaderSize() / 4);
+    header.set([
       0x46464952,   // "RIFF"
       size - 8,     // chunk size
       0x45564157,   // "WAVE"
       0x20746d66,   // "fmt "
       0x10,         // chunk size
       0x00020001,   // PCM, 2 channels
-      48000,        // sample rate
-      192000,       // data rate
-      0x00100004,   // 4 bytes/block, 16 bits/sample
+      rate,         // sample rate
+      rate * 4,     // data rate
+      0x00100004    // 4 bytes/block, 16 bits/sample
+    ]);
+    var pos = 9;
+    if (opt_frequency != null) {
+      header.set([
+        0x69787561, // "auxi"
+        68          // chunk size
+      ], pos);
+      var times = new Uint16Array(header.buffer, (pos + 2) * 4, 16);
+      setSystemTime(times.subarray(0, 8), startTime);
+      setSystemTime(times.subarray(8), writing ? startTime : new Date());
+      header.set([
+        opt_frequency, // center frequency
+        rate,          // A/D sample rate
+        0,             // intermediate frequency
+        rate,          // bandwidth
+        0              // I/Q offset
+      ], pos + 10);
+      pos += 19;
+    }
+    header.set([
       0x61746164,   // "data"
-      size - 44     // chunk size (0 for now)
+      size - getHeaderSize() // chunk size (0 for now)
+    ], pos);
+    return header;
+  }
+
+  /**
+   * Stores a date as a Windows SYSTEMTIME structure, in UTC.
+   * @param {Uint16Array} arr The array to store the structure into.
+   * @param {Date} date The date to store.
+   */
+  function setSystemTime(arr, date) {
+    arr.set([
+      date.getUTCFullYear(),
+      date.getUTCMonth() + 1,
+      date.getUTCDay(),
+      date.getUTCDate(),
+      date.getUTCHours(),
+      date.getUTCMinutes(),
+      date.getUTCSeconds(),
+      date.getUTCMilliseconds()
     ]);
   }
 
@@ -100,7 +162,7 @@ function WavSaver(fileEntry) {
    * Puts the WAV headers in the queue.
    */
   function writeHeader() {
-    writeArray(createHeader(44));
+    writeArray(createHeader(getHeaderSize()));
   }
 
   /**
@@ -119,6 +181,15 @@ function WavSaver(fileEntry) {
     writeArray(out);
   }
 
+  /**
+   * Writes a block of interleaved samples.
+   * @param {Int16Array} samples The samples, alternating between the left
+   *     (or I) and the right (or Q) channels.
+   */
+  function writeInterleaved(samples) {
+    writeArray(samples);
+  }
+
   /**
    * Finishes writing to the WAV file.
    */
@@ -135,6 +206,7 @@ function WavSaver(fileEntry) {
 
   return {
     writeSamples: writeSamples,
+    writeInterleaved: writeInterleaved,
     finish: finish,
     hasFinished: hasFinished
   };
@@ -0,0 +1,496 @@
+#!/usr/bin/env node
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview Demodulates I/Q recordings into WAV or FLAC files, using
+ * Radio Receiver's demodulators, as fast as the computer can go.
+ *
+ * Usage: node batchdecode.js [options] file...
+ *
+ * Options:
+ *   --mode=WBFM|NBFM|AM|LSB|USB  The mode to demodulate (WBFM).
+ *   --offset=HZ       The frequency of the signal to demodulate, relative
+ *                     to the recording's center frequency (0).
+ *   --frequency=HZ    The frequency of the signal to demodulate. Only for
+ *                     recordings that know their center frequency.
+ *   --bandwidth=HZ    The bandwidth for AM and SSB.
+ *   --maxf=HZ         The maximum frequency deviation for NBFM.
+ *   --mono            Don't decode stereo.
+ *   --rate=N          The sample rate of raw files (1024000).
+ *   --format=wav|flac The output format (wav).
+ *   --out=DIR         The directory for the output files (same as input).
+ *   --jobs=N          The number of threads to use (one per core).
+ *   --segment=SECONDS The minimum length of a segment (60).
+ *   --check           Also decode each file without segments and compare
+ *                     the outputs. Only for WAV.
+ *   --tolerance=X     The largest difference allowed by --check, as a
+ *                     fraction of full scale (0.001).
+ *
+ * The files are decoded in parallel by a pool of worker threads. When
+ * there are fewer files than threads, long files are split into segments
+ * that are decoded in parallel and joined afterwards. Each segment starts
+ * decoding a little before its start, so the output is the same as if the
+ * file was decoded in one go. For each file it prints how fast it was
+ * decoded, compared to real time.
+ */
+
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var threads = require('worker_threads');
+var iqtools = require('./iqtools.js');
+var flac = require('./flac.js');
+
+/**
+ * The number of seconds of signal to decode before each segment, for each
+ * modulation, so the demodulator settles. FM needs time for the stereo
+ * decoder to lock and for the filters and de-emphasis to fill up, and the
+ * DC offset and I/Q imbalance estimates take a few seconds to converge;
+ * SSB has an automatic gain control with a time constant of 5 seconds.
+ */
+var PREROLL_SECONDS = {
+  'WBFM': 3,
+  'NBFM': 3,
+  'AM': 3,
+  'LSB': 30,
+  'USB': 30
+};
+
+/**
+ * Parses the command line.
+ * @param {Array.<string>} args The arguments.
+ * @return {{options:Object,files:Array.<string>}} The options and files.
+ */
+function parseArgs(args) {
+  var options = {
+    mode: 'WBFM',
+    offset: 0,
+    frequency: null,
+    bandwidth: null,
+    maxf: null,
+    mono: false,
+    rate: 1024000,
+    format: 'wav',
+    out: null,
+    jobs: os.cpus().length,
+    segment: 60,
+    check: false,
+    tolerance: 0.001
+  };
+  var files = [];
+  for (var i = 0; i < args.length; ++i) {
+    var match = args[i].match(/^--([a-z]+)(?:=(.*))?$/);
+    if (!match) {
+      files.push(args[i]);
+    } else if (!(match[1] in options)) {
+      throw new Error('Unknown option: ' + args[i]);
+    } else if (typeof options[match[1]] == 'boolean') {
+      options[match[1]] = true;
+    } else if (match[1] == 'mode' || match[1] == 'format' ||
+               match[1] == 'out') {
+      options[match[1]] = match[2];
+    } else {
+      options[match[1]] = Number(match[2]);
+    }
+  }
+  options.mode = options.mode.toUpperCase();
+  options.format = options.format.toLowerCase();
+  return {options: options, files: files};
+}
+
+
+/**
+ * Returns the name of an output file for an input file.
+ * @param {string} file The input file's name.
+ * @param {Object} options The options.
+ * @param {string=} opt_suffix A suffix to add to the file's name.
+ * @return {string} The output file's name.
+ */
+function getOutputName(file, options, opt_suffix) {
+  var dir = options.out || path.dirname(file);
+  var base = path.basename(file).replace(/\.[^.]*$/, '');
+  return path.join(dir, base + (opt_suffix || '') + '.' + options.format);
+}
+
+/**
+ * Creates the writer for an output file.
+ * @param {string} fileName The output file's name.
+ * @param {string} format The output format: wav or flac.
+ * @param {number=} opt_firstSample If set, writes a part of the output
+ *     that starts at this sample.
+ * @return {Object} The writer.
+ */
+function createWriter(fileName, format, opt_firstSample) {
+  if (format == 'flac') {
+    return new flac.FlacWriter(fileName, iqtools.OUT_RATE, opt_firstSample);
+  }
+  return new iqtools.WavWriter(fileName, iqtools.OUT_RATE,
+                               opt_firstSample != null);
+}
+
+/**
+ * Returns the frequency offset to demodulate in an input file.
+ * @param {Object} input The input file.
+ * @param {Object} options The options.
+ * @return {number} The offset, in Hz.
+ */
+function getOffset(input, options) {
+  if (options.frequency == null) {
+    return options.offset;
+  }
+  if (!input.frequency) {
+    throw new Error('The recording does not say its center frequency; ' +
+                    'use --offset instead of --frequency');
+  }
+  return options.frequency - input.frequency;
+}
+
+/**
+ * Returns the mode to demodulate with the given options.
+ * @param {Object} options The options.
+ * @return {Object} The mode.
+ */
+function getModeForOptions(options) {
+  return iqtools.getMode(options.mode,
+      {bandwidth: options.bandwidth, maxF: options.maxf});
+}
+
+/**
+ * Decodes a segment of a file. The blocks in the pre-roll, before the
+ * segment, are decoded but not written, so that the demodulator's filters,
+ * stereo decoder and gain control are in the same state as if the file
+ * had been decoded from the beginning.
+ * @param {Object} task The file and segment to decode: file, output,
+ *     options, first and last block, number of pre-roll blocks, and the
+ *     position in the output of the segment's first sample, if it's
+ *     written to a part file.
+ * @return {Object} The number of audio samples written and the time it
+ *     took, in seconds.
+ */
+function decodeSegment(task) {
+  var startTime = Date.now();
+  var options = task.options;
+  var input = iqtools.openInput(task.file, options.rate);
+  var blockSize = iqtools.getBlockSize(input.rate);
+  var firstDecoded = Math.max(0, task.first - task.preroll);
+  var decoder = new iqtools.StreamDecoder(
+      getModeForOptions(options), input.rate, getOffset(input, options),
+      !options.mono, firstDecoded * blockSize);
+  var writer = createWriter(task.output, options.format, task.firstSample);
+  var samples = 0;
+  for (var block = firstDecoded; block < task.last; ++block) {
+    var audio = decoder.process(input.read(block * blockSize, blockSize));
+    if (block >= task.first) {
+      writer.writeSamples(audio.left, audio.right);
+      samples += audio.left.length;
+    }
+  }
+  writer.finish();
+  input.close();
+  return {samples: samples, elapsed: (Date.now() - startTime) / 1000};
+}
+
+/**
+ * Plans how to decode a file. If the file is longer than its share of the
+ * work, it's split into segments that are decoded in parallel into part
+ * files, which are joined afterwards. Each segment has a pre-roll that
+ * depends on how long the mode's demodulator takes to settle.
+ * @param {string} file The input file's name.
+ * @param {Object} options The options.
+ * @param {number} segmentSeconds The length of each segment, in seconds.
+ * @return {Object} The file's job, with its list of tasks.
+ */
+function planFile(file, options, segmentSeconds) {
+  var input = iqtools.openInput(file, options.rate);
+  input.close();
+  var mode = getModeForOptions(options);
+  var blockSize = iqtools.getBlockSize(input.rate);
+  var blocks = Math.ceil(input.count / blockSize);
+  var output = getOutputName(file, options);
+  var job = {
+    file: file,
+    output: output,
+    seconds: input.count / input.rate,
+    samples: input.count,
+    tasks: [],
+    results: [],
+    pending: 0,
+    startTime: 0
+  };
+
+  var outPerBlock = iqtools.getOutputLength(mode, input.rate, blockSize);
+  var align = 1;
+  if (options.format == 'flac') {
+    align = flac.BLOCK_SIZE / gcd(outPerBlock, flac.BLOCK_SIZE);
+  }
+  var segmentBlocks = Math.ceil(segmentSeconds * input.rate / blockSize);
+  segmentBlocks = Math.ceil(segmentBlocks / align) * align;
+  if (segmentBlocks >= blocks) {
+    job.tasks.push({file: file, output: output, options: options,
+                    first: 0, last: blocks, preroll: 0});
+    return job;
+  }
+
+  var prerollSeconds = PREROLL_SECONDS[mode.modulation] || 1;
+  var preroll = Math.ceil(prerollSeconds * input.rate / blockSize);
+  for (var first = 0; first < blocks; first += segmentBlocks) {
+    job.tasks.push({
+      file: file,
+      output: output + '.part' + job.tasks.length,
+      options: options,
+      first: first,
+      last: Math.min(blocks, first + segmentBlocks),
+      preroll: preroll,
+      firstSample: first * outPerBlock
+    });
+  }
+  return job;
+}
+
+/**
+ * Returns the greatest common divisor of two numbers.
+ * @param {number} a The first number.
+ * @param {number} b The second number.
+ * @return {number} The greatest common divisor.
+ */
+function gcd(a, b) {
+  while (b) {
+    var t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/**
+ * Joins the part files of a file that was decoded in segments.
+ * @param {Object} job The file's job.
+ */
+function joinParts(job) {
+  var writer = createWriter(job.output, job.tasks[0].options.format);
+  for (var i = 0; i < job.tasks.length; ++i) {
+    writer.appendPart(job.tasks[i].output, job.results[i].samples);
+    fs.unlinkSync(job.tasks[i].output);
+  }
+  writer.finish();
+}
+
+/**
+ * Compares two WAV files written by WavWriter.
+ * @param {string} nameA The first file's name.
+ * @param {string} nameB The second file's name.
+ * @return {{length:boolean,max:number,rms:number}} Whether both files have
+ *     the same length, and the maximum and RMS differences between their
+ *     samples, as a fraction of full scale.
+ */
+function compareWavFiles(nameA, nameB) {
+  var fdA = fs.openSync(nameA, 'r');
+  var fdB = fs.openSync(nameB, 'r');
+  var sizeA = fs.fstatSync(fdA).size;
+  var sizeB = fs.fstatSync(fdB).size;
+  var bufA = Buffer.alloc(1 << 20);
+  var bufB = Buffer.alloc(1 << 20);
+  var max = 0;
+  var sum = 0;
+  var count = 0;
+  for (var pos = 44; pos < Math.min(sizeA, sizeB); pos += bufA.length) {
+    var len = fs.readSync(fdA, bufA, 0, bufA.length, pos);
+    len = Math.min(len, fs.readSync(fdB, bufB, 0, len, pos));
+    for (var i = 0; i + 1 < len; i += 2) {
+      var diff = Math.abs(bufA.readInt16LE(i) - bufB.readInt16LE(i));
+      max = Math.max(max, diff);
+      sum += diff * diff;
+      ++count;
+    }
+  }
+  fs.closeSync(fdA);
+  fs.closeSync(fdB);
+  return {
+    length: sizeA == sizeB,
+    max: max / 32767,
+    rms: Math.sqrt(sum / Math.max(1, count)) / 32767
+  };
+}
+
+/**
+ * Formats the statistics of a decoded file.
+ * @param {Object} job The file's job.
+ * @param {number} elapsed The time it took to decode it, in seconds.
+ * @return {string} The formatted statistics.
+ */
+function formatResult(job, elapsed) {
+  return job.file + ' -> ' + job.output + ': ' +
+      job.seconds.toFixed(1) + ' s in ' + elapsed.toFixed(1) + ' s (' +
+      (job.seconds / elapsed).toFixed(1) + 'x real time, ' +
+      (job.samples / elapsed / 1e6).toFixed(2) + ' MS/s' +
+      (job.tasks.length > 1 ? ', ' + job.tasks.length + ' segments' : '') +
+      ')';
+}
+
+/**
+ * Decodes all the files with a pool of worker threads. Files are split
+ * into segments so that all the threads have work to do, even if there are
+ * fewer files than threads.
+ * @param {Array.<string>} files The files to decode.
+ * @param {Object} options The options.
+ */
+function runPool(files, options) {
+  var startTime = Date.now();
+  var totalSeconds = 0;
+  for (var i = 0; i < files.length; ++i) {
+    var input = iqtools.openInput(files[i], options.rate);
+    input.close();
+    totalSeconds += input.count / input.rate;
+  }
+  var threadCount = Math.max(1, options.jobs);
+  var segmentSeconds = Math.max(options.segment, totalSeconds / threadCount);
+  var jobs = [];
+  var queue = [];
+  for (var i = 0; i < files.length; ++i) {
+    jobs.push(planFile(files[i], options, segmentSeconds));
+    for (var j = 0; j < jobs[i].tasks.length; ++j) {
+      queue.push({job: i, index: j, task: jobs[i].tasks[j]});
+    }
+  }
+  threadCount = Math.min(threadCount, queue.length);
+
+  var failures = 0;
+  var outstanding = 0;
+  var idle = [];
+  var workers = [];
+
+  function dispatch() {
+    while (idle.length > 0 && queue.length > 0) {
+      var entry = queue.shift();
+      var worker = idle.pop();
+      worker.entry = entry;
+      ++outstanding;
+      if (entry.task && !jobs[entry.job].startTime) {
+        jobs[entry.job].startTime = Date.now();
+      }
+      worker.postMessage(entry.task || entry.serial);
+    }
+    if (outstanding == 0 && queue.length == 0) {
+      for (var i = 0; i < workers.length; ++i) {
+        workers[i].terminate();
+      }
+    }
+  }
+
+  function onTaskDone(entry, msg) {
+    var job = jobs[entry.job];
+    if (msg.error) {
+      ++failures;
+      console.error(job.file + ': ' + msg.error);
+      return;
+    }
+    if (entry.serial) {
+      checkJob(job, entry.serial.output);
+      return;
+    }
+    job.results[entry.index] = msg.result;
+    if (++job.pending < job.tasks.length) {
+      return;
+    }
+    if (job.tasks.length > 1) {
+      joinParts(job);
+    }
+    console.log(formatResult(job, (Date.now() - job.startTime) / 1000));
+    if (options.check) {
+      queue.unshift({job: entry.job, serial: {
+        file: job.file,
+        output: getOutputName(job.file, options, '.serial'),
+        options: options,
+        first: 0,
+        last: job.tasks[job.tasks.length - 1].last,
+        preroll: 0
+      }});
+    }
+  }
+
+  function checkJob(job, serialName) {
+    var diff = compareWavFiles(job.output, serialName);
+    fs.unlinkSync(serialName);
+    var ok = diff.length && diff.max <= options.tolerance;
+    console.log(job.file + ': ' + (ok ? 'matches' : 'DOES NOT MATCH') +
+                ' the serial decode (maximum difference ' +
+                diff.max.toFixed(5) + ', RMS ' + diff.rms.toFixed(6) +
+                (diff.length ? '' : ', different lengths') + ')');
+    if (!ok) {
+      ++failures;
+    }
+  }
+
+  for (var i = 0; i < threadCount; ++i) {
+    var worker = new threads.Worker(__filename);
+    worker.on('message', function(msg) {
+      --outstanding;
+      onTaskDone(this.entry, msg);
+      idle.push(this);
+      dispatch();
+    });
+    worker.on('error', function(err) {
+      --outstanding;
+      ++failures;
+      console.error(err);
+      dispatch();
+    });
+    workers.push(worker);
+    idle.push(worker);
+  }
+  dispatch();
+
+  process.on('exit', function() {
+    var elapsed = (Date.now() - startTime) / 1000;
+    console.log('Total: ' + files.length + ' files, ' +
+                (totalSeconds / 3600).toFixed(2) + ' hours of signal in ' +
+                elapsed.toFixed(1) + ' s (' +
+                (totalSeconds / elapsed).toFixed(1) + 'x real time) with ' +
+                threadCount + ' threads' +
+                (failures ? ', ' + failures + ' failed' : ''));
+    if (failures) {
+      process.exitCode = 1;
+    }
+  });
+}
+
+if (threads.isMainThread) {
+  var args = parseArgs(process.argv.slice(2));
+  if (args.files.length == 0) {
+    console.error('Usage: node batchdecode.js [options] file...');
+    process.exit(1);
+  }
+  if (args.options.check && args.options.format != 'wav') {
+    console.error('--check only works with --format=wav');
+    process.exit(1);
+  }
+  runPool(args.files, args.options);
+} else {
+  threads.parentPort.on('message', function(task) {
+    try {
+      threads.parentPort.postMessage({result: decodeSegment(task)});
+    } catch (e) {
+      threads.parentPort.postMessage({error: String(e)});
+    }
+  });
+}
+
+module.exports = {
+  parseArgs: parseArgs,
+  decodeSegment: decodeSegment,
+  planFile: planFile,
+  createWriter: createWriter,
+  getOffset: getOffset
+};
@@ -0,0 +1,1627 @@
+#!/usr/bin/env node
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview Checks the quality and speed of the demodulators.
+ *
+ * Usage: node dspbench.js [--seconds=N] [--rate=N] [case...]
+ *
+ * Synthesizes signals with known contents as unsigned 8-bit I/Q samples,
+ * like the ones the tuner gives, demodulates or decodes them, and checks the
+ * results against fixed thresholds:
+ *   wbfm-mono, am, usb, lsb, nbfm: the audio's SNR and, depending on the
+ *       mode, its distortion, sideband rejection or deviation linearity.
+ *   wbfm-stereo, wbfm-response: the stereo separation and the frequency
+ *       response.
+ *   wbfm-rds: the decoded RDS information and what decoding it costs.
+ *   am-dc: the hum left by the tuner's DC offset when an AM station is at
+ *       the center frequency.
+ *   usb-alias: how well an alias of a tone outside the passband is rejected.
+ *   adsb, nbfm-aprs, nbfm-pocsag, apt, ais: the decoded ADS-B messages,
+ *       APRS packets, POCSAG pages, APT image lines and AIS messages, and
+ *       what the APRS and POCSAG decoders cost.
+ *   occupancy: the occupancy log's channel measurements and their cost.
+ *   iq-imbalance: the correction of the tuner's DC offset and I/Q
+ *       imbalance, and its cost.
+ * It also measures how fast each demodulator runs, decoding N seconds of
+ * signal (10 by default).
+ *
+ * The signals are synthesized at N samples per second with --rate (1024000
+ * by default), with the same noise in each channel at any rate; the radio
+ * uses 256000 for narrowband modes. ADS-B always uses 2000000, and AIS and
+ * the RDS case 1024000.
+ *
+ * Run it before and after changing the DSP code: it exits with an error if
+ * any measurement is worse than its threshold.
+ */
+
+var iqtools = require('./iqtools.js');
+
+var inRate = 1024000;
+var OUT_RATE = iqtools.OUT_RATE;
+
+/**
+ * How many seconds of audio at the start of each signal are not measured,
+ * to let the demodulator settle.
+ */
+var SETTLE_SECONDS = 1;
+
+/**
+ * How many seconds of audio are measured.
+ */
+var MEASURE_SECONDS = 2;
+
+/**
+ * The amplitude of the synthesized carrier, relative to full scale.
+ */
+var CARRIER_LEVEL = 0.75;
+
+/**
+ * The standard deviation of the noise added to the samples, in 8-bit
+ * units, at 1024000 samples per second. When --rate changes the rate, it's
+ * scaled so the noise in a channel stays the same. The cases that have
+ * their own rate, like ADS-B, use it as it is.
+ */
+var NOISE_LEVEL = 0.5;
+
+/**
+ * Generates a tone.
+ * @param {number} freq The tone's frequency.
+ * @param {number} ampl The tone's amplitude.
+ * @return {function(number):number} A function that returns the tone's
+ *     value at a given time.
+ */
+function tone(freq, ampl) {
+  return function(t) {
+    return ampl * Math.sin(2 * Math.PI * freq * t);
+  };
+}
+
+/**
+ * Adds up some signals.
+ * @param {Array.<function(number):number>} signals The signals.
+ * @return {function(number):number} The sum of the signals.
+ */
+function mix(signals) {
+  return function(t) {
+    var sum = 0;
+    for (var i = 0; i < signals.length; ++i) {
+      sum += signals[i](t);
+    }
+    return sum;
+  };
+}
+
+/**
+ * Returns a generator of FM-modulated I/Q samples.
+ * @param {function(number):number} audio The modulating signal, between
+ *     -1 and 1.
+ * @param {number} deviation The frequency deviation for full scale.
+ * @return {function(number):Array.<number>} A function that returns the
+ *     I and Q values for consecutive times.
+ */
+function fmSignal(audio, deviation) {
+  var phase = 0;
+  return function(t) {
+    phase += 2 * Math.PI * deviation * audio(t) / inRate;
+    return [Math.cos(phase), Math.sin(phase)];
+  };
+}
+
+/**
+ * Returns an RDS signal that repeats a station's name and radio text, as
+ * it is added to the FM multiplex: biphase symbols with half-sine chips on
+ * a 57 kHz subcarrier.
+ * @param {number} pi The station's PI code.
+ * @param {string} ps The station's name, 8 characters long.
+ * @param {string} rt The radio text, up to 64 characters long.
+ * @param {number} ampl The amplitude of the signal.
+ * @return {function(number):number} A function that returns the signal's
+ *     value at a given time.
+ */
+function rdsSignal(pi, ps, rt, ampl) {
+  var OFFSETS = [0x0fc, 0x198, 0x168, 0x1b4];
+  function checkword(data) {
+    var reg = 0;
+    for (var i = 15; i >= 0; --i) {
+      var feedback = ((data >> i) ^ (reg >> 9)) & 1;
+      reg = (reg << 1) & 0x3ff;
+      if (feedback) {
+        reg ^= 0x1b9;
+      }
+    }
+    return reg;
+  }
+  function chars(text, pos) {
+    return (text.charCodeAt(pos) << 8) | text.charCodeAt(pos + 1);
+  }
+  var text = (rt + '\r').slice(0, 64);
+  while (text.length % 4) {
+    text += ' ';
+  }
+  var groups = [];
+  for (var i = 0; i < 4; ++i) {
+    groups.push([pi, i, 0xe0e1, chars(ps, i * 2)]);
+  }
+  for (var i = 0; i < text.length / 4; ++i) {
+    groups.push([pi, 0x2000 | i, chars(text, i * 4), chars(text, i * 4 + 2)]);
+  }
+  var bits = [];
+  var last = 0;
+  for (var g = 0; g < groups.length; ++g) {
+    for (var b = 0; b < 4; ++b) {
+      var block = (groups[g][b] << 10) |
+          (checkword(groups[g][b]) ^ OFFSETS[b]);
+      for (var i = 25; i >= 0; --i) {
+        last ^= (block >> i) & 1;
+        bits.push(last);
+      }
+    }
+  }
+  return function(t) {
+    var chips = t * 2375;
+    var chip = Math.floor(chips);
+    var bit = bits[Math.floor(chip / 2) % bits.length];
+    var sign = (bit ^ (chip & 1)) ? 1 : -1;
+    return ampl * sign * Math.sin(Math.PI * (chips - chip)) *
+        Math.sin(2 * Math.PI * 57000 * t);
+  };
+}
+
+/**
+ * Returns a generator of Mode S messages, sent one after another with
+ * different amplitudes, on a carrier away from the center frequency. The
+ * chips are half a microsecond long, one sample at 2 Msps.
+ * @param {Array.<string>} messages The messages, in hexadecimal.
+ * @param {number} interval The time between messages, in seconds.
+ * @param {Array.<number>} amplitudes The amplitudes to cycle through.
+ * @return {function(number):Array.<number>} A function that returns the
+ *     I and Q values at a given time.
+ */
+function modeSSignal(messages, interval, amplitudes) {
+  var PREAMBLE = [1, 0, 1, 0, 0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0];
+  var CARRIER_OFFSET = 150000;
+  var chips = messages.map(function(hex) {
+    var out = PREAMBLE.slice();
+    for (var i = 0; i < hex.length * 4; ++i) {
+      var bit = (parseInt(hex[i >> 2], 16) >> (3 - (i & 3))) & 1;
+      out.push(bit, 1 - bit);
+    }
+    return out;
+  });
+  var slotChips = Math.round(interval * 2e6);
+  return function(t) {
+    var pos = Math.round(t * 2e6);
+    var slot = Math.floor(pos / slotChips);
+    var msg = chips[slot % chips.length];
+    var chip = msg[pos - slot * slotChips];
+    if (!chip) {
+      return [0, 0];
+    }
+    var ampl = amplitudes[slot % amplitudes.length];
+    var phase = 2 * Math.PI * CARRIER_OFFSET * t;
+    return [ampl * Math.cos(phase), ampl * Math.sin(phase)];
+  };
+}
+
+/**
+ * Returns a generator of APRS packets on narrowband FM: AX.25 UI frames
+ * sent as 1200 baud AFSK tones with a 3 kHz deviation, one after another
+ * with different signal levels and imbalances between the tones. The
+ * transmitter is off between packets.
+ * @param {Array.<string>} packets The packets, in the usual text format,
+ *     like 'N0CALL>APRS,WIDE1-1:>Status'.
+ * @param {number} interval The time between packets, in seconds.
+ * @param {Array.<{ampl:number,twist:number}>} levels The amplitude of each
+ *     packet's carrier, and the level of its space tone relative to its
+ *     mark tone in dB, to cycle through.
+ * @return {function(number):Array.<number>} A function that returns the
+ *     I and Q values for consecutive times.
+ */
+function aprsSignal(packets, interval, levels) {
+  function address(call, last) {
+    var repeated = call[call.length - 1] == '*';
+    var parts = call.replace('*', '').split('-');
+    var bytes = [];
+    for (var i = 0; i < 6; ++i) {
+      bytes.push((parts[0].charCodeAt(i) || 32) << 1);
+    }
+    bytes.push((repeated ? 0xe0 : 0x60) | ((parts[1] || 0) << 1) |
+               (last ? 1 : 0));
+    return bytes;
+  }
+  var frames = packets.map(function(packet) {
+    var header = packet.slice(0, packet.indexOf(':')).split(/[>,]/);
+    var info = packet.slice(header.join(',').length + 1);
+    var calls = [header[1], header[0]].concat(header.slice(2));
+    var bytes = [];
+    for (var i = 0; i < calls.length; ++i) {
+      bytes = bytes.concat(address(calls[i], i == calls.length - 1));
+    }
+    bytes.push(0x03, 0xf0);
+    for (var i = 0; i < info.length; ++i) {
+      bytes.push(info.charCodeAt(i));
+    }
+    var crc = 0xffff;
+    for (var i = 0; i < bytes.length; ++i) {
+      crc ^= bytes[i];
+      for (var j = 0; j < 8; ++j) {
+        crc = crc & 1 ? (crc >>> 1) ^ 0x8408 : crc >>> 1;
+      }
+    }
+    bytes.push(~crc & 0xff, (~crc >>> 8) & 0xff);
+    var bits = [];
+    function flags(count) {
+      for (var i = 0; i < count * 8; ++i) {
+        bits.push((0x7e >> (i & 7)) & 1);
+      }
+    }
+    flags(24);
+    var ones = 0;
+    for (var i = 0; i < bytes.length * 8; ++i) {
+      var bit = (bytes[i >> 3] >> (i & 7)) & 1;
+      bits.push(bit);
+      ones = bit ? ones + 1 : 0;
+      if (ones == 5) {
+        bits.push(0);
+        ones = 0;
+      }
+    }
+    flags(2);
+    var tones = [];
+    var mark = true;
+    for (var i = 0; i < bits.length; ++i) {
+      mark = bits[i] ? mark : !mark;
+      tones.push(mark);
+    }
+    return tones;
+  });
+  var phase = 0;
+  var audioPhase = 0;
+  return function(t) {
+    var slot = Math.floor(t / interval);
+    var tones = frames[slot % frames.length];
+    var bit = Math.floor((t - slot * interval) * 1200);
+    if (bit >= tones.length) {
+      return [0, 0];
+    }
+    var level = levels[slot % levels.length];
+    var mark = tones[bit];
+    audioPhase += 2 * Math.PI * (mark ? 1200 : 2200) / inRate;
+    // The louder tone gets the full deviation.
+    var twist = mark ? -Math.max(0, level.twist) : Math.min(0, level.twist);
+    var audio = Math.sin(audioPhase) * Math.pow(10, twist / 20);
+    phase += 2 * Math.PI * 3000 * audio / inRate;
+    return [level.ampl * Math.cos(phase), level.ampl * Math.sin(phase)];
+  };
+}
+
+/**
+ * Returns a generator of POCSAG transmissions on narrowband FM: 2-FSK with
+ * a 4.5 kHz deviation, one transmission after another, with the
+ * transmitter off between them.
+ * @param {Array.<Object>} transmissions The transmissions. Each one has a
+ *     baud rate, a carrier amplitude, whether its polarity is inverted,
+ *     how many bits to flip in each codeword, and the pages it sends, each
+ *     with an address, a function, and numeric or alphanumeric text unless
+ *     it is a tone-only page.
+ * @param {number} gap The time between transmissions, in seconds.
+ * @return {function(number):Array.<number>} A function that returns the
+ *     I and Q values for consecutive times.
+ */
+function pocsagSignal(transmissions, gap) {
+  var SYNC = 0x7cd215d8;
+  var IDLE = 0x7a89c197;
+  var NUMERIC = '0123456789*U -)(';
+  function codeword(data) {
+    var rem = data << 10;
+    for (var i = 30; i >= 10; --i) {
+      if (rem & (1 << i)) {
+        rem ^= 0x769 << (i - 10);
+      }
+    }
+    var word = ((data << 11) | (rem << 1)) >>> 0;
+    var parity = 0;
+    for (var x = word; x; x &= x - 1) {
+      parity ^= 1;
+    }
+    return (word | parity) >>> 0;
+  }
+  function messageWords(page) {
+    var bits = [];
+    if (page.numeric == null && page.alpha == null) {
+      return [];
+    } else if (page.numeric != null) {
+      var text = page.numeric;
+      while (text.length % 5) {
+        text += ' ';
+      }
+      for (var i = 0; i < text.length; ++i) {
+        var digit = NUMERIC.indexOf(text[i]);
+        for (var b = 0; b < 4; ++b) {
+          bits.push((digit >> b) & 1);
+        }
+      }
+    } else {
+      for (var i = 0; i <= page.alpha.length; ++i) {
+        var ch = i < page.alpha.length ? page.alpha.charCodeAt(i) : 4;
+        for (var b = 0; b < 7; ++b) {
+          bits.push((ch >> b) & 1);
+        }
+      }
+      while (bits.length % 20) {
+        bits.push(0);
+      }
+    }
+    var words = [];
+    for (var i = 0; i < bits.length; i += 20) {
+      var data = 1 << 20;
+      for (var b = 0; b < 20; ++b) {
+        data |= bits[i + b] << (19 - b);
+      }
+      words.push(codeword(data));
+    }
+    return words;
+  }
+  var segments = [];
+  var start = 0;
+  for (var t = 0; t < transmissions.length; ++t) {
+    var tx = transmissions[t];
+    var words = [];
+    for (var p = 0; p < tx.pages.length; ++p) {
+      var page = tx.pages[p];
+      while (words.length % 16 != (page.address & 7) * 2) {
+        words.push(IDLE);
+      }
+      words.push(codeword(((page.address >> 3) << 2) | page.func));
+      words = words.concat(messageWords(page));
+    }
+    while (words.length % 16) {
+      words.push(IDLE);
+    }
+    var bits = [];
+    for (var i = 0; i < 576; ++i) {
+      bits.push(1 - (i & 1));
+    }
+    for (var i = 0; i < words.length; ++i) {
+      var word = words[i];
+      if (i % 16 == 0) {
+        for (var b = 31; b >= 0; --b) {
+          bits.push((SYNC >>> b) & 1);
+        }
+      }
+      for (var e = 0; e < tx.errors; ++e) {
+        word ^= 1 << ((i * 7 + e * 13) % 32);
+      }
+      for (var b = 31; b >= 0; --b) {
+        bits.push((word >>> b) & 1);
+      }
+    }
+    segments.push({start: start, tx: tx, bits: bits});
+    start += bits.length / tx.baud + gap;
+  }
+  var phase = 0;
+  return function(t) {
+    for (var s = segments.length - 1; s > 0 && segments[s].start > t; --s) {}
+    var segment = segments[s];
+    var bit = segment.bits[Math.floor((t - segment.start) * segment.tx.baud)];
+    if (bit == null) {
+      return [0, 0];
+    }
+    phase += 2 * Math.PI * 4500 * (bit ^ segment.tx.inverted ? -1 : 1) /
+        inRate;
+    var ampl = segment.tx.ampl;
+    return [ampl * Math.cos(phase), ampl * Math.sin(phase)];
+  };
+}
+
+/**
+ * Returns an APT signal, as it is sent by NOAA weather satellites: words
+ * that modulate the amplitude of a 2400 Hz subcarrier, 2080 per line, with
+ * the two synchronization bursts, the spaces and the telemetry around the
+ * two images. The amplitude goes from word to word with a raised cosine,
+ * which keeps it within the subcarrier's bandwidth.
+ * @param {function(number,number):number} image A function that returns
+ *     the brightness, between 0 and 1, of a pixel given its line and its
+ *     column. The columns of the first image go from 0 to 908, and those of
+ *     the second one from 1040 to 1948.
+ * @param {number} wordRate The number of words per second, nominally 4160.
+ * @return {function(number):number} A function that returns the signal's
+ *     value at a given time.
+ */
+function aptSignal(image, wordRate) {
+  var SYNC_A = '000011001100110011001100110011000000000';
+  var SYNC_B = '000011100111001110011100111001110011100';
+  var LAYOUT = [[SYNC_A, 47, 909, 45], [SYNC_B, 47, 909, 45]];
+  function word(line, pos) {
+    var half = pos < 1040 ? 0 : 1;
+    var sync = LAYOUT[half][0];
+    var column = pos - half * 1040;
+    if (column < sync.length) {
+      return sync[column] == '1' ? 1 : 0;
+    }
+    column -= sync.length;
+    if (column < LAYOUT[half][1]) {
+      return half;
+    }
+    column -= LAYOUT[half][1];
+    if (column < LAYOUT[half][2]) {
+      return image(line, half * 1040 + column);
+    }
+    return 0.5;
+  }
+  function value(pos) {
+    return word(Math.floor(pos / 2080), pos % 2080);
+  }
+  return function(t) {
+    var words = t * wordRate - 0.5;
+    var pos = Math.floor(words);
+    var start = value(Math.max(0, pos));
+    var mix = (1 - Math.cos(Math.PI * (words - pos))) / 2;
+    var ampl = 0.13 + 0.87 * (start + (value(pos + 1) - start) * mix);
+    return ampl * Math.sin(2 * Math.PI * 2400 * t);
+  };
+}
+
+/**
+ * Returns a generator of AIS messages on one channel: HDLC frames sent as
+ * 9600 bps GMSK, with a 2400 Hz deviation and BT = 0.4, one after another
+ * with different signal levels and frequency errors. The transmitter is
+ * off between messages.
+ * @param {Array.<Array.<string>>} messages The messages, as the NMEA
+ *     sentences that carry them.
+ * @param {number} interval The time between messages, in seconds.
+ * @param {Array.<{ampl:number,error:number}>} levels The amplitude of each
+ *     message's carrier, and its frequency error in Hz, to cycle through.
+ * @return {function(number):Array.<number>} A function that returns the
+ *     I and Q values for consecutive times.
+ */
+function aisSignal(messages, interval, levels) {
+  var BAUD = 9600;
+  var PULSE_STEPS = 32;
+  var PULSE_BITS = 3;
+  // The frequency pulse of a bit: a one-bit-long rectangle, smoothed by a
+  // gaussian filter with BT = 0.4.
+  var K = Math.PI * 0.4 * Math.sqrt(2 / Math.log(2));
+  function erf(x) {
+    var t = 1 / (1 + 0.3275911 * Math.abs(x));
+    var y = 1 - t * (0.254829592 + t * (-0.284496736 + t * (1.421413741 +
+            t * (-1.453152027 + t * 1.061405429)))) * Math.exp(-x * x);
+    return x < 0 ? -y : y;
+  }
+  var pulse = [];
+  for (var i = -PULSE_BITS * PULSE_STEPS; i <= PULSE_BITS * PULSE_STEPS; ++i) {
+    var x = i / PULSE_STEPS;
+    pulse.push((erf(K * (x + 0.5)) - erf(K * (x - 0.5))) / 2);
+  }
+  var frames = messages.map(function(sentences) {
+    var payload = '';
+    var fill = 0;
+    for (var i = 0; i < sentences.length; ++i) {
+      var fields = sentences[i].split(',');
+      payload += fields[5];
+      fill = Number(fields[6].split('*')[0]);
+    }
+    var bytes = [];
+    for (var i = 0; i < payload.length * 6 - fill; ++i) {
+      var value = payload.charCodeAt(Math.floor(i / 6)) - 48;
+      value = value > 40 ? value - 8 : value;
+      var bit = (value >> (5 - i % 6)) & 1;
+      bytes[i >> 3] = (bytes[i >> 3] || 0) | (bit << (7 - (i & 7)));
+    }
+    var crc = 0xffff;
+    for (var i = 0; i < bytes.length; ++i) {
+      crc ^= bytes[i];
+      for (var j = 0; j < 8; ++j) {
+        crc = crc & 1 ? (crc >>> 1) ^ 0x8408 : crc >>> 1;
+      }
+    }
+    bytes.push(~crc & 0xff, (~crc >>> 8) & 0xff);
+    // The training sequence, the start flag, the data and the end flag.
+    var bits = [];
+    for (var i = 0; i < 24; ++i) {
+      bits.push(i & 1);
+    }
+    for (var i = 0; i < 8; ++i) {
+      bits.push((0x7e >> i) & 1);
+    }
+    var ones = 0;
+    for (var i = 0; i < bytes.length * 8; ++i) {
+      var bit = (bytes[i >> 3] >> (i & 7)) & 1;
+      bits.push(bit);
+      ones = bit ? ones + 1 : 0;
+      if (ones == 5) {
+        bits.push(0);
+        ones = 0;
+      }
+    }
+    for (var i = 0; i < 8; ++i) {
+      bits.push((0x7e >> i) & 1);
+    }
+    var symbols = [];
+    var level = 1;
+    for (var i = 0; i < bits.length; ++i) {
+      level = bits[i] ? level : -level;
+      symbols.push(level);
+    }
+    return symbols;
+  });
+  var phase = 0;
+  return function(t) {
+    var slot = Math.floor(t / interval);
+    var symbols = frames[slot % frames.length];
+    var pos = (t - slot * interval) * BAUD;
+    if (pos >= symbols.length) {
+      return [0, 0];
+    }
+    var level = levels[slot % levels.length];
+    var freq = 0;
+    var first = Math.max(0, Math.floor(pos - 0.5) - PULSE_BITS + 1);
+    var last = Math.min(symbols.length - 1, Math.floor(pos - 0.5) + PULSE_BITS);
+    for (var k = first; k <= last; ++k) {
+      var step = Math.round((pos - k - 0.5) * PULSE_STEPS);
+      if (Math.abs(step) <= PULSE_BITS * PULSE_STEPS) {
+        freq += symbols[k] * pulse[step + PULSE_BITS * PULSE_STEPS];
+      }
+    }
+    phase += 2 * Math.PI * (2400 * freq + level.error) / inRate;
+    return [level.ampl * Math.cos(phase), level.ampl * Math.sin(phase)];
+  };
+}
+
+/**
+ * Returns a generator of AM-modulated I/Q samples. The carrier is a few
+ * Hz off the center frequency, as it always is with a real tuner.
+ * @param {function(number):number} audio The modulating signal, between
+ *     -1 and 1.
+ * @param {number=} opt_carrierOffset The carrier's offset from the center
+ *     frequency, in Hz (20 by default).
+ * @return {function(number):Array.<number>} A function that returns the
+ *     I and Q values at a given time.
+ */
+function amSignal(audio, opt_carrierOffset) {
+  var carrierOffset = opt_carrierOffset || 20;
+  return function(t) {
+    var ampl = (1 + audio(t)) / 2;
+    var phase = 2 * Math.PI * carrierOffset * t;
+    return [ampl * Math.cos(phase), ampl * Math.sin(phase)];
+  };
+}
+
+/**
+ * Returns a generator of single-sideband I/Q samples, which are tones at
+ * the given offsets from the center frequency.
+ * @param {Array.<Array.<number>>} tones The offset and amplitude of each
+ *     tone. Negative offsets are in the lower sideband.
+ * @return {function(number):Array.<number>} A function that returns the
+ *     I and Q values at a given time.
+ */
+function ssbSignal(tones) {
+  return function(t) {
+    var I = 0;
+    var Q = 0;
+    for (var i = 0; i < tones.length; ++i) {
+      var phase = 2 * Math.PI * tones[i][0] * t;
+      I += tones[i][1] * Math.cos(phase);
+      Q += tones[i][1] * Math.sin(phase);
+    }
+    return [I, Q];
+  };
+}
+
+/**
+ * Moves a signal away from the center frequency and changes its amplitude.
+ * @param {function(number):Array.<number>} signal The I/Q generator.
+ * @param {number} offset The frequency to move the signal to.
+ * @param {number} ampl The signal's new amplitude.
+ * @return {function(number):Array.<number>} The moved signal.
+ */
+function offsetSignal(signal, offset, ampl) {
+  return function(t) {
+    var IQ = signal(t);
+    var c = ampl * Math.cos(2 * Math.PI * offset * t);
+    var s = ampl * Math.sin(2 * Math.PI * offset * t);
+    return [IQ[0] * c - IQ[1] * s, IQ[0] * s + IQ[1] * c];
+  };
+}
+
+/**
+ * Adds up some I/Q signals.
+ * @param {Array.<function(number):Array.<number>>} signals The signals.
+ * @return {function(number):Array.<number>} The sum of the signals.
+ */
+function mixIQ(signals) {
+  return function(t) {
+    var I = 0;
+    var Q = 0;
+    for (var i = 0; i < signals.length; ++i) {
+      var IQ = signals[i](t);
+      I += IQ[0];
+      Q += IQ[1];
+    }
+    return [I, Q];
+  };
+}
+
+/**
+ * Synthesizes a signal as unsigned 8-bit I/Q samples, with a little
+ * gaussian noise from a fixed seed, so every run gets the same samples.
+ *
+ * The samples can be spoiled the way a tuner does it, with a DC offset and
+ * with a Q channel that has a different gain than I and is not quite 90
+ * degrees apart from it.
+ * @param {function(number):Array.<number>} signal The I/Q generator.
+ * @param {number} seconds The length of the signal.
+ * @param {number} noiseLevel The standard deviation of the noise, in 8-bit
+ *     units.
+ * @param {{dcI:number,dcQ:number,gain:number,phase:number}=} opt_imbalance
+ *     The DC offsets relative to full scale, the gain of Q relative to I,
+ *     and the phase error of Q in degrees.
+ * @return {Uint8Array} The samples.
+ */
+function synthesize(signal, seconds, noiseLevel, opt_imbalance) {
+  var imbalance = opt_imbalance || {dcI: 0, dcQ: 0, gain: 1, phase: 0};
+  var phaseCos = Math.cos(imbalance.phase * Math.PI / 180);
+  var phaseSin = Math.sin(imbalance.phase * Math.PI / 180);
+  var count = Math.round(seconds * inRate);
+  var out = new Uint8Array(count * 2);
+  var seed = 12345;
+  function random() {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    return seed / 2147483648;
+  }
+  function noise() {
+    return noiseLevel * Math.sqrt(-2 * Math.log(1 - random())) *
+        Math.cos(2 * Math.PI * random());
+  }
+  for (var i = 0; i < count; ++i) {
+    var IQ = signal(i / inRate);
+    var I = CARRIER_LEVEL * IQ[0] + imbalance.dcI;
+    var Q = CARRIER_LEVEL * imbalance.gain *
+        (IQ[1] * phaseCos + IQ[0] * phaseSin) + imbalance.dcQ;
+    out[2 * i] = toUint8(127.5 + 127.5 * I + noise());
+    out[2 * i + 1] = toUint8(127.5 + 127.5 * Q + noise());
+  }
+  return out;
+}
+
+/**
+ * Rounds and clamps a value into an unsigned 8-bit sample.
+ * @param {number} value The value.
+ * @return {number} The sample.
+ */
+function toUint8(value) {
+  return Math.max(0, Math.min(255, Math.round(value)));
+}
+
+/**
+ * Demodulates synthesized samples in blocks, as the app does.
+ * @param {Object} mode The mode to demodulate.
+ * @param {Uint8Array} samples The samples.
+ * @param {number} offset The frequency of the signal to demodulate.
+ * @param {boolean} inStereo Whether to decode stereo.
+ * @param {boolean=} opt_rds Whether to decode the RDS signal.
+ * @param {Array.<string>=} opt_decoders The data decoders to enable.
+ * @return {{left:Float32Array,right:Float32Array,rds:Object,messages:Array.<Object>,imageLines:Array.<Uint8Array>}}
+ *     The audio, the RDS information at the end, the decoded messages, and
+ *     the decoded image lines.
+ */
+function demodulate(mode, samples, offset, inStereo, opt_rds, opt_decoders) {
+  var ext = iqtools.loadExtension();
+  var decoder = new iqtools.StreamDecoder(mode, inRate, offset, inStereo);
+  decoder.enableRds(!!opt_rds);
+  (opt_decoders || []).forEach(function(name) {
+    decoder.enableDecoder(name, true);
+  });
+  var blockBytes = iqtools.getBlockSize(inRate) * 2;
+  var left = [];
+  var right = [];
+  var rds = null;
+  var messages = [];
+  var imageLines = [];
+  for (var pos = 0; pos < samples.length; pos += blockBytes) {
+    var block = samples.slice(pos, pos + blockBytes);
+    var audio = decoder.process(ext.iqSamplesFromUint8(block.buffer, inRate));
+    left.push(audio.left);
+    right.push(audio.right);
+    rds = audio.rds;
+    messages = messages.concat(audio.messages || []);
+    imageLines = imageLines.concat(audio.imageLines || []);
+  }
+  return {left: concat(left), right: concat(right), rds: rds,
+          messages: messages, imageLines: imageLines};
+}
+
+/**
+ * Joins a list of arrays.
+ * @param {Array.<Float32Array>} arrays The arrays.
+ * @return {Float32Array} The joined arrays.
+ */
+function concat(arrays) {
+  var length = 0;
+  for (var i = 0; i < arrays.length; ++i) {
+    length += arrays[i].length;
+  }
+  var out = new Float32Array(length);
+  for (var i = 0, pos = 0; i < arrays.length; pos += arrays[i++].length) {
+    out.set(arrays[i], pos);
+  }
+  return out;
+}
+
+/**
+ * Measures some tones in the demodulated audio, after the settling time.
+ *
+ * Each tone's amplitude is found by correlating the audio with a sine and
+ * a cosine of the tone's frequency; the measured section has a whole
+ * number of cycles of each tone, so the tones don't leak into each other.
+ * Whatever is left after removing the tones and their harmonics is noise.
+ * @param {Float32Array} audio The audio.
+ * @param {Array.<number>} freqs The tones' frequencies, in whole Hz.
+ * @return {{ampl:Array.<number>,snr:number,thd:number}} The amplitude of
+ *     each tone, the signal-to-noise ratio in dB, and the total harmonic
+ *     distortion in dB, relative to the tones.
+ */
+function measureTones(audio, freqs) {
+  var start = SETTLE_SECONDS * OUT_RATE;
+  var x = audio.subarray(start, start + MEASURE_SECONDS * OUT_RATE);
+  var n = x.length;
+  var mean = 0;
+  for (var i = 0; i < n; ++i) {
+    mean += x[i];
+  }
+  mean /= n;
+  var total = 0;
+  for (var i = 0; i < n; ++i) {
+    total += (x[i] - mean) * (x[i] - mean);
+  }
+  total /= n;
+
+  function amplitude(freq) {
+    var c = 0;
+    var s = 0;
+    var w = 2 * Math.PI * freq / OUT_RATE;
+    for (var i = 0; i < n; ++i) {
+      c += (x[i] - mean) * Math.cos(w * i);
+      s += (x[i] - mean) * Math.sin(w * i);
+    }
+    return 2 * Math.sqrt(c * c + s * s) / n;
+  }
+
+  var ampl = [];
+  var tonePower = 0;
+  var harmonicPower = 0;
+  for (var i = 0; i < freqs.length; ++i) {
+    ampl.push(amplitude(freqs[i]));
+    tonePower += ampl[i] * ampl[i] / 2;
+    for (var h = 2; h <= 5 && h * freqs[i] < OUT_RATE / 2; ++h) {
+      var a = amplitude(h * freqs[i]);
+      harmonicPower += a * a / 2;
+    }
+  }
+  var noisePower = Math.max(1e-20, total - tonePower - harmonicPower);
+  return {
+    ampl: ampl,
+    snr: 10 * Math.log(tonePower / noisePower) / Math.LN10,
+    thd: 10 * Math.log(Math.max(1e-20, harmonicPower) / tonePower) / Math.LN10
+  };
+}
+
+/**
+ * Converts an amplitude ratio into decibels.
+ * @param {number} ratio The ratio.
+ * @return {number} The ratio in dB.
+ */
+function dB(ratio) {
+  return 20 * Math.log(ratio) / Math.LN10;
+}
+
+/**
+ * The gain of the 50 µs de-emphasis filter at a given frequency.
+ * @param {number} freq The frequency.
+ * @return {number} The gain.
+ */
+function deemphasisGain(freq) {
+  var x = 2 * Math.PI * freq * 50e-6;
+  return 1 / Math.sqrt(1 + x * x);
+}
+
+/**
+ * The test cases. Each one synthesizes a signal, demodulates it, and
+ * returns a list of measurements. Each measurement has a name, a value,
+ * and either a minimum or a maximum allowed value.
+ */
+var CASES = {
+  'wbfm-mono': {
+    mode: 'WBFM',
+    stereo: false,
+    signal: function() {
+      return fmSignal(tone(1000, 0.5), 75000);
+    },
+    measure: function(audio) {
+      var m = measureTones(audio.left, [1000]);
+      return [
+        {name: 'SNR (dB)', value: m.snr, min: 40},
+        {name: 'THD (dB)', value: m.thd, max: -40}
+      ];
+    }
+  },
+  'wbfm-rds': {
+    // A station sending its name and radio text, with a 3 kHz deviation
+    // for the RDS signal, as usual.
+    mode: 'WBFM',
+    // The radio always uses this rate for WBFM. The RDS decoder's cost is
+    // relative to the demodulator's, which is smaller at lower rates.
+    rate: 1024000,
+    stereo: false,
+    rds: true,
+    ps: 'DSPBENCH',
+    rt: 'Testing the RDS decoder',
+    signal: function() {
+      var audio = mix([
+        tone(1000, 0.5),
+        tone(19000, 0.1),
+        rdsSignal(0x1234, this.ps, this.rt, 0.04)
+      ]);
+      return fmSignal(audio, 75000);
+    },
+    seconds: function() {
+      return 4;
+    },
+    measure: function(audio, samples) {
+      var rds = audio.rds || {ps: '', rt: ''};
+      var errors = 0;
+      for (var i = 0; i < this.ps.length; ++i) {
+        errors += rds.ps[i] == this.ps[i] ? 0 : 1;
+      }
+      for (var i = 0; i < this.rt.length; ++i) {
+        errors += rds.rt[i] == this.rt[i] ? 0 : 1;
+      }
+      return [
+        {name: 'PI code', value: rds.pi || 0, min: 0x1234},
+        {name: 'Wrong characters', value: errors, max: 0},
+        {name: 'RDS cost (%)', value: measureDecoderCost(
+             samples, 'WBFM', function(demodulator) {
+               demodulator.enableRds(true);
+             }), max: 10}
+      ];
+    }
+  },
+  'wbfm-stereo': {
+    mode: 'WBFM',
+    stereo: true,
+    signal: function() {
+      var left = tone(1000, 0.4);
+      var right = tone(2500, 0.4);
+      var pilot = tone(19000, 0.1);
+      return fmSignal(function(t) {
+        var l = left(t);
+        var r = right(t);
+        return 0.45 * (l + r) + pilot(t) +
+            0.45 * (l - r) * Math.sin(2 * Math.PI * 38000 * t);
+      }, 75000);
+    },
+    measure: function(audio) {
+      var l = measureTones(audio.left, [1000, 2500]);
+      var r = measureTones(audio.right, [1000, 2500]);
+      return [
+        {name: 'Left separation (dB)', value: dB(l.ampl[0] / l.ampl[1]),
+         min: 18},
+        {name: 'Right separation (dB)', value: dB(r.ampl[1] / r.ampl[0]),
+         min: 18},
+        {name: 'Left SNR (dB)', value: l.snr, min: 30}
+      ];
+    }
+  },
+  'wbfm-response': {
+    mode: 'WBFM',
+    stereo: false,
+    freqs: [100, 300, 1000, 3000, 6000],
+    signal: function() {
+      var tones = [];
+      for (var i = 0; i < this.freqs.length; ++i) {
+        tones.push(tone(this.freqs[i], 0.1));
+      }
+      return fmSignal(mix(tones), 75000);
+    },
+    measure: function(audio) {
+      var m = measureTones(audio.left, this.freqs);
+      var ref = m.ampl[2] / deemphasisGain(this.freqs[2]);
+      var out = [];
+      for (var i = 0; i < this.freqs.length; ++i) {
+        var error = dB(m.ampl[i] / deemphasisGain(this.freqs[i]) / ref);
+        out.push({name: 'Response at ' + this.freqs[i] + ' Hz (dB)',
+                  value: Math.abs(error), max: 3});
+      }
+      return out;
+    }
+  },
+  'am': {
+    mode: 'AM',
+    stereo: false,
+    signal: function() {
+      return amSignal(tone(1000, 0.5));
+    },
+    measure: function(audio) {
+      var m = measureTones(audio.left, [1000]);
+      return [
+        {name: 'SNR (dB)', value: m.snr, min: 30},
+        {name: 'THD (dB)', value: m.thd, max: -30}
+      ];
+    }
+  },
+  'am-dc': {
+    // A station tuned at the center frequency, a few tens of Hz off, on
+    // top of the tuner's DC offset, which must not come out as a hum at
+    // the carrier's offset.
+    mode: 'AM',
+    stereo: false,
+    imbalance: {dcI: 0.05, dcQ: -0.03, gain: 1, phase: 0},
+    signal: function() {
+      return amSignal(tone(1000, 0.5), 60);
+    },
+    measure: function(audio) {
+      var m = measureTones(audio.left, [1000, 60]);
+      return [
+        {name: 'Hum at the carrier offset (dB)',
+         value: dB(m.ampl[1] / m.ampl[0]), max: -50},
+        {name: 'SNR (dB)', value: m.snr, min: 30}
+      ];
+    }
+  },
+  'usb': {
+    mode: 'USB',
+    stereo: false,
+    signal: function() {
+      return ssbSignal([[1000, 0.3], [-1500, 0.3]]);
+    },
+    measure: function(audio) {
+      var m = measureTones(audio.left, [1000, 1500]);
+      return [
+        {name: 'Sideband rejection (dB)', value: dB(m.ampl[0] / m.ampl[1]),
+         min: 25},
+        {name: 'SNR (dB)', value: m.snr, min: 25}
+      ];
+    }
+  },
+  'lsb': {
+    mode: 'LSB',
+    stereo: false,
+    signal: function() {
+      return ssbSignal([[-1000, 0.3], [1500, 0.3]]);
+    },
+    measure: function(audio) {
+      var m = measureTones(audio.left, [1000, 1500]);
+      return [
+        {name: 'Sideband rejection (dB)', value: dB(m.ampl[0] / m.ampl[1]),
+         min: 25},
+        {name: 'SNR (dB)', value: m.snr, min: 25}
+      ];
+    }
+  },
+  'usb-alias': {
+    // A strong tone 49.5 kHz above the tuned frequency, which the input
+    // filter must reject before downsampling to 48 kHz, or it comes out
+    // at 1500 Hz.
+    mode: 'USB',
+    stereo: false,
+    signal: function() {
+      return ssbSignal([[1000, 0.03], [49500, 0.6]]);
+    },
+    measure: function(audio) {
+      var m = measureTones(audio.left, [1000, 1500]);
+      return [
+        {name: 'Alias rejection (dB)',
+         value: dB(m.ampl[0] / 0.03 * 0.6 / m.ampl[1]), min: 50}
+      ];
+    }
+  },
+  'nbfm': {
+    mode: 'NBFM',
+    stereo: false,
+    deviations: [1000, 2500, 5000],
+    signal: function() {
+      // Each deviation in turn, for a whole measurement each.
+      var deviations = this.deviations;
+      var length = SETTLE_SECONDS + MEASURE_SECONDS;
+      var audio = tone(1000, 1);
+      return fmSignal(function(t) {
+        var step = Math.min(deviations.length - 1, Math.floor(t / length));
+        return audio(t) * deviations[step];
+      }, 1);
+    },
+    seconds: function() {
+      return this.deviations.length * (SETTLE_SECONDS + MEASURE_SECONDS);
+    },
+    measure: function(audio) {
+      var length = (SETTLE_SECONDS + MEASURE_SECONDS) * OUT_RATE;
+      var gains = [];
+      var snr = Infinity;
+      for (var i = 0; i < this.deviations.length; ++i) {
+        var m = measureTones(audio.left.subarray(i * length), [1000]);
+        gains.push(m.ampl[0] / this.deviations[i]);
+        snr = Math.min(snr, m.snr);
+      }
+      var linearity = 0;
+      for (var i = 1; i < gains.length; ++i) {
+        linearity = Math.max(linearity, Math.abs(dB(gains[i] / gains[0])));
+      }
+      return [
+        {name: 'Deviation linearity (dB)', value: linearity, max: 0.5},
+        {name: 'Worst SNR (dB)', value: snr, min: 20}
+      ];
+    }
+  },
+  'adsb': {
+    // Aircraft identification, position and velocity messages and an
+    // all-call reply, 2500 per second, some of them weak.
+    mode: 'ADSB',
+    rate: 2000000,
+    stereo: false,
+    messages: [
+      '8D4840D6202CC371C32CE0576098',
+      '8D40621D58C382D690C8AC2863A7',
+      '8D40621D58C386435CC412692AD6',
+      '8D485020994409940838175B284F',
+      '5D4840D6F8740F'
+    ],
+    signal: function() {
+      return modeSSignal(this.messages, 0.0004, [1, 0.3, 0.1, 0.04]);
+    },
+    measure: function(audio, samples) {
+      var ext = iqtools.loadExtension();
+      var demodulator = ext.createDemodulator(
+          iqtools.getMode('ADSB'), inRate, OUT_RATE);
+      var blockBytes = iqtools.getBlockSize(inRate) * 2;
+      var found = 0;
+      var wrong = 0;
+      for (var pos = 0; pos < samples.length; pos += blockBytes) {
+        var block = samples.slice(pos, pos + blockBytes).buffer;
+        var messages = demodulator.demodulateRaw(block).messages;
+        for (var i = 0; i < messages.length; ++i) {
+          if (this.messages.indexOf(messages[i].hex) >= 0) {
+            ++found;
+          } else {
+            ++wrong;
+          }
+        }
+      }
+      var sent = Math.floor(samples.length / 2 / inRate / 0.0004);
+      return [
+        {name: 'Decoded messages (%)', value: 100 * found / sent, min: 99},
+        {name: 'Wrong messages', value: wrong, max: 0}
+      ];
+    }
+  },
+  'nbfm-aprs': {
+    // Position and status packets, one per second, some of them near the
+    // noise and with a space tone louder or much quieter than the mark
+    // tone, as radios with and without emphasis send them.
+    mode: 'NBFM',
+    stereo: false,
+    decoders: ['APRS'],
+    interval: 1,
+    levels: [{ampl: 1, twist: 0}, {ampl: 1, twist: -12},
+             {ampl: 0.005, twist: 0}, {ampl: 0.005, twist: -6},
+             {ampl: 0.005, twist: 6}, {ampl: 0.006, twist: -15}],
+    packets: [
+      'N0CALL-9>APRS,WIDE1-1,WIDE2-1:!4903.50N/07201.75W>Mobile 073',
+      'N0CALL>APZ123,WIDE2-2:>Testing the APRS decoder',
+      'N0CALL-13>APRS:@092345z4903.50N/07201.75W_220/004g005t077',
+      'N0CALL-2>APRS,N0CALL-1*,WIDE1*:=4903.50N/07201.75W#Digipeater'
+    ],
+    signal: function() {
+      return aprsSignal(this.packets, this.interval, this.levels);
+    },
+    seconds: function() {
+      return 12;
+    },
+    measure: function(audio, samples) {
+      var sent = Math.floor(samples.length / 2 / inRate / this.interval);
+      var self = this;
+      function count(messages) {
+        var found = 0;
+        var wrong = 0;
+        messages.forEach(function(msg) {
+          if (self.packets.indexOf(msg.text) >= 0) {
+            ++found;
+          } else {
+            ++wrong;
+          }
+        });
+        return {found: 100 * found / sent, wrong: wrong};
+      }
+      var voted = count(audio.messages);
+      // The same audio, with only the slicer that weighs both tones alike.
+      var ext = iqtools.loadExtension();
+      var single = count(new ext.AprsDecoder(OUT_RATE, [1]).process(
+          audio.left));
+      return [
+        {name: 'Decoded packets (%)', value: voted.found, min: 95},
+        {name: 'Decoded with one slicer (%)', value: single.found, min: 80},
+        {name: 'Wrong packets', value: voted.wrong, max: 0},
+        {name: 'APRS cost (%)', value: measureDecoderCost(
+             samples, 'NBFM', function(demodulator) {
+               demodulator.enableDecoder('APRS', true);
+             }), max: 10}
+      ];
+    }
+  },
+  'nbfm-pocsag': {
+    // Pages at each baud rate, one transmission with the opposite
+    // polarity, one with two wrong bits in every codeword, and one weak.
+    mode: 'NBFM',
+    stereo: false,
+    decoders: ['POCSAG'],
+    transmissions: [
+      {baud: 512, ampl: 1, inverted: 0, errors: 0, pages: [
+        {address: 1234567, func: 0, numeric: '5551234'},
+        {address: 1234570, func: 3, alpha: 'Call the office'}]},
+      {baud: 1200, ampl: 1, inverted: 1, errors: 1, pages: [
+        {address: 200000, func: 3, alpha: 'Testing the POCSAG decoder'},
+        {address: 200003, func: 0, numeric: '911-(2) 34'}]},
+      {baud: 2400, ampl: 1, inverted: 0, errors: 2, pages: [
+        {address: 33, func: 3, alpha: 'Two wrong bits in each codeword'},
+        {address: 7, func: 1}]},
+      {baud: 1200, ampl: 0.005, inverted: 0, errors: 0, pages: [
+        {address: 1999999, func: 3, alpha: 'A weak signal'}]}
+    ],
+    signal: function() {
+      return pocsagSignal(this.transmissions, 0.3);
+    },
+    seconds: function() {
+      return 9;
+    },
+    measure: function(audio, samples) {
+      var expected = [];
+      this.transmissions.forEach(function(tx) {
+        tx.pages.forEach(function(page) {
+          var content = page.numeric != null ? page.numeric : page.alpha;
+          expected.push(page.address + '/' + page.func + ': ' +
+                        (content || '(tone only)'));
+        });
+      });
+      var found = 0;
+      var wrong = 0;
+      audio.messages.forEach(function(msg) {
+        if (expected.indexOf(msg.text) >= 0) {
+          ++found;
+        } else {
+          ++wrong;
+        }
+      });
+      return [
+        {name: 'Decoded pages (%)', value: 100 * found / expected.length,
+         min: 100},
+        {name: 'Wrong pages', value: wrong, max: 0},
+        {name: 'POCSAG cost (%)', value: measureDecoderCost(
+             samples, 'NBFM', function(demodulator) {
+               demodulator.enableDecoder('POCSAG', true);
+             }), max: 10}
+      ];
+    }
+  },
+  'apt': {
+    // A weather satellite 3 kHz away from its frequency, for the Doppler
+    // shift, with a clock a bit faster than it should be. The first image
+    // has a gradient, and the second one has bars that move down the lines.
+    mode: 'APT',
+    rate: 256000,
+    stereo: false,
+    wordRate: 4160.2,
+    image: function(line, column) {
+      if (column < 1040) {
+        return column / 908;
+      }
+      return ((column + line * 8) >> 6) & 1 ? 0.8 : 0.2;
+    },
+    signal: function() {
+      return offsetSignal(
+          fmSignal(aptSignal(this.image, this.wordRate), 17000), 3000, 1);
+    },
+    seconds: function() {
+      return 8;
+    },
+    measure: function(audio) {
+      var SYNC_LENGTH = 39;
+      var lines = audio.imageLines;
+      // The first lines come before the synchronization is found. Each
+      // line is compared with the line sent at the same time, away from the
+      // edges of the bars, where the filters blur the image.
+      var error = 0;
+      var pixels = 0;
+      var misaligned = 0;
+      for (var i = 2; i < lines.length; ++i) {
+        var sync = 0;
+        for (var j = 0; j < SYNC_LENGTH; ++j) {
+          sync += lines[i][j] * (j >= 4 && j < 32 && !(j & 2) ? 1 : -1);
+        }
+        misaligned += sync > 0 ? 0 : 1;
+        for (var column = 0; column < 2080; ++column) {
+          var pos = column < 1040 ? column - 86 : column - 1126;
+          if (pos < 4 || pos >= 905 ||
+              (column >= 1040 && ((pos + 1040 + i * 8) & 63) < 4)) {
+            continue;
+          }
+          var expected = 255 * this.image(i, column - 86);
+          error += Math.abs(lines[i][column] - expected);
+          ++pixels;
+        }
+      }
+      var expectedLines = Math.floor(this.seconds() * this.wordRate / 2080);
+      return [
+        {name: 'Decoded lines', value: lines.length, min: expectedLines - 1},
+        {name: 'Misaligned lines', value: misaligned, max: 0},
+        {name: 'Average pixel error', value: error / pixels, max: 4}
+      ];
+    }
+  },
+  'ais': {
+    // Position reports, a static data report that takes two sentences, a
+    // base station report and a class B report, on both channels at the
+    // same time, some of them weak and off frequency.
+    mode: 'AIS',
+    // The radio always uses this rate for AIS.
+    rate: 1024000,
+    stereo: false,
+    interval: 0.1,
+    levels: [{ampl: 1, error: 0}, {ampl: 0.02, error: 1000},
+             {ampl: 1, error: -2000}, {ampl: 0.01, error: 500},
+             {ampl: 0.02, error: -1000}],
+    messages: [
+      ['!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C'],
+      ['!AIVDM,1,1,,A,15RTgt0PAso;90TKcjM8h6g208CQ,0*4A'],
+      ['!AIVDM,2,1,3,B,55P5TL01VIaAL@7WKO@mBplU@<PDhh000000001S;AJ::4A80?4i@E53,0*3E',
+       '!AIVDM,2,2,3,B,1@0000000000000,2*55'],
+      ['!AIVDM,1,1,,A,B6CdCm0t3`tba35f@V9faHi7kP06,0*58'],
+      ['!AIVDM,1,1,,B,403OviQuMGCqWrRO9>E6fE700@GO,0*4E']
+    ],
+    signal: function() {
+      var self = this;
+      function channel(name) {
+        return aisSignal(self.messages.filter(function(sentences) {
+          return sentences[0].split(',')[4] == name;
+        }), self.interval, self.levels);
+      }
+      return mixIQ([offsetSignal(channel('A'), -25000, 1),
+                    offsetSignal(channel('B'), 25000, 1)]);
+    },
+    seconds: function() {
+      return 4;
+    },
+    measure: function(audio, samples) {
+      // Each message is identified by its channel, payload and fill bits,
+      // since the sequential message ID of multi-sentence messages changes.
+      function key(sentences) {
+        var payload = '';
+        var fields = [];
+        for (var i = 0; i < sentences.length; ++i) {
+          var body = sentences[i].slice(1, sentences[i].indexOf('*'));
+          var checksum = 0;
+          for (var j = 0; j < body.length; ++j) {
+            checksum ^= body.charCodeAt(j);
+          }
+          if (parseInt(sentences[i].split('*')[1], 16) != checksum) {
+            return null;
+          }
+          fields = body.split(',');
+          payload += fields[5];
+        }
+        return fields[4] + payload + fields[6];
+      }
+      var expected = this.messages.map(key);
+      var found = 0;
+      var wrong = 0;
+      audio.messages.forEach(function(msg) {
+        if (expected.indexOf(key(msg.sentences)) >= 0) {
+          ++found;
+        } else {
+          ++wrong;
+        }
+      });
+      var sent = 2 * Math.floor(samples.length / 2 / inRate / this.interval);
+      return [
+        {name: 'Decoded messages (%)', value: 100 * found / sent, min: 95},
+        {name: 'Wrong messages', value: wrong, max: 0}
+      ];
+    }
+  },
+  'occupancy': {
+    // NBFM stations of very different strengths on 12.5 kHz channels, with
+    // an empty channel next to the strongest one, measured like the
+    // occupancy log does it. The stations are spread over the tuner's span
+    // at any sample rate.
+    mode: 'NBFM',
+    stereo: false,
+    step: 12500,
+    stations: function() {
+      var step = this.step;
+      function channel(fraction) {
+        return step * Math.round(fraction * inRate / step);
+      }
+      return [{offset: channel(-0.2), ampl: 0.5},
+              {offset: channel(0.1), ampl: 0.05},
+              {offset: channel(0.3), ampl: 0.005}];
+    },
+    signal: function() {
+      return mixIQ(this.stations().map(function(station) {
+        return offsetSignal(fmSignal(tone(1000, 1), 2500), station.offset,
+                            station.ampl);
+      }));
+    },
+    measure: function(audio, samples) {
+      var ext = iqtools.loadExtension();
+      var stations = this.stations();
+      var first = -this.step * Math.floor(0.4 * inRate / this.step);
+      var count = -2 * first / this.step + 1;
+      var offsets = [];
+      for (var i = 0; i < count; ++i) {
+        offsets.push(first + i * this.step);
+      }
+      var blockBytes = iqtools.getBlockSize(inRate) * 2;
+      var sums = new Float64Array(count);
+      var blocks = 0;
+      var time = 0;
+      for (var pos = 0; pos + blockBytes <= samples.length;
+           pos += blockBytes) {
+        var IQ = ext.iqSamplesFromUint8(
+            samples.slice(pos, pos + blockBytes).buffer, inRate);
+        var start = process.hrtime();
+        var powers = ext.measureChannelPowers(
+            IQ[0], IQ[1], inRate, offsets, this.step).powers;
+        var t = process.hrtime(start);
+        time += t[0] + t[1] / 1e9;
+        for (var i = 0; i < count; ++i) {
+          sums[i] += powers[i];
+        }
+        ++blocks;
+      }
+      var step = this.step;
+      function level(offset) {
+        return sums[Math.round((offset - first) / step)] / blocks;
+      }
+      var error = 0;
+      stations.forEach(function(station) {
+        error = Math.max(error, Math.abs(
+            level(station.offset) - dB(station.ampl * CARRIER_LEVEL)));
+      });
+      return [
+        {name: 'Level error (dB)', value: error, max: 0.5},
+        {name: 'Adjacent channel (dB)',
+         value: level(stations[0].offset + step) - level(stations[0].offset),
+         max: -40},
+        // The app measures the channels once a second.
+        {name: 'Cost at one measurement per second (%)',
+         value: 100 * time / blocks, max: 2}
+      ];
+    }
+  },
+  'iq-imbalance': {
+    // A weak NBFM station 100 kHz below the center frequency, and a strong
+    // one 100 kHz above it, whose mirror image falls on the weak one.
+    mode: 'NBFM',
+    stereo: false,
+    offset: -100000,
+    imbalance: {dcI: 0.02, dcQ: -0.015, gain: 1.05, phase: 3},
+    signal: function() {
+      return mixIQ([
+        offsetSignal(fmSignal(tone(1000, 1), 2500), -100000, 0.03),
+        offsetSignal(fmSignal(tone(1700, 1), 2500), 100000, 0.9)
+      ]);
+    },
+    measure: function(audio, samples) {
+      var m = measureTones(audio.left, [1000, 1700]);
+      var cost = measureCorrectionCost(samples);
+      return [
+        {name: 'Mirror image (dB)', value: dB(m.ampl[1] / m.ampl[0]),
+         max: -30},
+        {name: 'SNR (dB)', value: m.snr, min: 20},
+        {name: 'Plain conversion (ns/sample)', value: cost.plain, max: 20},
+        {name: 'Corrected conversion (ns/sample)', value: cost.corrected,
+         max: 20},
+        {name: 'Correction cost (ns/sample)',
+         value: cost.corrected - cost.plain, max: 2}
+      ];
+    }
+  }
+};
+
+/**
+ * Measures how much longer it takes to convert the tuner's samples while
+ * correcting their DC offset and I/Q imbalance than with the plain
+ * conversion, iqSamplesFromUint8.
+ * @param {Uint8Array} samples The samples to convert.
+ * @return {{plain:number,corrected:number}} The time per sample of each
+ *     conversion, in nanoseconds.
+ */
+function measureCorrectionCost(samples) {
+  var ext = iqtools.loadExtension();
+  var blockBytes = iqtools.getBlockSize(inRate) * 2;
+  var blocks = [];
+  for (var pos = 0; pos + blockBytes <= samples.length; pos += blockBytes) {
+    blocks.push(samples.slice(pos, pos + blockBytes).buffer);
+  }
+  var corrector = new ext.IQCorrector();
+  function time(convert) {
+    var start = process.hrtime();
+    for (var i = 0; i < blocks.length; ++i) {
+      convert(blocks[i]);
+    }
+    var t = process.hrtime(start);
+    return t[0] * 1e9 + t[1];
+  }
+  function correct(block) {
+    corrector.convert(block, 0, 0, -100000);
+  }
+  function plain(block) {
+    ext.iqSamplesFromUint8(block, inRate);
+  }
+  // Alternate both conversions, so they run under the same conditions.
+  var bestCorrected = Infinity;
+  var bestUncorrected = Infinity;
+  for (var round = 0; round < 10; ++round) {
+    bestCorrected = Math.min(bestCorrected, time(correct));
+    bestUncorrected = Math.min(bestUncorrected, time(plain));
+  }
+  var count = blocks.length * blockBytes / 2;
+  return {plain: bestUncorrected / count, corrected: bestCorrected / count};
+}
+
+/**
+ * Measures how much longer it takes to demodulate a signal when decoding
+ * its data, like RDS or APRS, than without decoding it.
+ * @param {Uint8Array} samples The samples to demodulate.
+ * @param {string} modeName The mode to demodulate.
+ * @param {function(Object)} enable A function that enables the decoding
+ *     in a demodulator.
+ * @return {number} The extra time, as a percentage.
+ */
+function measureDecoderCost(samples, modeName, enable) {
+  var ext = iqtools.loadExtension();
+  var mode = iqtools.getMode(modeName);
+  var blockBytes = iqtools.getBlockSize(inRate) * 2;
+  var blocks = [];
+  for (var pos = 0; pos + blockBytes <= samples.length; pos += blockBytes) {
+    blocks.push(ext.iqSamplesFromUint8(
+        samples.slice(pos, pos + blockBytes).buffer, inRate));
+  }
+  var withRds = ext.createDemodulator(mode, inRate, OUT_RATE);
+  var withoutRds = ext.createDemodulator(mode, inRate, OUT_RATE);
+  enable(withRds);
+  function time(demodulator, block) {
+    var start = process.hrtime();
+    demodulator.demodulate(block[0], block[1], false);
+    var t = process.hrtime(start);
+    return t[0] * 1e9 + t[1];
+  }
+  // Alternate both demodulators block by block, and keep the best time for
+  // each block, so that pauses for garbage collection don't count.
+  var bestWith = [];
+  var bestWithout = [];
+  for (var round = 0; round < 10; ++round) {
+    for (var i = 0; i < blocks.length; ++i) {
+      var tWith = time(withRds, blocks[i]);
+      var tWithout = time(withoutRds, blocks[i]);
+      bestWith[i] = Math.min(tWith, round ? bestWith[i] : Infinity);
+      bestWithout[i] = Math.min(tWithout, round ? bestWithout[i] : Infinity);
+    }
+  }
+  bestWith = bestWith.reduce(function(a, b) { return a + b; });
+  bestWithout = bestWithout.reduce(function(a, b) { return a + b; });
+  return 100 * (bestWith / bestWithout - 1);
+}
+
+/**
+ * Measures how fast a mode is demodulated.
+ * @param {Object} mode The mode.
+ * @param {number} offset The frequency of the signal to demodulate.
+ * @param {boolean} inStereo Whether to decode stereo.
+ * @param {Uint8Array} samples The samples to demodulate, over and over.
+ * @param {number} seconds How many seconds of signal to demodulate.
+ * @return {number} The speed, as a multiple of real time.
+ */
+function measureSpeed(mode, offset, inStereo, samples, seconds) {
+  var ext = iqtools.loadExtension();
+  var decoder = new iqtools.StreamDecoder(mode, inRate, offset, inStereo);
+  // Modes that take the tuner's bytes directly get them, like in the app.
+  var demodulator = ext.createDemodulator(mode, inRate, OUT_RATE);
+  var demodulateBlock = demodulator.demodulateRaw ?
+      demodulator.demodulateRaw :
+      function(block) {
+        decoder.process(ext.iqSamplesFromUint8(block, inRate));
+      };
+  var blockBytes = iqtools.getBlockSize(inRate) * 2;
+  var blocks = [];
+  for (var pos = 0; pos + blockBytes <= samples.length; pos += blockBytes) {
+    blocks.push(samples.slice(pos, pos + blockBytes).buffer);
+  }
+  var count = Math.ceil(seconds * inRate * 2 / blockBytes);
+  var start = process.hrtime();
+  for (var i = 0; i < count; ++i) {
+    demodulateBlock(blocks[i % blocks.length]);
+  }
+  var time = process.hrtime(start);
+  return count * blockBytes / 2 / inRate / (time[0] + time[1] / 1e9);
+}
+
+/**
+ * Formats a number for the report.
+ * @param {number} value The number.
+ * @return {string} The formatted number.
+ */
+function format(value) {
+  return value.toFixed(1);
+}
+
+/**
+ * Runs the test cases and prints a report.
+ * @param {Array.<string>} names The names of the cases to run.
+ * @param {number} seconds How many seconds of signal to decode to measure
+ *     the speed.
+ * @return {boolean} Whether all the measurements were within thresholds.
+ */
+function run(names, seconds) {
+  var ok = true;
+  var defaultRate = inRate;
+  for (var i = 0; i < names.length; ++i) {
+    var test = CASES[names[i]];
+    inRate = test.rate || defaultRate;
+    var mode = iqtools.getMode(test.mode);
+    var length = test.seconds ? test.seconds() : SETTLE_SECONDS + MEASURE_SECONDS;
+    var offset = test.offset || 0;
+    var noiseLevel = test.rate ? NOISE_LEVEL :
+        NOISE_LEVEL * Math.sqrt(inRate / 1024000);
+    var samples = synthesize(test.signal(), length, noiseLevel,
+                             test.imbalance);
+    var results = test.measure(
+        demodulate(mode, samples, offset, test.stereo, test.rds,
+                   test.decoders),
+        samples);
+    console.log(names[i] + ':');
+    for (var j = 0; j < results.length; ++j) {
+      var r = results[j];
+      var pass = r.min != null ? r.value >= r.min : r.value <= r.max;
+      ok = ok && pass;
+      console.log('  ' + (pass ? 'PASS ' : 'FAIL ') + r.name + ': ' +
+                  format(r.value) + (r.min != null ? ' >= ' + r.min
+                                                   : ' <= ' + r.max));
+    }
+    var speed = measureSpeed(mode, offset, test.stereo, samples, seconds);
+    console.log('  Speed: ' + format(speed) + 'x real time, ' +
+                (speed * inRate / 1e6).toFixed(2) + ' MS/s');
+  }
+  return ok;
+}
+
+var seconds = 10;
+var names = [];
+process.argv.slice(2).forEach(function(arg) {
+  var match = arg.match(/^--(seconds|rate)=(.*)$/);
+  if (match && match[1] == 'seconds') {
+    seconds = Number(match[2]);
+  } else if (match) {
+    inRate = Number(match[2]);
+  } else if (CASES[arg]) {
+    names.push(arg);
+  } else {
+    console.error('Unknown case: ' + arg + '. The cases are: ' +
+                  Object.keys(CASES).join(', '));
+    process.exit(1);
+  }
+});
+if (!run(names.length ? names : Object.keys(CASES), seconds)) {
+  console.log('Some measurements are out of bounds.');
+  process.exitCode = 1;
+}
@@ -0,0 +1,457 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview A minimal FLAC encoder for 16-bit stereo audio.
+ *
+ * Every frame is encoded with the fixed predictor (order 0 to 4) that gives
+ * the smallest residual for each channel, and the residual is Rice coded
+ * in a single partition. Silent channels are encoded as constants. The
+ * stereo channels are stored either independently or as left and side,
+ * whichever is smaller. That gets most of the compression of the
+ * reference encoder for demodulated audio, at a fraction of the code.
+ */
+
+var fs = require('fs');
+var copyFile = require('./iqtools.js').copyFile;
+
+var BLOCK_SIZE = 4096;
+var MAX_RICE_PARAM = 14;
+
+/**
+ * Writes bits into a growable byte buffer, most significant bit first.
+ * @constructor
+ */
+function BitWriter() {
+  var bytes = new Uint8Array(65536);
+  var length = 0;
+  var acc = 0;
+  var accBits = 0;
+
+  /**
+   * Writes an unsigned value.
+   * @param {number} value The value to write.
+   * @param {number} bits The number of bits to write, up to 24.
+   */
+  function write(value, bits) {
+    acc = (acc << bits) | (value & ((1 << bits) - 1));
+    accBits += bits;
+    while (accBits >= 8) {
+      accBits -= 8;
+      pushByte((acc >>> accBits) & 0xff);
+    }
+    acc &= (1 << accBits) - 1;
+  }
+
+  /**
+   * Writes an unsigned value of up to 48 bits.
+   * @param {number} value The value to write.
+   * @param {number} bits The number of bits to write.
+   */
+  function writeLong(value, bits) {
+    while (bits > 24) {
+      bits -= 24;
+      write(Math.floor(value / Math.pow(2, bits)) & 0xffffff, 24);
+    }
+    write(value % Math.pow(2, bits), bits);
+  }
+
+  /**
+   * Writes a value in unary: that many zero bits and then a one.
+   * @param {number} value The value to write.
+   */
+  function writeUnary(value) {
+    while (value >= 16) {
+      write(0, 16);
+      value -= 16;
+    }
+    write(1, value + 1);
+  }
+
+  /**
+   * Pads the output with zero bits until the next byte boundary.
+   */
+  function align() {
+    if (accBits > 0) {
+      write(0, 8 - accBits);
+    }
+  }
+
+  function pushByte(b) {
+    if (length == bytes.length) {
+      var newBytes = new Uint8Array(bytes.length * 2);
+      newBytes.set(bytes);
+      bytes = newBytes;
+    }
+    bytes[length++] = b;
+  }
+
+  /**
+   * Returns the bytes written so far. The writer must be byte-aligned.
+   * @return {Uint8Array} The bytes.
+   */
+  function getBytes() {
+    return bytes.subarray(0, length);
+  }
+
+  return {
+    write: write,
+    writeLong: writeLong,
+    writeUnary: writeUnary,
+    align: align,
+    getBytes: getBytes
+  };
+}
+
+var CRC8_TABLE = makeCrcTable(0x07, 8);
+var CRC16_TABLE = makeCrcTable(0x8005, 16);
+
+function makeCrcTable(poly, bits) {
+  var table = new Uint16Array(256);
+  var top = 1 << (bits - 1);
+  var mask = (1 << bits) - 1;
+  for (var i = 0; i < 256; ++i) {
+    var crc = i << (bits - 8);
+    for (var j = 0; j < 8; ++j) {
+      crc = (crc & top) ? ((crc << 1) ^ poly) : (crc << 1);
+    }
+    table[i] = crc & mask;
+  }
+  return table;
+}
+
+function crc8(bytes) {
+  var crc = 0;
+  for (var i = 0; i < bytes.length; ++i) {
+    crc = CRC8_TABLE[crc ^ bytes[i]];
+  }
+  return crc;
+}
+
+function crc16(bytes) {
+  var crc = 0;
+  for (var i = 0; i < bytes.length; ++i) {
+    crc = ((crc << 8) & 0xffff) ^ CRC16_TABLE[(crc >> 8) ^ bytes[i]];
+  }
+  return crc;
+}
+
+/**
+ * Computes the residual of a fixed predictor.
+ * @param {Int32Array} samples The samples.
+ * @param {number} order The predictor's order, from 0 to 4.
+ * @param {Int32Array} out The array for the residual. The first 'order'
+ *     elements are not used.
+ */
+function fixedResidual(samples, order, out) {
+  var n = samples.length;
+  var s = samples;
+  for (var i = order; i < n; ++i) {
+    switch (order) {
+      case 0: out[i] = s[i]; break;
+      case 1: out[i] = s[i] - s[i - 1]; break;
+      case 2: out[i] = s[i] - 2 * s[i - 1] + s[i - 2]; break;
+      case 3: out[i] = s[i] - 3 * s[i - 1] + 3 * s[i - 2] - s[i - 3]; break;
+      case 4: out[i] = s[i] - 4 * s[i - 1] + 6 * s[i - 2] - 4 * s[i - 3] +
+                       s[i - 4]; break;
+    }
+  }
+}
+
+/**
+ * Finds the best Rice parameter for a residual.
+ * @param {Int32Array} residual The residual.
+ * @param {number} start The first element to code.
+ * @return {{param:number,bits:number}} The parameter and the number of
+ *     bits it takes to code the residual.
+ */
+function bestRiceParam(residual, start) {
+  var sum = 0;
+  for (var i = start; i < residual.length; ++i) {
+    var r = residual[i];
+    sum += r < 0 ? -2 * r - 1 : 2 * r;
+  }
+  var count = residual.length - start;
+  var best = {param: 0, bits: Infinity};
+  var guess = Math.max(0, Math.floor(Math.log(sum / count + 1) / Math.LN2) - 1);
+  for (var k = Math.max(0, guess - 1);
+       k <= Math.min(MAX_RICE_PARAM, guess + 2); ++k) {
+    var bits = count * (k + 1);
+    for (var i = start; i < residual.length; ++i) {
+      var r = residual[i];
+      bits += (r < 0 ? -2 * r - 1 : 2 * r) >>> k;
+    }
+    if (bits < best.bits) {
+      best = {param: k, bits: bits};
+    }
+  }
+  return best;
+}
+
+/**
+ * Chooses how to encode a channel.
+ * @param {Int32Array} samples The channel's samples.
+ * @param {number} bps The number of bits per sample.
+ * @return {Object} The encoding and its size in bits.
+ */
+function planSubframe(samples, bps) {
+  var constant = true;
+  for (var i = 1; i < samples.length && constant; ++i) {
+    constant = samples[i] == samples[0];
+  }
+  if (constant) {
+    return {type: 'constant', bits: 8 + bps};
+  }
+  var best = null;
+  var maxOrder = Math.min(4, samples.length - 1);
+  for (var order = 0; order <= maxOrder; ++order) {
+    var residual = new Int32Array(samples.length);
+    fixedResidual(samples, order, residual);
+    var rice = bestRiceParam(residual, order);
+    var bits = 8 + order * bps + 10 + rice.bits;
+    if (!best || bits < best.bits) {
+      best = {type: 'fixed', order: order, residual: residual,
+              param: rice.param, bits: bits};
+    }
+  }
+  var verbatimBits = 8 + samples.length * bps;
+  if (verbatimBits <= best.bits) {
+    return {type: 'verbatim', bits: verbatimBits};
+  }
+  return best;
+}
+
+/**
+ * Writes a channel's subframe.
+ * @param {BitWriter} out The writer.
+ * @param {Int32Array} samples The channel's samples.
+ * @param {number} bps The number of bits per sample.
+ * @param {Object} plan The encoding returned by planSubframe.
+ */
+function writeSubframe(out, samples, bps, plan) {
+  if (plan.type == 'constant') {
+    out.write(0, 8);
+    out.write(samples[0], bps);
+  } else if (plan.type == 'verbatim') {
+    out.write(2, 8);
+    for (var i = 0; i < samples.length; ++i) {
+      out.write(samples[i], bps);
+    }
+  } else {
+    out.write((8 | plan.order) << 1, 8);
+    for (var i = 0; i < plan.order; ++i) {
+      out.write(samples[i], bps);
+    }
+    out.write(0, 2);  // Rice coding with a 4-bit parameter
+    out.write(0, 4);  // partition order 0
+    out.write(plan.param, 4);
+    var k = plan.param;
+    var residual = plan.residual;
+    for (var i = plan.order; i < residual.length; ++i) {
+      var r = residual[i];
+      var u = r < 0 ? -2 * r - 1 : 2 * r;
+      out.writeUnary(u >>> k);
+      if (k > 0) {
+        out.write(u & ((1 << k) - 1), k);
+      }
+    }
+  }
+}
+
+/**
+ * Writes the frame number as a UTF-8-like variable-length integer.
+ * @param {BitWriter} out The writer.
+ * @param {number} value The frame number.
+ */
+function writeUtf8(out, value) {
+  if (value < 0x80) {
+    out.write(value, 8);
+    return;
+  }
+  var extra = value < 0x800 ? 1 : value < 0x10000 ? 2 :
+              value < 0x200000 ? 3 : value < 0x4000000 ? 4 : 5;
+  var lead = (0xff00 >> (extra + 1)) & 0xff;
+  out.write(lead | Math.floor(value / Math.pow(2, 6 * extra)), 8);
+  for (var i = extra - 1; i >= 0; --i) {
+    out.write(0x80 | (Math.floor(value / Math.pow(2, 6 * i)) & 0x3f), 8);
+  }
+}
+
+/**
+ * Encodes a frame of stereo samples.
+ * @param {Int32Array} left The left channel's samples.
+ * @param {Int32Array} right The right channel's samples.
+ * @param {number} frameNumber The frame's number.
+ * @return {Uint8Array} The encoded frame.
+ */
+function encodeFrame(left, right, frameNumber) {
+  var n = left.length;
+  var side = new Int32Array(n);
+  for (var i = 0; i < n; ++i) {
+    side[i] = left[i] - right[i];
+  }
+  var leftPlan = planSubframe(left, 16);
+  var rightPlan = planSubframe(right, 16);
+  var sidePlan = planSubframe(side, 17);
+  var useSide = sidePlan.bits < rightPlan.bits;
+
+  var out = new BitWriter();
+  out.write(0xfff8, 16);                // sync code, fixed block size
+  out.write(0x7, 4);                    // block size in 16 bits at the end
+  out.write(0x0, 4);                    // sample rate from STREAMINFO
+  out.write(useSide ? 0x8 : 0x1, 4);    // left/side or independent
+  out.write(0x4, 3);                    // 16 bits per sample
+  out.write(0, 1);
+  writeUtf8(out, frameNumber);
+  out.write(n - 1, 16);
+  out.write(crc8(out.getBytes()), 8);
+
+  writeSubframe(out, left, 16, leftPlan);
+  if (useSide) {
+    writeSubframe(out, side, 17, sidePlan);
+  } else {
+    writeSubframe(out, right, 16, rightPlan);
+  }
+  out.align();
+  out.write(crc16(out.getBytes()), 16);
+  return out.getBytes();
+}
+
+/**
+ * A class to write a 16-bit stereo FLAC file, with the same methods as
+ * the WAV writer in iqtools.js.
+ *
+ * If opt_firstSample is set, it writes just the frames without a header,
+ * numbered as if they started at that sample, so the file can later be
+ * added to a complete FLAC file with appendPart(). Since frames have a
+ * fixed size, opt_firstSample must be a multiple of BLOCK_SIZE.
+ * @param {string} fileName The name of the file to write.
+ * @param {number} rate The sample rate.
+ * @param {number=} opt_firstSample The position of the first sample in the
+ *     complete file, to write a part of a FLAC file.
+ * @constructor
+ */
+function FlacWriter(fileName, rate, opt_firstSample) {
+  var isPart = opt_firstSample != null;
+  if (isPart && opt_firstSample % BLOCK_SIZE != 0) {
+    throw new Error('A part of a FLAC file must start at a multiple of ' +
+                    BLOCK_SIZE + ' samples');
+  }
+  var fd = fs.openSync(fileName, 'w');
+  var pendingLeft = new Int32Array(BLOCK_SIZE);
+  var pendingRight = new Int32Array(BLOCK_SIZE);
+  var pendingLength = 0;
+  var frameNumber = isPart ? opt_firstSample / BLOCK_SIZE : 0;
+  var totalSamples = 0;
+  var position = 0;
+
+  if (!isPart) {
+    writeBytes(createHeader());
+  }
+
+  /**
+   * Creates the FLAC signature and the STREAMINFO block.
+   * @return {Uint8Array} The header.
+   */
+  function createHeader() {
+    var out = new BitWriter();
+    out.write(0x664c, 16);        // "fL"
+    out.write(0x6143, 16);        // "aC"
+    out.write(0x80, 8);           // last metadata block, STREAMINFO
+    out.write(34, 24);
+    out.write(BLOCK_SIZE, 16);    // minimum block size
+    out.write(BLOCK_SIZE, 16);    // maximum block size
+    out.write(0, 24);             // minimum frame size, unknown
+    out.write(0, 24);             // maximum frame size, unknown
+    out.write(rate, 20);
+    out.write(1, 3);              // 2 channels
+    out.write(15, 5);             // 16 bits per sample
+    out.writeLong(totalSamples, 36);
+    for (var i = 0; i < 16; ++i) {
+      out.write(0, 8);            // no MD5 signature
+    }
+    return out.getBytes();
+  }
+
+  function writeBytes(bytes) {
+    fs.writeSync(fd, bytes, 0, bytes.length, position);
+    position += bytes.length;
+  }
+
+  function flush() {
+    if (pendingLength == 0) {
+      return;
+    }
+    writeBytes(encodeFrame(pendingLeft.subarray(0, pendingLength),
+                           pendingRight.subarray(0, pendingLength),
+                           frameNumber++));
+    pendingLength = 0;
+  }
+
+  /**
+   * Writes a block of samples.
+   * @param {Float32Array} left The samples for the left channel.
+   * @param {Float32Array} right The samples for the right channel.
+   */
+  function writeSamples(left, right) {
+    for (var i = 0; i < left.length; ++i) {
+      pendingLeft[pendingLength] =
+          Math.floor(Math.max(-1, Math.min(1, left[i])) * 32767);
+      pendingRight[pendingLength] =
+          Math.floor(Math.max(-1, Math.min(1, right[i])) * 32767);
+      if (++pendingLength == BLOCK_SIZE) {
+        flush();
+      }
+    }
+    totalSamples += left.length;
+  }
+
+  /**
+   * Adds the frames in a file written with opt_firstSample set. All the
+   * samples written before must fill complete frames.
+   * @param {string} partName The name of the file with the frames.
+   * @param {number} samples The number of samples in the file.
+   */
+  function appendPart(partName, samples) {
+    if (pendingLength != 0) {
+      throw new Error('A part of a FLAC file must start at a frame boundary');
+    }
+    position += copyFile(partName, fd, position, fs.statSync(partName).size);
+    frameNumber += Math.ceil(samples / BLOCK_SIZE);
+    totalSamples += samples;
+  }
+
+  /**
+   * Writes the last frame and updates the header.
+   */
+  function finish() {
+    flush();
+    if (!isPart) {
+      var header = createHeader();
+      fs.writeSync(fd, header, 0, header.length, 0);
+    }
+    fs.closeSync(fd);
+  }
+
+  return {
+    writeSamples: writeSamples,
+    appendPart: appendPart,
+    finish: finish
+  };
+}
+
+module.exports = {
+  BLOCK_SIZE: BLOCK_SIZE,
+  FlacWriter: FlacWriter
+};
@@ -0,0 +1,398 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview Functions to use Radio Receiver's demodulators from Node,
+ * to read I/Q recordings, and to write WAV files.
+ */
+
+var fs = require('fs');
+var path = require('path');
+var vm = require('vm');
+
+var EXTENSION_DIR = path.join(__dirname, '..', 'extension');
+var EXTENSION_SCRIPTS = [
+  'dsp.js',
+  'rds.js',
+  'adsb.js',
+  'hdlc.js',
+  'aprs.js',
+  'pocsag.js',
+  'apt.js',
+  'ais.js',
+  'demodulator-am.js',
+  'demodulator-ssb.js',
+  'demodulator-nbfm.js',
+  'demodulator-wbfm.js',
+  'demodulator-adsb.js',
+  'demodulator-apt.js',
+  'demodulator-ais.js',
+  'demodulators.js',
+  'frequencies.js',
+  'bandsimulator.js'
+];
+
+var OUT_RATE = 48000;
+var BUFS_PER_SEC = 5;
+
+/**
+ * Loads the extension's DSP code into the global scope, the same way the
+ * demodulator worker does it with importScripts().
+ * @return {Object} The global object, to find the loaded functions.
+ */
+function loadExtension() {
+  if (!global.createDemodulator) {
+    for (var i = 0; i < EXTENSION_SCRIPTS.length; ++i) {
+      var file = path.join(EXTENSION_DIR, EXTENSION_SCRIPTS[i]);
+      vm.runInThisContext(fs.readFileSync(file, 'utf8'), {filename: file});
+    }
+  }
+  return global;
+}
+
+/**
+ * Returns the mode with the given name, with some settings overridden.
+ * @param {string} name The mode's name: WBFM, NBFM, AM, LSB, USB, ADSB,
+ *     APT or AIS.
+ * @param {Object=} opt_settings The settings to override (bandwidth, maxF).
+ * @return {Object} The mode.
+ */
+function getMode(name, opt_settings) {
+  var defaults = loadExtension().DefaultModes[name];
+  if (!defaults) {
+    throw new Error('Unknown mode: ' + name);
+  }
+  var mode = {};
+  for (var key in defaults) {
+    mode[key] = defaults[key];
+  }
+  for (var key in opt_settings || {}) {
+    if (opt_settings[key] != null) {
+      mode[key] = opt_settings[key];
+    }
+  }
+  return mode;
+}
+
+/**
+ * Opens an I/Q recording. It can be a raw file of unsigned 8-bit samples,
+ * a capture file saved by Radio Receiver (RRIQ), or a 16-bit stereo WAV
+ * file with I in the left channel and Q in the right.
+ * @param {string} fileName The name of the file.
+ * @param {number} defaultRate The sample rate of a raw file.
+ * @return {Object} An object with the file's sample rate, center frequency
+ *     (0 if unknown), number of samples, and a read() function.
+ */
+function openInput(fileName, defaultRate) {
+  var fd = fs.openSync(fileName, 'r');
+  var size = fs.fstatSync(fd).size;
+  var head = Buffer.alloc(Math.min(size, 65536));
+  fs.readSync(fd, head, 0, head.length, 0);
+
+  var format = 'u8';
+  var rate = defaultRate;
+  var frequency = 0;
+  var dataStart = 0;
+  var dataEnd = size;
+
+  if (head.length >= 64 && head.readUInt32LE(0) == 0x51495252) {
+    rate = head.readUInt32LE(12);
+    dataStart = head.readUInt32LE(8);
+    dataEnd = head.readDoubleLE(24) || size;
+    frequency = head.readDoubleLE(40);
+  } else if (head.length >= 12 && head.toString('ascii', 0, 4) == 'RIFF' &&
+             head.toString('ascii', 8, 12) == 'WAVE') {
+    format = 's16';
+    var pos = 12;
+    while (pos + 8 <= head.length) {
+      var id = head.toString('ascii', pos, pos + 4);
+      var len = head.readUInt32LE(pos + 4);
+      if (id == 'fmt ') {
+        if (head.readUInt16LE(pos + 8) != 1 || head.readUInt16LE(pos + 10) != 2 ||
+            head.readUInt16LE(pos + 22) != 16) {
+          throw new Error(fileName + ' is not a 16-bit stereo WAV file');
+        }
+        rate = head.readUInt32LE(pos + 12);
+      } else if (id == 'auxi') {
+        frequency = head.readUInt32LE(pos + 8 + 32);
+      } else if (id == 'data') {
+        dataStart = pos + 8;
+        dataEnd = Math.min(size, dataStart + len);
+        break;
+      }
+      pos += 8 + len + (len & 1);
+    }
+  }
+
+  var bytesPerSample = format == 'u8' ? 2 : 4;
+  var count = Math.floor((dataEnd - dataStart) / bytesPerSample);
+
+  /**
+   * Reads a range of samples.
+   * @param {number} start The first sample to read.
+   * @param {number} length The number of samples to read.
+   * @return {Array.<Float32Array>} The I and Q components. They are shorter
+   *     than requested at the end of the file.
+   */
+  function read(start, length) {
+    length = Math.max(0, Math.min(length, count - start));
+    var buffer = Buffer.alloc(length * bytesPerSample);
+    fs.readSync(fd, buffer, 0, buffer.length, dataStart + start * bytesPerSample);
+    if (format == 'u8') {
+      var bytes = buffer.buffer.slice(buffer.byteOffset,
+                                      buffer.byteOffset + buffer.length);
+      return loadExtension().iqSamplesFromUint8(bytes, rate);
+    }
+    var I = new Float32Array(length);
+    var Q = new Float32Array(length);
+    for (var i = 0; i < length; ++i) {
+      I[i] = buffer.readInt16LE(4 * i) / 32768;
+      Q[i] = buffer.readInt16LE(4 * i + 2) / 32768;
+    }
+    return [I, Q];
+  }
+
+  function close() {
+    fs.closeSync(fd);
+  }
+
+  return {
+    format: format,
+    rate: rate,
+    frequency: frequency,
+    count: count,
+    read: read,
+    close: close
+  };
+}
+
+/**
+ * A class to write a 16-bit stereo WAV file at 48 kHz.
+ *
+ * If opt_part is set, it writes just the samples without a header, so the
+ * file can later be added to a complete WAV file with appendPart().
+ * @param {string} fileName The name of the file to write.
+ * @param {number=} opt_rate The sample rate, 48000 by default.
+ * @param {boolean=} opt_part Whether to write a part of a WAV file.
+ * @constructor
+ */
+function WavWriter(fileName, opt_rate, opt_part) {
+  var rate = opt_rate || OUT_RATE;
+  var fd = fs.openSync(fileName, 'w');
+  var headerSize = opt_part ? 0 : 44;
+  var dataSize = 0;
+
+  writeHeader();
+
+  function writeHeader() {
+    if (opt_part) {
+      return;
+    }
+    var header = Buffer.alloc(44);
+    header.write('RIFF', 0, 'ascii');
+    header.writeUInt32LE(36 + dataSize, 4);
+    header.write('WAVEfmt ', 8, 'ascii');
+    header.writeUInt32LE(16, 16);
+    header.writeUInt16LE(1, 20);
+    header.writeUInt16LE(2, 22);
+    header.writeUInt32LE(rate, 24);
+    header.writeUInt32LE(rate * 4, 28);
+    header.writeUInt16LE(4, 32);
+    header.writeUInt16LE(16, 34);
+    header.write('data', 36, 'ascii');
+    header.writeUInt32LE(dataSize, 40);
+    fs.writeSync(fd, header, 0, 44, 0);
+  }
+
+  /**
+   * Writes a block of samples.
+   * @param {Float32Array} left The samples for the left channel.
+   * @param {Float32Array} right The samples for the right channel.
+   */
+  function writeSamples(left, right) {
+    var out = Buffer.alloc(left.length * 4);
+    for (var i = 0; i < left.length; ++i) {
+      out.writeInt16LE(
+          Math.floor(Math.max(-1, Math.min(1, left[i])) * 32767), 4 * i);
+      out.writeInt16LE(
+          Math.floor(Math.max(-1, Math.min(1, right[i])) * 32767), 4 * i + 2);
+    }
+    fs.writeSync(fd, out, 0, out.length, headerSize + dataSize);
+    dataSize += out.length;
+  }
+
+  /**
+   * Adds the samples in a file written with opt_part set.
+   * @param {string} partName The name of the file with the samples.
+   * @param {number} samples The number of samples in the file.
+   */
+  function appendPart(partName, samples) {
+    var bytes = samples * 4;
+    dataSize += copyFile(partName, fd, headerSize + dataSize, bytes);
+  }
+
+  /**
+   * Updates the header and closes the file.
+   */
+  function finish() {
+    writeHeader();
+    fs.closeSync(fd);
+  }
+
+  return {
+    writeSamples: writeSamples,
+    appendPart: appendPart,
+    finish: finish
+  };
+}
+
+/**
+ * Copies the contents of a file into another, open file.
+ * @param {string} fromName The name of the file to copy.
+ * @param {number} toFd The descriptor of the file to copy into.
+ * @param {number} position The position to copy the contents to.
+ * @param {number} length The number of bytes to copy.
+ * @return {number} The number of bytes copied.
+ */
+function copyFile(fromName, toFd, position, length) {
+  var fromFd = fs.openSync(fromName, 'r');
+  var buffer = Buffer.alloc(1 << 20);
+  var copied = 0;
+  while (copied < length) {
+    var read = fs.readSync(fromFd, buffer, 0,
+                           Math.min(buffer.length, length - copied), copied);
+    if (read == 0) {
+      break;
+    }
+    fs.writeSync(toFd, buffer, 0, read, position + copied);
+    copied += read;
+  }
+  fs.closeSync(fromFd);
+  return copied;
+}
+
+/**
+ * A class that demodulates a stream of I/Q samples the same way the
+ * demodulator worker does it.
+ * @param {Object} mode The mode to demodulate.
+ * @param {number} inRate The sample rate of the I/Q samples.
+ * @param {number} offset The frequency of the signal to demodulate,
+ *     relative to the center frequency.
+ * @param {boolean} inStereo Whether to decode stereo signals.
+ * @param {number=} opt_startSample The position in the recording of the
+ *     first sample to be decoded, so the frequency shift continues with the
+ *     same phase as if the recording was decoded from the beginning.
+ * @constructor
+ */
+function StreamDecoder(mode, inRate, offset, inStereo, opt_startSample) {
+  var ext = loadExtension();
+  var demodulator = ext.createDemodulator(mode, inRate, OUT_RATE);
+  var corrector = new ext.IQCorrector();
+  var start = opt_startSample || 0;
+  var cycles = (offset * Math.floor(start / inRate)) % 1 +
+               offset * (start % inRate) / inRate;
+  var cosine = Math.cos(2 * Math.PI * cycles);
+  var sine = -Math.sin(2 * Math.PI * cycles);
+
+  /**
+   * Demodulates a block of samples, after correcting their DC offset and
+   * I/Q imbalance in place.
+   * @param {Array.<Float32Array>} IQ The I and Q components.
+   * @return {{left:Float32Array,right:Float32Array,rds:Object,messages:Array.<Object>,imageLines:Array.<Uint8Array>}}
+   *     The audio, the RDS information if it is being decoded, the
+   *     messages decoded by digital modes, and the lines decoded by image
+   *     modes.
+   */
+  function process(IQ) {
+    corrector.correct(IQ[0], IQ[1], offset);
+    if (offset != 0) {
+      IQ = ext.shiftFrequency(IQ, -offset, inRate, cosine, sine);
+      cosine = IQ[2];
+      sine = IQ[3];
+    }
+    var out = demodulator.demodulate(IQ[0], IQ[1], inStereo);
+    return {
+      left: new Float32Array(out.left),
+      right: new Float32Array(out.right),
+      rds: out.rds,
+      messages: out.messages,
+      imageLines: out.imageLines
+    };
+  }
+
+  /**
+   * Enables or disables decoding the RDS signal, if the mode has one.
+   * @param {boolean} enable Whether to decode the RDS signal.
+   */
+  function enableRds(enable) {
+    if (demodulator.enableRds) {
+      demodulator.enableRds(enable);
+    }
+  }
+
+  /**
+   * Enables or disables a decoder for the data sent in the audio, if the
+   * mode supports it.
+   * @param {string} name The decoder's name, such as 'APRS' or 'POCSAG'.
+   * @param {boolean} enable Whether to run the decoder.
+   */
+  function enableDecoder(name, enable) {
+    if (demodulator.enableDecoder) {
+      demodulator.enableDecoder(name, enable);
+    }
+  }
+
+  return {
+    process: process,
+    enableRds: enableRds,
+    enableDecoder: enableDecoder
+  };
+}
+
+/**
+ * Returns the number of audio samples the demodulator outputs for a block
+ * of I/Q samples. It only depends on the block's length, so every full
+ * block gives the same number of audio samples.
+ * @param {Object} mode The mode to demodulate.
+ * @param {number} inRate The sample rate of the I/Q samples.
+ * @param {number} length The number of I/Q samples in the block.
+ * @return {number} The number of audio samples.
+ */
+function getOutputLength(mode, inRate, length) {
+  var demodulator = loadExtension().createDemodulator(mode, inRate, OUT_RATE);
+  var zeros = new Float32Array(length);
+  return demodulator.demodulate(zeros, zeros, false).left.byteLength / 4;
+}
+
+/**
+ * Returns the number of samples in each block given to the demodulator,
+ * which is the same as in the app: a fifth of a second.
+ * @param {number} rate The sample rate.
+ * @return {number} The number of samples per block.
+ */
+function getBlockSize(rate) {
+  return Math.floor(rate / BUFS_PER_SEC);
+}
+
+module.exports = {
+  OUT_RATE: OUT_RATE,
+  loadExtension: loadExtension,
+  getMode: getMode,
+  openInput: openInput,
+  WavWriter: WavWriter,
+  copyFile: copyFile,
+  StreamDecoder: StreamDecoder,
+  getOutputLength: getOutputLength,
+  getBlockSize: getBlockSize
+};
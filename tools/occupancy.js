@@ -0,0 +1,126 @@
+#!/usr/bin/env node
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview Prints how busy each channel was in an occupancy log, over
+ * a range of time, using the same reader as the app.
+ *
+ * Usage: node occupancy.js [options] file
+ *
+ * Options:
+ *   --from=TIME       The start of the range, as a date and time that
+ *                     JavaScript can parse (the start of the log).
+ *   --to=TIME         The end of the range (the end of the log).
+ *   --hours=N         The length of the range, if --to is not given.
+ *   --threshold=DB    The power above which a channel is busy, in dB
+ *                     relative to full scale (-60).
+ *
+ * Only the records in the range are read, so it's fast even for logs of
+ * several weeks.
+ */
+
+var fs = require('fs');
+var path = require('path');
+var vm = require('vm');
+
+var options = {
+  from: null,
+  to: null,
+  hours: null,
+  threshold: -60
+};
+var file = null;
+process.argv.slice(2).forEach(function(arg) {
+  var match = arg.match(/^--([a-z]+)=(.*)$/);
+  if (match && match[1] in options) {
+    options[match[1]] = match[2];
+  } else if (!match) {
+    file = arg;
+  } else {
+    console.error('Unknown option: ' + arg);
+    process.exit(1);
+  }
+});
+if (!file) {
+  console.error('Usage: node occupancy.js [options] file');
+  process.exit(1);
+}
+
+/**
+ * The part of the browser's FileReader that the log reader uses, on top of
+ * Node's Blob.
+ * @constructor
+ */
+global.FileReader = function() {
+  var reader = this;
+  this.readAsArrayBuffer = function(blob) {
+    blob.arrayBuffer().then(function(buffer) {
+      reader.result = buffer;
+      reader.onload();
+    }, function(error) {
+      reader.error = error;
+      reader.onerror();
+    });
+  };
+};
+
+var script = path.join(__dirname, '..', 'extension', 'occupancy.js');
+vm.runInThisContext(fs.readFileSync(script, 'utf8'), {filename: script});
+
+fs.openAsBlob(file).then(function(blob) {
+  var reader = new OccupancyLogReader(blob);
+  reader.setOnError(function(msg) {
+    console.error(msg);
+    process.exit(1);
+  });
+  reader.open(function() {
+    var range = reader.getTimeRange();
+    var from = options.from ? Date.parse(options.from) : range.start;
+    var to = options.to ? Date.parse(options.to) :
+             options.hours ? from + 3600000 * Number(options.hours) :
+             range.end + 1;
+    var threshold = Number(options.threshold);
+    reader.query(from, to, threshold, function(result) {
+      console.log(result.records + ' measurements from ' +
+                  new Date(from).toISOString() + ' to ' +
+                  new Date(to).toISOString() + ', every ' +
+                  reader.getInterval() + ' ms');
+      console.log('Frequency (MHz)  Busy (%)  Average (dB)  Highest (dB)');
+      for (var i = 0; i < result.channels.length; ++i) {
+        var c = result.channels[i];
+        if (c.measured == 0) {
+          continue;
+        }
+        console.log(pad((c.frequency / 1e6).toFixed(4), 15) +
+                    pad((100 * c.occupancy).toFixed(1), 10) +
+                    pad(c.averagePower.toFixed(1), 14) +
+                    pad(c.highestPower.toFixed(1), 14));
+      }
+    });
+  });
+});
+
+/**
+ * Pads a string with spaces on the left.
+ * @param {string} str The string.
+ * @param {number} width The width to pad it to.
+ * @return {string} The padded string.
+ */
+function pad(str, width) {
+  while (str.length < width) {
+    str = ' ' + str;
+  }
+  return str;
+}
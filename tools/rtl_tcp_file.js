@@ -0,0 +1,110 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * A stand-in for rtl_tcp that serves a recorded file instead of a dongle,
+ * to test Radio Receiver's network tuner without any hardware.
+ *
+ * Usage: node rtl_tcp_file.js <file> [port]
+ *
+ * The file can be raw unsigned 8-bit I/Q samples (like the ones saved by
+ * rtl_sdr) or a capture file saved by Radio Receiver. The samples are sent
+ * in a loop, at the sample rate requested by the client. The commands the
+ * client sends are printed, but otherwise ignored.
+ */
+
+var fs = require('fs');
+var net = require('net');
+
+var CHUNKS_PER_SEC = 20;
+var COMMANDS = {
+  1: 'frequency',
+  2: 'sample rate',
+  3: 'gain mode',
+  4: 'gain',
+  5: 'frequency correction'
+};
+
+var fileName = process.argv[2];
+var port = Number(process.argv[3]) || 1234;
+if (!fileName) {
+  console.error('Usage: node rtl_tcp_file.js <file> [port]');
+  process.exit(1);
+}
+
+var samples = loadSamples(fileName);
+console.log('Serving ' + samples.length / 2 + ' samples on port ' + port);
+
+/**
+ * Loads the samples in a file, skipping the header and the index if it's
+ * a Radio Receiver capture file.
+ * @param {string} name The file's name.
+ * @return {Buffer} The samples.
+ */
+function loadSamples(name) {
+  var data = fs.readFileSync(name);
+  if (data.length >= 64 && data.readUInt32LE(0) == 0x51495252) {
+    var headerSize = data.readUInt32LE(8);
+    var indexOffset = data.readDoubleLE(24);
+    return data.slice(headerSize, indexOffset || data.length);
+  }
+  return data;
+}
+
+net.createServer(function(socket) {
+  console.log('Client connected from ' + socket.remoteAddress);
+  var rate = 1024000;
+  var position = 0;
+  var pending = Buffer.alloc(0);
+
+  var header = Buffer.alloc(12);
+  header.write('RTL0', 0, 'ascii');
+  header.writeUInt32BE(5, 4);   // R820T
+  header.writeUInt32BE(29, 8);  // gain steps
+  socket.write(header);
+
+  var timer = setInterval(function() {
+    var bytes = 2 * Math.floor(rate / CHUNKS_PER_SEC);
+    var chunk = Buffer.alloc(bytes);
+    for (var done = 0; done < bytes;) {
+      var n = Math.min(bytes - done, samples.length - position);
+      samples.copy(chunk, done, position, position + n);
+      done += n;
+      position = (position + n) % samples.length;
+    }
+    socket.write(chunk);
+  }, 1000 / CHUNKS_PER_SEC);
+
+  socket.on('data', function(data) {
+    pending = Buffer.concat([pending, data]);
+    while (pending.length >= 5) {
+      var cmd = pending[0];
+      var param = pending.readInt32BE(1);
+      pending = pending.slice(5);
+      console.log('Set ' + (COMMANDS[cmd] || 'command ' + cmd) + ': ' + param);
+      if (cmd == 2) {
+        rate = param;
+      }
+    }
+  });
+
+  socket.on('close', function() {
+    console.log('Client disconnected');
+    clearInterval(timer);
+  });
+
+  socket.on('error', function() {
+    clearInterval(timer);
+  });
+}).listen(port);
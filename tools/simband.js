@@ -0,0 +1,96 @@
+#!/usr/bin/env node
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @fileoverview Writes the output of the band simulator to a raw file of
+ * unsigned 8-bit I/Q samples, and measures how fast it generates them.
+ *
+ * Usage: node simband.js [options] file
+ *
+ * Options:
+ *   --frequency=F   The center frequency (88.7M).
+ *   --rate=N        The sample rate (1024000).
+ *   --seconds=N     The length of the recording (10).
+ *   --noise=DB      The noise level, in dB relative to full scale (-45).
+ *   --ppm=N         A simulated crystal error, in parts per million (0).
+ *   --stations=S    The stations, like "88.5M WBFM -20, 162.4M NBFM -40".
+ *
+ * The file can be decoded with batchdecode.js, using --rate.
+ */
+
+var fs = require('fs');
+var iqtools = require('./iqtools.js');
+
+var options = {
+  frequency: '88.7M',
+  rate: 1024000,
+  seconds: 10,
+  noise: -45,
+  ppm: 0,
+  stations: null
+};
+var file = null;
+process.argv.slice(2).forEach(function(arg) {
+  var match = arg.match(/^--([a-z]+)=(.*)$/);
+  if (match && match[1] in options) {
+    options[match[1]] = match[2];
+  } else if (!match) {
+    file = arg;
+  } else {
+    console.error('Unknown option: ' + arg);
+    process.exit(1);
+  }
+});
+if (!file) {
+  console.error('Usage: node simband.js [options] file');
+  process.exit(1);
+}
+
+var ext = iqtools.loadExtension();
+var stations = ext.parseSimulatedStations(
+    options.stations || ext.DEFAULT_SIMULATED_STATIONS);
+var rate = Number(options.rate);
+var simulator = new ext.BandSimulator(stations, 0, {
+  noise: Number(options.noise),
+  ppmError: Number(options.ppm)
+});
+var blockSize = iqtools.getBlockSize(rate);
+var blocks = Math.ceil(Number(options.seconds) * rate / blockSize);
+var fd = fs.openSync(file, 'w');
+var generateTime = 0;
+
+simulator.setSampleRate(rate, function() {
+simulator.setCenterFrequency(
+    ext.Frequencies.parseReadableInput(options.frequency), function() {
+simulator.resetBuffer(function() {
+  var written = 0;
+  function next() {
+    if (written == blocks) {
+      fs.closeSync(fd);
+      var seconds = blocks * blockSize / rate;
+      var stats = simulator.getStats();
+      console.log(stats.stations + ' stations, ' + seconds.toFixed(1) +
+                  ' s of signal generated at ' + (1 / stats.load).toFixed(1) +
+                  'x real time');
+      return;
+    }
+    simulator.readSamples(blockSize, function(buffer) {
+      fs.writeSync(fd, new Uint8Array(buffer));
+      ++written;
+      next();
+    });
+  }
+  next();
+})})});